@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+
+// Burst result for one analog channel
+struct AdcChannelResult {
+    int pin;
+    int raw;        // averaged raw counts (ADC_RESOLUTION_BITS wide)
+    int millivolts; // calibrated millivolts of the averaged sample
+    bool valid;
+};
+
+// Shared ADC acquisition service for the analog sensors.
+//
+// Each analog sensor registers its pin once and requests a sample when its
+// conversion starts. The first poll after a request triggers one burst that
+// samples every registered channel together and serves every channel requested
+// so far, so sensors started together share a burst. A channel requested later
+// (e.g. a power-gated probe that was still warming up) gets a burst of its own
+// and never receives a sample taken before its request.
+// On Arduino-ESP32 3.x the burst runs on the continuous (DMA) ADC driver and
+// the calibrated mV conversion is applied once per channel to the averaged
+// raw value; older cores fall back to back-to-back oneshot reads.
+class AdcSampler {
+public:
+    static constexpr size_t MAX_CHANNELS = 4;
+
+    // Register a pin and return its channel slot (-1 when all slots are taken)
+    int registerPin(int pin);
+
+    // Request a sample of this channel from the next burst
+    bool requestBurst(int slot);
+    // Non-blocking poll; starts the burst if needed and returns true once the
+    // channel's result (valid or failed) is available
+    bool poll(int slot);
+    // Fetch the channel result; consumes it
+    bool take(int slot, AdcChannelResult &out);
+
+    // True when a registered pin is on ADC2, which the classic ESP32 cannot
+    // sample while WiFi is on (the radio driver owns that unit)
+    bool usesRadioAdc() const;
+
+private:
+    int pins_[MAX_CHANNELS] = {};
+    AdcChannelResult results_[MAX_CHANNELS] = {};
+    bool requested_[MAX_CHANNELS] = {}; // waiting for the next burst
+    bool inBurst_[MAX_CHANNELS] = {};   // served by the burst in flight
+    bool ready_[MAX_CHANNELS] = {};     // result available, not yet taken
+    size_t count_ = 0;
+    bool running_ = false;
+    unsigned long burstStartMs_ = 0;
+    bool configured_ = false;
+
+    void beginBurst();
+    void deliver(size_t i, int raw, int millivolts, bool valid);
+    bool startBurst();
+    bool finishBurst();
+};
+
+// Single sampler instance shared by every analog sensor
+AdcSampler& sharedAdcSampler();
@@ -1,10 +1,11 @@
 #pragma once
 #include <Arduino.h>
 #include "storage.h"
+#include "http_session.h"
 
 class AuthManager {
 public:
-  AuthManager(Storage &storage, const char* baseUrl, const char* uuid, const char* secret, unsigned long retryIntervalMs = 30000);
+  AuthManager(Storage &storage, HttpSession &http, const char* uuid, const char* secret, unsigned long retryIntervalMs = 30000);
   void begin();
   // Try authenticate once immediately (blocking network call)
   bool tryAuthenticateOnce();
@@ -18,7 +19,7 @@ public:
 
 private:
   Storage &storage;
-  const char* baseUrl;
+  HttpSession &http;
   const char* uuid;
   const char* secret;
   unsigned long retryIntervalMs;
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+struct SensorReading; // forward declaration (defined in data_sender.h)
+
+// Fixed-buffer CBOR (RFC 8949) encoder for the sensor data payloads. The maps
+// mirror the JSON payloads in json_payload.h, with the same text keys:
+//   {"sensors":[{"uuid":<uuid>,"value":<value>},...]}
+//   {"now":<s>,"uuids":[<uuid>,...],"batch":[{"ts":<s>,"values":[<v>,...]},...]}
+// A canonical UUID string (8-4-4-4-12 hex) is sent as tag 37 + 16-byte byte
+// string, any other identifier as a text string. Values are rounded to 2
+// decimals like the JSON text, then written as an integer when whole, a half
+// float when that is exact, otherwise a single float; NaN, infinities and
+// magnitudes above 1e15 are null. Definite lengths only.
+
+// Map header + "sensors" key + array header (count < 65536)
+constexpr size_t CBOR_PAYLOAD_ENVELOPE = 12;
+// Longest value: single float (0xfa + 4 bytes) or 32-bit integer
+constexpr size_t CBOR_VALUE_MAX_SIZE = 5;
+
+// Upper bound of one encoded uuid: text string header + characters (the
+// tagged byte string of a canonical UUID is 19 bytes, shorter than its text)
+constexpr size_t cborUuidMaxSize(const char* uuid) {
+    size_t n = 0;
+    while (uuid[n]) ++n;
+    return 3 + n;
+}
+
+// Upper bound of one reading: map header, "uuid" and "value" keys, uuid, value
+constexpr size_t cborReadingMaxSize(const char* uuid) {
+    return 12 + cborUuidMaxSize(uuid) + CBOR_VALUE_MAX_SIZE;
+}
+
+// Map header, "now" + uint32, "uuids" and "batch" keys, two array headers
+constexpr size_t CBOR_BATCH_ENVELOPE = 28;
+
+// Upper bound of one cycle: map header, "ts" + uint32, "values" + array header, values
+constexpr size_t cborBatchCycleMaxSize(size_t sensorCount) {
+    return 19 + sensorCount * CBOR_VALUE_MAX_SIZE;
+}
+
+// Serialize readings into out. No heap is used. Returns the number of bytes
+// written, or 0 if the payload does not fit in outSize.
+size_t serializeReadingsCbor(const SensorReading* readings, size_t count,
+                             uint8_t* out, size_t outSize);
+
+// Serialize cycleCount cycles; values is row-major (cycleCount x sensorCount).
+// "now" is null when nowKnown is false. Same return convention as
+// serializeReadingsCbor.
+size_t serializeBatchCbor(bool nowKnown, uint32_t now, const char* const* uuids, size_t sensorCount,
+                          const uint32_t* timestamps, const float* values, size_t cycleCount,
+                          uint8_t* out, size_t outSize);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "sensor.h" // SensorConfig is defined in the sensor API header
+#include "payload_encoding.h"
 //#include "Test-Device-2.h" // Device-specific credentials + sensor list
 #include "Test-Device-LoRa-Battery.h" // Device-specific credentials + sensor list
 
@@ -11,6 +12,10 @@ constexpr const char* BASE_URL       = "https://agronos.kalogeitonas.xyz";
 constexpr const char* AP_SSID = "ESP_Config";
 constexpr const char* AP_PASS = ""; // optional
 
+// How long the portal stays open after a cold boot when the saved network is
+// unreachable, before the readings are queued and the device sleeps
+constexpr unsigned long PORTAL_TIMEOUT_MS = 5UL * 60UL * 1000UL;
+
 // Button configuration
 constexpr unsigned long BUTTON_LONG_PRESS_MS = 10000; // 10 seconds to trigger reset
 
@@ -42,6 +47,76 @@ constexpr int DHT11_PIN = 21;
 // non-blocking read interval
 constexpr unsigned long SENSORS_READ_INTERVAL_MS = 10 * 60 * 1000; // 10 minutes
 
+// Reading batch (WiFi firmware): readings are kept in RTC memory and uploaded
+// together every N wake cycles (DeviceConfig::uploadEveryCycles, 1 = upload
+// every reading); WiFi stays off on the cycles in between
+constexpr uint8_t UPLOAD_EVERY_CYCLES = 1;
+constexpr size_t READING_BATCH_MAX_CYCLES = 12;     // oldest cycle dropped beyond this
+// Default wire format of uploads (DeviceConfig::payloadEncoding): JSON, the
+// compressed time-series codec for batches (ts_codec.h, about a third of the
+// JSON size) or CBOR (cbor_payload.h, no float-to-text conversion)
+constexpr PayloadEncoding PAYLOAD_ENCODING = PayloadEncoding::Json;
+
+// Sensors read and uploaded (DeviceConfig::sensorMask): bit i enables
+// SENSOR_CONFIGS[i]; a device whose entries are all disabled is not powered
+static_assert(SENSOR_CONFIG_COUNT <= 32, "DeviceConfig::sensorMask holds at most 32 sensors");
+constexpr uint32_t SENSOR_MASK_ALL = SENSOR_CONFIG_COUNT == 32 ? 0xFFFFFFFFu : (1u << SENSOR_CONFIG_COUNT) - 1;
+
+// Offline queue (WiFi firmware): cycles that could not be uploaded are kept in
+// LittleFS and uploaded oldest first, one segment per request, after the next
+// successful send
+constexpr size_t OFFLINE_QUEUE_MAX_SEGMENTS = 64;        // READING_BATCH_MAX_CYCLES cycles each; oldest dropped beyond this
+constexpr size_t OFFLINE_QUEUE_DRAIN_PER_WAKE = 4;       // segment uploads per wake, bounds awake time
+
+// Always-on mode (DeviceConfig::alwaysOn, for mains-powered devices): no deep
+// sleep; the loop task reads the sensors every ALWAYS_ON_SAMPLE_INTERVAL_MS
+// and a service task publishes the cycles over one long-lived MQTT session
+constexpr bool ALWAYS_ON = false;
+constexpr unsigned long ALWAYS_ON_SAMPLE_INTERVAL_MS = 500;  // slower sensors stretch the period to their acquisition time;
+                                                             // ones with a minimum read interval repeat their last values
+constexpr size_t ALWAYS_ON_QUEUE_CYCLES = 64;                // sampled cycles waiting to be published (power of two)
+constexpr unsigned long ALWAYS_ON_STATS_INTERVAL_MS = 60000; // [LIVE] counters
+
+// WiFi station connect (wifi_connect.h): a directed connect to the cached
+// BSSID/channel with the last DHCP lease as static IP, scan + DHCP as fallback
+constexpr unsigned long WIFI_CONNECT_TIMEOUT_MS = 10000;     // scan + DHCP connect
+constexpr unsigned long WIFI_FAST_CONNECT_TIMEOUT_MS = 1500; // before falling back to a scan
+constexpr uint16_t WIFI_LEASE_REFRESH_EVERY = 48;            // fast connects between DHCP renewals (8 h at 10 min)
+
+// TLS session cache (tls_client.h): sessions of the last servers kept in RTC
+// memory so the next wake resumes instead of running a full handshake. With
+// CONFIG_MBEDTLS_SSL_KEEP_PEER_CERTIFICATE (IDF default) a session carries the
+// server certificate; without it a session is about 200 bytes.
+constexpr size_t TLS_SESSION_CACHE_SLOTS = 2;               // HTTPS backend + MQTT broker
+constexpr size_t TLS_SESSION_MAX_SIZE = 1536;               // serialized session, bytes
+constexpr unsigned long TLS_HANDSHAKE_TIMEOUT_MS = 10000;   // also the read timeout of a record
+
+// DNS cache (dns_cache.h): addresses of the backend and broker host names kept
+// in RTC memory. lwIP does not report the record TTL, so entries use this fixed
+// lifetime; a connect failure on a cached address forces a new lookup anyway.
+constexpr size_t DNS_CACHE_SLOTS = 2;                       // BASE_URL host + MQTT server
+constexpr uint32_t DNS_CACHE_TTL_S = 6 * 3600;
+
+// Transport selection (transport_policy.h): a transport failing this many
+// sends in a row is skipped and re-probed every N sends, N doubling per failed
+// probe (a blocked MQTT port costs one connect timeout per probe, not per wake)
+constexpr uint8_t TRANSPORT_DEMOTE_AFTER_FAILURES = 2;
+constexpr uint16_t TRANSPORT_REPROBE_EVERY = 6;
+constexpr uint16_t TRANSPORT_REPROBE_MAX = 48;
+
+// Upper bound for one device's conversion, counted from its start() (after warm-up)
+constexpr unsigned long SENSOR_ACQUISITION_TIMEOUT_MS = 3000;
+
+// Minimum settle time after power-on, applied to sensors with a powerPin
+// (SensorConfig::warmupMs can only lengthen it)
+constexpr unsigned long DHT11_WARMUP_MS = 1000;         // datasheet: 1 s before the first transfer
+constexpr unsigned long DHT20_WARMUP_MS = 100;          // datasheet: 100 ms before the status check
+constexpr unsigned long SOIL_MOISTURE_WARMUP_MS = 200;  // SEN0193 oscillator + output RC filter
+
+// Minimum time between two transfers of a sensor; a device due sooner reports
+// its last values again (see acquireSensors)
+constexpr unsigned long DHT11_MIN_READ_INTERVAL_MS = 1000; // datasheet: sampling period >= 1 s
+
 // Auth manager
 constexpr unsigned long AUTH_RETRY_INTERVAL_MS = 30000;
 
@@ -54,27 +129,74 @@ constexpr bool MQTT_ENABLED = true;
 constexpr uint16_t AGRONOS_MQTT_PORT = 1883;              // 8883 for TLS, 1883 for plain
 constexpr bool AGRONOS_MQTT_USE_TLS = false;              // Use secure connection
 constexpr uint16_t AGRONOS_MQTT_KEEPALIVE = 60;          // Keep-alive interval (seconds)
-constexpr uint16_t AGRONOS_MQTT_RECONNECT_DELAY = 5000;  // Reconnection delay (ms)
-constexpr bool AGRONOS_MQTT_CLEAN_SESSION = true;        // Start with clean session
+constexpr uint16_t AGRONOS_MQTT_RECONNECT_DELAY = 5000;  // Reconnection delay (ms), doubled per failure
+constexpr unsigned long AGRONOS_MQTT_RECONNECT_MAX_DELAY = 5UL * 60UL * 1000UL; // Backoff cap (ms)
+constexpr bool AGRONOS_MQTT_CLEAN_SESSION = false;       // Keep the broker session across connects
+constexpr bool AGRONOS_MQTT_V5 = true;                   // MQTT 5 (3.1.1 if the broker refuses it)
+constexpr uint32_t AGRONOS_MQTT_SESSION_EXPIRY_S = 86400; // MQTT 5: broker keeps the session after disconnect
+
+// In-tree MQTT client (mqtt_connection.h)
+constexpr unsigned long MQTT_CONNECT_TIMEOUT_MS = 5000;  // CONNECT until CONNACK
+constexpr unsigned long MQTT_ACK_TIMEOUT_MS = 5000;      // QoS 1 publish until PUBACK
+constexpr size_t MQTT_INFLIGHT_WINDOW = 4;               // QoS 1 publishes sent before the first PUBACK
+constexpr size_t MQTT_TOPIC_ALIAS_SLOTS = 4;             // MQTT 5 topic aliases per connection
+constexpr size_t MQTT_TOPIC_MAX_LEN = 128;
+constexpr size_t MQTT_INFLIGHT_MAX_PAYLOAD = 1024;       // largest buffered QoS 1 payload; streamed ones are not kept
+constexpr size_t MQTT_RX_BUFFER_SIZE = 256;              // largest incoming packet body kept
 
 // MQTT topics (will be formatted with device UUID)
 // Use topics matching broker ACL: devices/<username>/# so EMQX allows publishes
 constexpr const char* AGRONOS_MQTT_TOPIC_DATA = "devices/%s/sensors";
+constexpr const char* AGRONOS_MQTT_TOPIC_DATA_TS = "devices/%s/sensors/ts"; // binary time-series batches
+constexpr const char* AGRONOS_MQTT_TOPIC_DATA_CBOR = "devices/%s/sensors/cbor";
 constexpr const char* AGRONOS_MQTT_TOPIC_STATUS = "devices/%s/status";
 constexpr const char* AGRONOS_MQTT_TOPIC_COMMAND = "devices/%s/commands";
+constexpr const char* AGRONOS_MQTT_TOPIC_COMMAND_ACK = "devices/%s/commands/ack";
 
 // MQTT QoS levels
 constexpr int AGRONOS_MQTT_QOS_DATA = 1;      // At least once for sensor data
 constexpr int AGRONOS_MQTT_QOS_STATUS = 0;    // Fire and forget for status
+constexpr int AGRONOS_MQTT_QOS_COMMAND = 1;   // Commands and their acks (queued by the broker while asleep)
+
+// Remote configuration commands (device_command.h)
+constexpr unsigned long MQTT_COMMAND_WINDOW_MS = 50;      // listen before deep sleep for commands queued by the broker
+constexpr size_t MQTT_COMMAND_QUEUE = 4;                  // commands received but not yet applied; more stay unacknowledged at the broker
+constexpr size_t DEVICE_COMMAND_ID_LEN = 40;              // longest command id + 1
+constexpr unsigned long COMMAND_MIN_READ_INTERVAL_MS = 10UL * 1000UL;
+constexpr unsigned long COMMAND_MAX_READ_INTERVAL_MS = 24UL * 3600UL * 1000UL;
 
 // NOTE: MQTT server, username, and password are fetched dynamically 
 // from the backend using the JWT token after HTTP authentication.
+constexpr size_t MQTT_SERVER_MAX_LEN = 96;                // stored credential buffers (Storage), incl. NUL
+constexpr size_t MQTT_USERNAME_MAX_LEN = 64;
+constexpr size_t MQTT_PASSWORD_MAX_LEN = 128;
+constexpr size_t WIFI_SSID_MAX_LEN = 33;                  // 802.11 limits, incl. NUL
+constexpr size_t WIFI_PASS_MAX_LEN = 65;
+constexpr size_t BASE_URL_MAX_LEN = 128;
+constexpr size_t AUTH_TOKEN_MAX_LEN = 768;               // login response token
 // ============================================================
 
+// ADC burst sampling shared by the analog sensors (see adc_sampler.h)
+constexpr int ADC_RESOLUTION_BITS = 12;
+constexpr int ADC_BURST_SAMPLES = 32;                 // conversions per channel per burst
+constexpr int ADC_BURST_TRIM = ADC_BURST_SAMPLES / 4; // samples dropped at each end (oneshot path)
+constexpr unsigned long ADC_SAMPLING_FREQ_HZ = 20000; // continuous mode rate (ESP32 minimum is 20 kHz)
+constexpr unsigned long ADC_BURST_TIMEOUT_MS = 50;
+
 // Soil moisture sensor calibration (SEN0193)
 constexpr int SOIL_MOISTURE_AIR_VALUE = 2941;    // Dry
 constexpr int SOIL_MOISTURE_WATER_VALUE = 1324;  // Wet
 
+// Reading filters across wake cycles (signal_filter.h). The EMA alphas apply
+// per SENSORS_READ_INTERVAL_MS and are scaled to the actual time between
+// samples, so always-on sampling smooths over the same time span.
+constexpr float SOIL_MOISTURE_MAX_STEP = 15.0f;   // % per reading before it counts as an outlier
+constexpr uint8_t SOIL_MOISTURE_CONFIRMATIONS = 2; // outliers in a row accepted as a real change (irrigation)
+constexpr float SOIL_MOISTURE_EMA_ALPHA = 0.6f;
+constexpr float BATTERY_MAX_STEP = 10.0f;          // % per reading
+constexpr uint8_t BATTERY_CONFIRMATIONS = 3;       // charger plugged in / battery swapped
+constexpr float BATTERY_EMA_ALPHA = 0.3f;
+
 // ==================== LoRa CONFIGURATION (TTGO LoRa32 V2.1) ====================
 #ifdef LORA_NODE
 
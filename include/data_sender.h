@@ -2,6 +2,9 @@
 
 #include <Arduino.h>
 #include "storage.h"
+#include "http_session.h"
+#include "config.h"
+#include "json_payload.h"
 
 // Forward declaration
 class MqttClient;
@@ -11,14 +14,33 @@ struct SensorReading {
     float value;
 };
 
+// Largest single-cycle payload the configured sensors can produce
+constexpr size_t readingsPayloadCapacity() {
+    size_t n = JSON_PAYLOAD_ENVELOPE;
+    for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) n += jsonReadingMaxSize(SENSOR_CONFIGS[i].uuid);
+    return n;
+}
+
+// Largest batch payload (READING_BATCH_MAX_CYCLES cycles)
+constexpr size_t batchPayloadCapacity() {
+    size_t n = JSON_BATCH_ENVELOPE + READING_BATCH_MAX_CYCLES * jsonBatchCycleMaxSize(SENSOR_CONFIG_COUNT);
+    for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) n += jsonBatchUuidMaxSize(SENSOR_CONFIGS[i].uuid);
+    return n;
+}
+
+// Size of the payload buffer shared by the MQTT and HTTP paths
+constexpr size_t DATA_PAYLOAD_MAX_SIZE =
+    readingsPayloadCapacity() > batchPayloadCapacity() ? readingsPayloadCapacity() : batchPayloadCapacity();
+
 class DataSender {
 public:
-    DataSender(Storage &storage, const char* baseUrl);
+    DataSender(Storage &storage, HttpSession &http);
 
     // Set MQTT client for MQTT support (optional)
     void setMqttClient(MqttClient* client);
 
-    // Send an array of SensorReading { uuid, value }
+    // Send an array of SensorReading { uuid, value } as JSON, or as CBOR when
+    // that is the configured encoding
     bool sendReadings(const SensorReading* readings, size_t count);
 
     // Send values paired with explicit UUIDs
@@ -27,11 +49,63 @@ public:
     // Backwards-compatible helper that uses SENSOR_UUIDS from config.h
     bool sendValues(const float* values, size_t count);
 
+    // Send the cycles stored in the RTC reading batch (reading_batch.h) in one
+    // payload; `now` is the device clock (seconds) the timestamps refer to.
+    // The batch is left untouched; clear it after a successful send.
+    bool sendBatch(uint32_t now);
+
+    // Send stored cycles (row-major, SENSOR_CONFIG_COUNT values each) as one
+    // batch payload in the configured encoding (DeviceConfig::payloadEncoding);
+    // now is omitted (null / flag cleared) when nowKnown is false
+    bool sendCycles(const uint32_t* timestamps, const float* values, size_t cycles,
+                    bool nowKnown, uint32_t now);
+
+    // Pipelined upload of several payloads over one MQTT connection: sends
+    // between beginPipeline() and endPipeline() that go out over MQTT return
+    // once the publish is in flight instead of waiting for its PUBACK (HTTP
+    // sends stay synchronous). endPipeline() waits for the acknowledgements
+    // and returns how many of those sends, in order, are confirmed delivered.
+    void beginPipeline();
+    size_t endPipeline();
+
+    // The last failed send never reached the backend: there was no link, or
+    // every transport tried failed to open its connection (DNS, no route,
+    // TCP connect timeout). HTTP errors, rejected credentials and payloads
+    // that were never sent leave it false.
+    bool serverUnreachable() const { return unreachable; }
+
 private:
     Storage &storage;
-    const char* baseUrl;
+    HttpSession &http;
     MqttClient* mqttClient; // Optional MQTT client
 
-    String buildUrl() const;
-    bool postJson(const String &json, const String &token);
+    static const size_t PIPELINE_MAX_SENDS = OFFLINE_QUEUE_DRAIN_PER_WAKE; // later sends wait for their PUBACK
+    bool pipelining;
+    bool pipelineConnected;  // the pipeline opened the MQTT connection
+    size_t pipelineSends;    // successful sends since beginPipeline()
+    uint16_t pipelineIds[PIPELINE_MAX_SENDS]; // MQTT packet id per send, 0 = already confirmed
+
+    // JSON payload of the send in progress. It is streamed from the encoder
+    // over MQTT and only rendered into the payload buffer for HTTP.
+    struct JsonSource {
+        const SensorReading* readings; // {"sensors":[...]}, or nullptr for a batch
+        size_t count;
+        bool nowKnown;
+        uint32_t now;
+        const char* const* uuids;
+        const uint32_t* timestamps;
+        const float* values;
+        size_t cycles;
+    };
+    JsonSource json;
+    bool jsonPending;        // json is the payload of the send in progress (see sendJson)
+    bool unreachable;        // see serverUnreachable()
+    bool connectFailed;      // the last sendViaMqtt/sendViaHttp could not open a connection
+
+    size_t streamJson(JsonChunkWriter write, void* ctx) const;
+    bool postPayload(const char* body, size_t len, const char* contentType, const String &token);
+    bool sendJson(const JsonSource& source);
+    bool sendPayload(size_t len, PayloadEncoding encoding);
+    bool sendViaMqtt(size_t len, const char* binaryTopic);
+    bool sendViaHttp(size_t len, const char* contentType);
 };
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "storage.h"
+
+// Remote configuration update received on AGRONOS_MQTT_TOPIC_COMMAND, e.g.
+//
+//   {"id":"frost-0412","read_interval_ms":60000,"upload_every_cycles":1,
+//    "transport":"mqtt","sensor_mask":5}
+//
+// "id" (string or number) is required, every setting is optional but at least
+// one must be given. A command is applied whole or not at all: one invalid or
+// unknown field rejects it. The outcome is published on
+// AGRONOS_MQTT_TOPIC_COMMAND_ACK (writeCommandAck).
+
+// DeviceCommand::fields bits
+constexpr uint8_t COMMAND_READ_INTERVAL = 0x01;
+constexpr uint8_t COMMAND_UPLOAD_EVERY = 0x02;
+constexpr uint8_t COMMAND_TRANSPORT = 0x04;
+constexpr uint8_t COMMAND_SENSOR_MASK = 0x08;
+
+struct DeviceCommand {
+    char id[DEVICE_COMMAND_ID_LEN]; // letters, digits and -_.: only; echoed in the ack
+    uint8_t fields;                 // COMMAND_* settings present
+    unsigned long readIntervalMs;
+    uint8_t uploadEveryCycles;
+    bool mqttEnabled;               // "transport": "mqtt" or "http"
+    uint32_t sensorMask;            // bit i enables SENSOR_CONFIGS[i]
+    const char* error;              // why it is rejected, nullptr while valid
+};
+
+// Parse a command payload; a malformed one gets cmd.error (and is still acked)
+void parseDeviceCommand(const uint8_t* payload, size_t len, DeviceCommand& cmd);
+
+// Check the ranges and store the settings with one Storage::saveConfig()
+// (flash is written only for changed fields). False with cmd.error set when
+// the command is rejected; nothing is stored then.
+bool applyDeviceCommand(Storage& storage, DeviceCommand& cmd);
+
+// Ack payload: {"id":...,"status":"applied"} followed by the settings now in
+// effect, or {"id":...,"status":"rejected","error":...}. Returns its length,
+// 0 if it does not fit size.
+size_t writeCommandAck(const DeviceCommand& cmd, Storage& storage, char* out, size_t size);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+// Host name cache for the backend and the MQTT broker. Resolved addresses are
+// kept in RTC memory, so a wake connects without a DNS round trip; an entry
+// expires DNS_CACHE_TTL_S after its lookup (device clock, which runs through
+// deep sleep). A connect that fails on a cached address is retried once with
+// a live lookup.
+
+// Resolve host (or parse an IP literal) through the cache
+bool dnsResolve(const char* host, IPAddress& ip);
+
+// Drop the cached address of host
+void dnsForget(const char* host);
+
+// Open the TCP connection of client to host:port through the cache; the plain
+// WiFiClient connect is used even when client is a subclass (TlsClient runs its
+// handshake afterwards). timeoutMs < 0 keeps the client's default. Returns 1
+// on success like WiFiClient::connect().
+int dnsConnect(WiFiClient& client, const char* host, uint16_t port, int32_t timeoutMs = -1);
+
+// WiFiClient that resolves names through the cache (plain HTTP and MQTT)
+class DnsCachedClient : public WiFiClient {
+public:
+    using WiFiClient::connect;
+    int connect(const char* host, uint16_t port) override {
+        return dnsConnect(*this, host, port);
+    }
+    int connect(const char* host, uint16_t port, int32_t timeoutMs) {
+        return dnsConnect(*this, host, port, timeoutMs);
+    }
+};
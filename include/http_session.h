@@ -0,0 +1,53 @@
+#pragma once
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClient.h>
+#include "tls_client.h"
+#include "dns_cache.h"
+
+// Connection reuse counters, for diagnostics
+struct HttpSessionStats {
+    uint32_t requests;
+    uint32_t connects;      // requests that had to open a new TCP/TLS connection
+    uint32_t reuses;        // requests sent over the kept-alive connection
+    uint32_t failures;      // transport errors (no HTTP status)
+    unsigned long connectMs; // total time of requests that opened a connection
+    unsigned long reuseMs;   // total time of requests on a reused connection
+};
+
+/**
+ * One keep-alive HTTP(S) connection to the backend, shared by AuthManager
+ * and DataSender for the whole wake cycle. Login, MQTT-credentials and data
+ * requests go over the same socket, so a cold boot pays for one TCP/TLS
+ * handshake instead of three. The connection is reopened transparently if the
+ * server closed it.
+ */
+class HttpSession {
+public:
+    explicit HttpSession(const char* baseUrl);
+
+    // Send `method` to baseUrl + path. body may be nullptr (GET); bearerToken
+    // adds an Authorization header when non-empty. Returns the HTTP status
+    // (> 0) or a negative HTTPClient error; the body is stored in response.
+    int request(const char* method, const char* path, const char* body, size_t len,
+                const String &bearerToken, String &response,
+                const char* contentType = "application/json");
+
+    String url(const char* path) const { return String(baseUrl) + path; }
+
+    // Drop the connection (before WiFi goes down)
+    void close();
+
+    const HttpSessionStats& stats() const { return stats_; }
+    void printStats() const;
+
+private:
+    const char* baseUrl;
+    bool secure;
+    DnsCachedClient plainClient;
+    TlsClient secureClient; // resumes the TLS session of the previous wake
+    HTTPClient http;
+    HttpSessionStats stats_;
+
+    WiFiClient& transport();
+};
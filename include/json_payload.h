@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+struct SensorReading; // forward declaration (defined in data_sender.h)
+
+// Fixed-buffer JSON encoder for the sensor data payload shared by MQTT and HTTP:
+//   {"sensors":[{"uuid":"<uuid>","value":<value>},...]}
+// Values are rounded to 2 decimals and printed without trailing zeros (22.5,
+// 22, -0.13), the same text ArduinoJson produced for the rounded floats;
+// NaN, infinities and magnitudes above 1e15 are written as null.
+
+// Characters of the envelope `{"sensors":[` + `]}` plus the terminating NUL
+constexpr size_t JSON_PAYLOAD_ENVELOPE = 15;
+// Longest value text: sign, 16 integer digits, point, 2 decimals
+constexpr size_t JSON_VALUE_MAX_CHARS = 20;
+
+// Length of a string once escaped for JSON
+constexpr size_t jsonEscapedLength(const char* s) {
+    size_t n = 0;
+    for (; *s; ++s) {
+        const unsigned char c = (unsigned char)*s;
+        n += (c == '"' || c == '\\') ? 2 : (c < 0x20 ? 6 : 1);
+    }
+    return n;
+}
+
+// Upper bound of one encoded reading, including its separating comma
+constexpr size_t jsonReadingMaxSize(const char* uuid) {
+    return 21 + jsonEscapedLength(uuid) + JSON_VALUE_MAX_CHARS;
+}
+
+// Serialize readings into out (NUL-terminated). No heap is used.
+// Returns number of characters written (excluding the NUL), or 0 if the
+// payload does not fit in outSize.
+size_t serializeReadingsJson(const SensorReading* readings, size_t count,
+                             char* out, size_t outSize);
+
+// Batch payload with the readings of several wake cycles. "uuids" is listed
+// once and every cycle carries one value per uuid, in the same order (null for
+// a failed read). "ts" and "now" are device clock seconds: the server places a
+// cycle at (receive time - (now - ts)) whether or not the clock was ever set.
+// "now" is null for cycles recorded before a power loss (their clock is gone).
+//   {"now":<s>,"uuids":["<uuid>",...],"batch":[{"ts":<s>,"values":[<v>,...]},...]}
+
+// `{"now":` + 10 digits + `,"uuids":[` + `],"batch":[` + `]}` + NUL
+constexpr size_t JSON_BATCH_ENVELOPE = 41;
+
+// Upper bound of one listed uuid, including quotes and separating comma
+constexpr size_t jsonBatchUuidMaxSize(const char* uuid) {
+    return 3 + jsonEscapedLength(uuid);
+}
+
+// Upper bound of one cycle: `{"ts":` + 10 digits + `,"values":[` + values + `]}` + comma
+constexpr size_t jsonBatchCycleMaxSize(size_t sensorCount) {
+    return 30 + sensorCount * (JSON_VALUE_MAX_CHARS + 1);
+}
+
+// Serialize cycleCount cycles; values is row-major (cycleCount x sensorCount).
+// Same return convention as serializeReadingsJson.
+size_t serializeBatchJson(bool nowKnown, uint32_t now, const char* const* uuids, size_t sensorCount,
+                          const uint32_t* timestamps, const float* values, size_t cycleCount,
+                          char* out, size_t outSize);
+
+// Streaming forms: the same text is handed to write in pieces of at most
+// JSON_STREAM_CHUNK_SIZE bytes (no NUL) instead of being stored, so the
+// payload size is not bounded by a buffer. With write == nullptr nothing is
+// emitted and only the length is computed, e.g. to announce it in a packet
+// header before the second pass. Return the length, or 0 if write failed.
+constexpr size_t JSON_STREAM_CHUNK_SIZE = 128;
+
+// Receives the next piece of text; returns false to abort
+typedef bool (*JsonChunkWriter)(void* ctx, const char* data, size_t len);
+
+size_t streamReadingsJson(const SensorReading* readings, size_t count, JsonChunkWriter write, void* ctx);
+
+size_t streamBatchJson(bool nowKnown, uint32_t now, const char* const* uuids, size_t sensorCount,
+                       const uint32_t* timestamps, const float* values, size_t cycleCount,
+                       JsonChunkWriter write, void* ctx);
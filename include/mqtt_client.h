@@ -1,10 +1,12 @@
 #pragma once
 #include <Arduino.h>
 #include <WiFi.h>
-#include <PubSubClient.h>
-#include <WiFiClientSecure.h>
+#include "mqtt_connection.h"
+#include "tls_client.h"
+#include "dns_cache.h"
 #include "storage.h"
 #include "data_sender.h" // For SensorReading struct
+#include "device_command.h"
 
 class MqttClient {
 public:
@@ -14,28 +16,62 @@ public:
     bool connect();
     bool isConnected();
     void disconnect();
-    // Process pending MQTT events once (call after connect to stabilize)
+    // MqttConnection::state() of the last connection attempt
+    int state() const { return mqttClient.state(); }
+    // Process pending MQTT events once (non-blocking)
     void process();
     
-    // Publish sensor data payload (JSON string built by DataSender)
-    bool publishSensorDataPayload(const char* payload);
+    // Publish sensor data payload (JSON string built by DataSender) at
+    // AGRONOS_MQTT_QOS_DATA. Returns once the broker acknowledged it, or, if
+    // pendingId is given, once it is in flight: its packet id is stored there
+    // (0 when already confirmed) to check with delivered() after flush().
+    bool publishSensorDataPayload(const char* payload, uint16_t* pendingId = nullptr);
+
+    // Publish a binary sensor payload to topicTemplate (formatted with the device UUID)
+    bool publishSensorDataPayload(const uint8_t* payload, size_t len, const char* topicTemplate,
+                                  uint16_t* pendingId = nullptr);
+
+    // Streamed sensor data publish to topicTemplate of exactly len bytes, fed
+    // in pieces (e.g. straight from an encoder) so the payload is never held
+    // in RAM. endSensorData() returns like publishSensorDataPayload; a
+    // streamed message is not resent after a reconnect (see MqttConnection).
+    bool beginSensorData(const char* topicTemplate, size_t len);
+    bool writeSensorData(const uint8_t* data, size_t len);
+    bool endSensorData(uint16_t* pendingId = nullptr);
+
+    // Wait for the PUBACKs of every publish in flight (MQTT_ACK_TIMEOUT_MS)
+    bool flush();
+
+    // The publish with this pending id was acknowledged by the broker
+    bool delivered(uint16_t pendingId) const { return mqttClient.acked(pendingId); }
     
     // Publish device status
     bool publishStatus(const char* status);
+
+    // Apply the commands received on AGRONOS_MQTT_TOPIC_COMMAND since the last
+    // call (device_command.h) and publish their acks, each confirmed by the
+    // broker. Commands only arrive while the connection is serviced (process(),
+    // publishes). Returns how many were applied; the caller then reloads its
+    // copy of the settings.
+    size_t handleCommands();
     
 private:
     Storage &storage;
-    WiFiClient wifiClient;
-    WiFiClientSecure secureClient;
-    PubSubClient mqttClient;
+    DnsCachedClient wifiClient;
+    TlsClient secureClient;
+    MqttConnection mqttClient;
     
     const char* deviceUuid;
     MqttCredentials credentials;
     bool credentialsLoaded;
+
+    DeviceCommand commands[MQTT_COMMAND_QUEUE]; // received, not yet applied
+    size_t commandCount;
     
-    String buildTopic(const char* topicTemplate) const;
+    const char* formatTopic(const char* topicTemplate) const;
     bool loadCredentials();
-    
-    // Callback for incoming messages
-    static void mqttCallback(char* topic, byte* payload, unsigned int length);
+    bool publishData(const char* topic, const uint8_t* payload, size_t len, uint16_t* pendingId);
+    bool confirmPublish(bool published, uint16_t packetId, uint16_t* pendingId);
+    bool subscribeCommands();
+    static bool onMessage(void* ctx, const char* topic, const uint8_t* payload, size_t len);
 };
@@ -0,0 +1,171 @@
+#pragma once
+#include <Arduino.h>
+#include <Client.h>
+#include "config.h"
+
+// MQTT protocol level sent in CONNECT
+enum class MqttVersion : uint8_t {
+    V311 = 4,
+    V5 = 5,
+};
+
+// state() values, as PubSubClient's; > 0 is the CONNACK return/reason code
+constexpr int MQTT_STATE_CONNECTION_TIMEOUT = -4;
+constexpr int MQTT_STATE_CONNECTION_LOST = -3;
+constexpr int MQTT_STATE_CONNECT_FAILED = -2;
+constexpr int MQTT_STATE_DISCONNECTED = -1;
+constexpr int MQTT_STATE_CONNECTED = 0;
+
+// A QoS 1 publish waiting for its PUBACK
+struct MqttInFlight {
+    uint16_t packetId;  // 0 = free slot
+    bool retained;
+    uint8_t* data;      // topic, NUL, payload (the slot's arena row); nullptr for a streamed publish
+    size_t topicLen;
+    size_t len;         // payload bytes
+};
+
+// Message received on a subscription. topic and payload point into the
+// receive buffer and are valid only during the call; the handler runs inside
+// loop() and must not publish or subscribe. Returning false refuses a QoS 1
+// message: it is not acknowledged, so the server sends it again on the next
+// connect of the session.
+typedef bool (*MqttMessageHandler)(void* ctx, const char* topic, const uint8_t* payload, size_t len);
+
+/**
+ * MQTT 3.1.1 / 5 client on any Arduino Client (WiFiClient, TlsClient).
+ *
+ * QoS 1 publishes are copied into an in-flight window of MQTT_INFLIGHT_WINDOW
+ * messages and sent without waiting for their PUBACK; publish() only blocks
+ * when the window is full. Unacknowledged messages are sent again (DUP) after
+ * a reconnect to a persistent session. With MQTT 5 the server's Receive
+ * Maximum narrows the window, and topics get aliases (up to the server's Topic
+ * Alias Maximum) so repeated publishes carry a two-byte alias instead of the
+ * topic name.
+ *
+ * Messages on subscribed topics (QoS 0 or 1) are passed to the handler set
+ * with setCallback() and acknowledged once it returns, unless it refused the
+ * message. A message whose packet
+ * does not fit MQTT_RX_BUFFER_SIZE is acknowledged and dropped; with MQTT 5
+ * the server is told the limit (Maximum Packet Size) and discards it instead.
+ */
+class MqttConnection {
+public:
+    MqttConnection();
+
+    void setClient(Client& client) { client_ = &client; }
+    void setServer(const char* host, uint16_t port) { host_ = host; port_ = port; }
+    void setKeepAlive(uint16_t seconds) { keepAliveS_ = seconds; }
+    void setProtocol(MqttVersion version) { version_ = version; }
+    // MQTT 5 Session Expiry Interval for sessions that are not clean
+    void setSessionExpiry(uint32_t seconds) { sessionExpiryS_ = seconds; }
+    void setCallback(MqttMessageHandler handler, void* ctx) { handler_ = handler; handlerCtx_ = ctx; }
+
+    // Open the connection and wait for CONNACK (MQTT_CONNECT_TIMEOUT_MS).
+    // cleanSession = false resumes the broker's session for clientId.
+    bool connect(const char* clientId, const char* user, const char* pass, bool cleanSession);
+    bool connected();
+    void disconnect();
+
+    // Handle incoming packets and keep-alive; call regularly while connected
+    bool loop();
+
+    // QoS 0 returns once written; QoS 1 once in the in-flight window, with its
+    // packet identifier in packetId (if given). False when not connected or
+    // the message could not be sent.
+    bool publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos,
+                 bool retained, uint16_t* packetId = nullptr);
+
+    // Subscribe to topic (QoS 2 is requested as QoS 1) and wait for the SUBACK
+    // (MQTT_ACK_TIMEOUT_MS); false when not connected, on timeout or when the
+    // server refused the subscription
+    bool subscribe(const char* topic, uint8_t qos);
+
+    // Streamed publish of exactly len payload bytes: beginPublish() sends the
+    // header, write() the payload in any number of pieces, endPublish()
+    // completes it (packetId as for publish()). Nothing is buffered, so the
+    // payload size is not limited by RAM; in exchange a streamed QoS 1
+    // message cannot be sent again after a reconnect and then counts as not
+    // delivered (acked() false), leaving the retry to the caller.
+    bool beginPublish(const char* topic, size_t len, uint8_t qos, bool retained);
+    size_t write(const uint8_t* data, size_t len);
+    bool endPublish(uint16_t* packetId = nullptr);
+
+    // True once a successful PUBACK of packetId arrived (or it was never in
+    // flight); false while pending and after the server rejected it
+    bool acked(uint16_t packetId) const;
+
+    // Wait for the PUBACK of packetId; false on timeout, rejection or lost connection
+    bool waitAck(uint16_t packetId, unsigned long timeoutMs);
+
+    // Wait until every QoS 1 publish is acknowledged; false on timeout or
+    // lost connection (the messages stay in the window for the next connect)
+    bool flush(unsigned long timeoutMs);
+
+    size_t inFlight() const { return inFlightCount_; }
+    bool sessionPresent() const { return sessionPresent_; }
+    MqttVersion protocol() const { return version_; }
+    int state() const { return state_; }
+
+private:
+    Client* client_;
+    const char* host_;
+    uint16_t port_;
+    uint16_t keepAliveS_;
+    MqttVersion version_;
+    uint32_t sessionExpiryS_;
+    int state_;
+    bool sessionPresent_;
+
+    uint16_t nextPacketId_;
+    MqttInFlight inFlight_[MQTT_INFLIGHT_WINDOW];
+    uint8_t inFlightData_[MQTT_INFLIGHT_WINDOW][MQTT_TOPIC_MAX_LEN + MQTT_INFLIGHT_MAX_PAYLOAD]; // copy kept by slot i
+    size_t inFlightCount_;
+    size_t window_;            // slots usable on this connection
+    uint16_t rejected_[MQTT_INFLIGHT_WINDOW]; // last packet ids with a failure PUBACK
+    size_t rejectedNext_;
+
+    char aliasTopics_[MQTT_TOPIC_ALIAS_SLOTS][MQTT_TOPIC_MAX_LEN]; // topic of alias i + 1
+    uint16_t aliasCount_;
+    uint16_t aliasMax_;        // server's Topic Alias Maximum, capped to our table
+
+    MqttMessageHandler handler_;
+    void* handlerCtx_;
+    uint16_t subackId_;        // SUBSCRIBE waiting for its SUBACK, 0 = none
+    uint8_t subackCode_;       // return/reason code of the last SUBACK
+
+    bool streaming_;           // between beginPublish() and endPublish()
+    size_t streamLeft_;        // payload bytes still announced
+    uint16_t streamId_;        // packet id of the streamed QoS 1 publish
+
+    unsigned long lastOutMs_;  // last packet sent, for keep-alive
+    unsigned long pingSentMs_; // 0 = no PINGREQ outstanding
+
+    // Incoming packet being assembled by loop()
+    uint8_t rxHeader_;         // 0 = waiting for a packet
+    uint32_t rxLength_;        // body length from the fixed header
+    uint32_t rxRead_;          // body bytes read so far
+    uint8_t rxLengthShift_;
+    bool rxInLength_;
+    uint8_t rxBuf_[MQTT_RX_BUFFER_SIZE]; // larger bodies are skipped
+
+    bool writePacket(const uint8_t* head, size_t headLen, const uint8_t* body, size_t bodyLen);
+    size_t publishHeader(uint8_t* head, const char* topic, size_t len, uint8_t qos,
+                         bool retained, uint16_t packetId, bool dup);
+    bool sendPublish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos,
+                     bool retained, uint16_t packetId, bool dup);
+    bool validTopic(const char* topic) const;
+    uint16_t takePacketId();
+    MqttInFlight* reserveSlot();
+    void releaseSlot(MqttInFlight& slot, bool rejected);
+    void abortStream();
+    bool readPacket(uint8_t& header, size_t& len, unsigned long timeoutMs);
+    bool pollPacket(uint8_t& header, size_t& len);
+    void handlePacket(uint8_t header, size_t len);
+    void handlePublish(uint8_t header, size_t len);
+    void parseConnackProperties(const uint8_t* p, size_t len);
+    bool resendInFlight();
+    void releaseInFlight();
+    void dropConnection(int state);
+    void resetReceive();
+};
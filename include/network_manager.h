@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+// Station link state, tracked from the WiFi driver's events rather than by
+// polling WiFi.status()
+enum class NetState : uint8_t {
+    Down = 0,   // not started, or disconnected
+    Connecting, // connect issued, waiting for association
+    Associated, // associated with the access point, waiting for an IP
+    Online,     // IP assigned (DHCP or static)
+};
+
+// Single owner of the station state for AuthManager, DataSender, MqttClient
+// and the wake cycle. The event handlers (WiFi event task) update the state
+// and an event group; waiting callers block on the event group, so the CPU
+// idles until the driver reports progress instead of waking every poll period.
+class NetworkManager {
+public:
+    // Register the WiFi event handlers; safe to call more than once
+    void begin();
+
+    // Non-blocking queries
+    NetState state() const { return state_; }
+    bool online() const { return state_ == NetState::Online; }
+
+    // Mark the start of a connect; call right before WiFi.begin()
+    void connecting();
+
+    // Block until online or timeoutMs elapsed. With failFast a disconnect
+    // event (access point not found, authentication failure) ends the wait
+    // early. Returns true when online.
+    bool waitOnline(unsigned long timeoutMs, bool failFast = false);
+
+    // Time from connecting() to the got-IP event of the last connect
+    unsigned long lastConnectMs() const { return lastConnectMs_; }
+
+    // WiFi driver event (runs in the WiFi event task)
+    void handleEvent(arduino_event_id_t event);
+
+private:
+    volatile NetState state_ = NetState::Down;
+    volatile unsigned long connectStart_ = 0;
+    volatile unsigned long lastConnectMs_ = 0;
+    EventGroupHandle_t events_ = nullptr;
+};
+
+// Single instance shared by the WiFi firmware
+NetworkManager& networkManager();
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Store-and-forward queue for sensor cycles that could not be uploaded, kept
+// in LittleFS so it survives deep sleep, outages and power loss.
+//
+// Cycles (a timestamp and one value per SENSOR_CONFIGS entry, like the RTC
+// reading batch) are appended to numbered segment files under /queue. A
+// segment holds at most READING_BATCH_MAX_CYCLES cycles, so it always fits
+// one batch payload, and only cycles from one power session (device clock).
+// Drain reads the oldest segments, uploads them and deletes each one once its
+// delivery is confirmed. Deleting a file is atomic in LittleFS, so a cycle is
+// never lost; it is sent twice only when an upload went through but its
+// acknowledgement did not arrive. Each record carries a CRC; a record torn by a power cut is skipped. When
+// OFFLINE_QUEUE_MAX_SEGMENTS is reached, the oldest segment is dropped.
+
+// Mount the filesystem (formatting it on first use) and index the segments.
+// Cheap after the first call of a wake; returns false if flash is unusable.
+bool queueBegin();
+
+// Append cycles (row-major values, SENSOR_CONFIG_COUNT per cycle).
+// Returns false when the flash could not be written.
+bool queueAppend(const uint32_t* timestamps, const float* values, size_t cycles);
+
+// Number of segments waiting to be uploaded
+size_t queueSegmentCount();
+
+// False only when the queue is known to be empty (kept in RTC memory), so
+// wakes with nothing queued do not mount the filesystem
+bool queuePending();
+
+// Load segment `index` (0 = oldest; at most READING_BATCH_MAX_CYCLES cycles).
+// currentSession is true if its timestamps use this power session's clock,
+// so they can be related to time(). Returns the number of cycles loaded.
+size_t queueRead(size_t index, uint32_t* timestamps, float* values, bool& currentSession);
+
+// Delete the oldest segment after it was uploaded
+void queuePopOldest();
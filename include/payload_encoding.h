@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+// Wire format of sensor data uploads
+enum class PayloadEncoding : uint8_t {
+    Json = 0,       // JSON text (json_payload.h)
+    TimeSeries = 1, // compressed binary for batches (ts_codec.h), JSON for single readings
+    Cbor = 2,       // the JSON structures as CBOR (cbor_payload.h)
+};
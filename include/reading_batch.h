@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sensor_scheduler.h"
+
+// Readings of several wake cycles, kept in RTC memory so they survive deep
+// sleep (lost on power cycle) and uploaded together by DataSender::sendBatch.
+// One row per cycle with one value per SENSOR_CONFIGS entry (NaN when the read
+// failed); holds up to READING_BATCH_MAX_CYCLES rows, oldest first.
+
+// Store one acquisition cycle. When the batch is full the oldest cycle is
+// dropped to make room.
+void batchAppend(uint32_t timestamp, const SensorSample* samples, size_t count);
+
+// Fill a row of SENSOR_CONFIG_COUNT values from samples, in SENSOR_CONFIGS
+// order (NaN for failed or missing reads), as batchAppend() stores it
+void batchRowFromSamples(const SensorSample* samples, size_t count, float* row);
+
+// Number of stored cycles
+size_t batchCycleCount();
+
+// True when the next append would drop a cycle
+bool batchFull();
+
+// Row data for serialization (batchCycleCount() rows of SENSOR_CONFIG_COUNT values)
+const uint32_t* batchTimestamps();
+const float* batchValues();
+
+// Forget the stored cycles after a successful upload
+void batchClear();
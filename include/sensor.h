@@ -1,8 +1,7 @@
 #pragma once
 
 #include <stddef.h>
-#include <vector>
-#include <memory>
+#include <stdint.h>
 
 // Sensor descriptor used by the sensor factory
 struct SensorConfig {
@@ -10,27 +9,102 @@ struct SensorConfig {
     int pin;                 // pin or -1 if not applicable
     const char* uuid;        // sensor uuid used by the server
     const char* displayName; // human-readable name for UI display (e.g. "Temperature", "Humidity")
+    int powerPin = -1;       // GPIO switching the sensor supply (active high), -1 if always powered
+    unsigned long warmupMs = 0; // settle time after power-on before a reading is valid
 };
 
-class SensorBase {
+// Maximum number of values a single physical device can publish
+constexpr size_t MAX_SENSOR_CHANNELS = 4;
+
+// One physical sensor device. A device performs a single bus transaction per
+// acquisition cycle and publishes one value per channel (e.g. DHT20 channel 0
+// is temperature, channel 1 humidity). The factory binds each channel to the
+// server-side UUID of its SENSOR_CONFIGS entry; unbound channels are skipped.
+// Implementations also declare `static constexpr size_t CHANNELS`, which the
+// compile-time registry checks against its type table (sensor_registry.h).
+class SensorDevice {
 public:
-    virtual ~SensorBase() = default;
-    virtual const char* uuid() const = 0;
-    // read a single float value from the sensor, return true on success
-    virtual bool read(float &out) = 0;
-};
+    virtual ~SensorDevice() = default;
+
+    // Number of values produced per acquisition cycle
+    virtual size_t channelCount() const = 0;
+
+    // Split-phase acquisition, driven by the sensor scheduler (sensor_scheduler.h).
+    // start() kicks off a conversion without blocking, ready() is polled until
+    // the result is available and collect() fetches one value per channel.
+    virtual bool start() { return true; }
+    virtual bool ready() { return true; }
+    virtual bool collect(float* values) = 0;
+
+    // Power-on settle time the part needs at minimum (datasheet value), applied
+    // when the device is power-gated
+    virtual unsigned long minWarmupMs() const { return 0; }
+    // Called right before the supply is cut, e.g. to stop driving or pulling up
+    // data lines that would otherwise back-power the sensor
+    virtual void powerDown() {}
 
-// Creator function type used by the registry
-using CreatorFunc = SensorBase*(*)(const SensorConfig& cfg);
+    // Shortest time between two reads the part tolerates (datasheet value).
+    // Asked again sooner, the scheduler reuses the last result instead.
+    virtual unsigned long minReadIntervalMs() const { return 0; }
 
-// Registration API: sensor implementation files should call this (via a static
-// registrar) to register themselves. This lets the factory create instances
-// without modifying the factory code when new sensor classes are added.
-bool registerSensorFactory(const char* name, CreatorFunc creator);
+    // Supply configuration from SENSOR_CONFIGS. Entries sharing a device merge:
+    // the first power pin wins and the longest warm-up applies.
+    void bindPower(int pin, unsigned long warmupMs) {
+        if (powerPin_ < 0) powerPin_ = pin;
+        if (warmupMs > warmupMs_) warmupMs_ = warmupMs;
+    }
+    int powerPin() const { return powerPin_; }
+    // Delay from the start of the acquisition cycle (power-on for gated
+    // devices) until start() may be called
+    unsigned long warmupMs() const {
+        if (powerPin_ < 0) return warmupMs_;
+        return warmupMs_ > minWarmupMs() ? warmupMs_ : minWarmupMs();
+    }
 
-// Create a sensor instance by name using the registered creators. Returns
-// nullptr if no creator is found.
-SensorBase* createSensorByType(const char* name, const SensorConfig& cfg);
+    void bindChannel(size_t channel, const char* uuid) {
+        if (channel < MAX_SENSOR_CHANNELS) uuids_[channel] = uuid;
+    }
+    // UUID bound to the channel, nullptr if the channel is not published
+    const char* channelUuid(size_t channel) const {
+        return channel < MAX_SENSOR_CHANNELS ? uuids_[channel] : nullptr;
+    }
 
-// Factory helpers (implemented in src/sensor_factory.cpp)
-std::vector<std::unique_ptr<SensorBase>> createSensors();
+    // Result of the last read (values of every channel, or a failure) taken
+    // at `atMs`, kept for reuse within minReadIntervalMs()
+    void recordRead(const float* values, bool ok, unsigned long atMs) {
+        for (size_t ch = 0; ch < MAX_SENSOR_CHANNELS; ++ch) lastValues_[ch] = ok ? values[ch] : 0.0f;
+        lastOk_ = ok;
+        lastReadMs_ = atMs;
+        readOnce_ = true;
+    }
+    // The part may be read again at `nowMs`
+    bool readDue(unsigned long nowMs) const {
+        return !readOnce_ || nowMs - lastReadMs_ >= minReadIntervalMs();
+    }
+    // Copy the last recorded values; false if that read failed
+    bool lastRead(float* values) const {
+        for (size_t ch = 0; ch < MAX_SENSOR_CHANNELS; ++ch) values[ch] = lastValues_[ch];
+        return lastOk_;
+    }
+
+private:
+    const char* uuids_[MAX_SENSOR_CHANNELS] = {};
+    int powerPin_ = -1;
+    unsigned long warmupMs_ = 0;
+    float lastValues_[MAX_SENSOR_CHANNELS] = {};
+    bool lastOk_ = false;
+    bool readOnce_ = false;
+    unsigned long lastReadMs_ = 0;
+};
+
+// Convenience base for devices that publish a single value
+class SensorBase : public SensorDevice {
+public:
+    static constexpr size_t CHANNELS = 1;
+    size_t channelCount() const override { return CHANNELS; }
+    const char* uuid() const { return channelUuid(0); }
+    // read a single float value from the sensor, return true on success.
+    // Split-phase sensors are only asked once ready() reported the result.
+    virtual bool read(float &out) = 0;
+    bool collect(float* values) override { return read(values[0]); }
+};
@@ -1,14 +1,48 @@
 #pragma once
 
-#include "sensor.h"
+#include <new>
+#include "sensor_registry.h"
 
-// Templated creator helper to be used by each sensor implementation when registering
-// with the factory. Requires sensor classes exposing a constructor (int pin, const char* uuid)
-// For sensors that don't match that signature, define a small wrapper in the cpp file.
+// Statically allocated instances of a device class, sized at compile time from
+// SENSOR_CONFIGS (sensor_registry.h). Used by each sensor implementation to
+// define its creator:
+//
+//   static StaticSensorPool<SoilMoistureSensor, createSoilMoistureSensor> pool;
+//   SensorDevice* createSoilMoistureSensor(int pin) { return pool.create(pin); }
+//
+// Device classes expose a constructor (int pin) and a CHANNELS constant; the
+// factory binds channel UUIDs after construction. Instances are constructed
+// on demand from setup() rather than during static init, so constructors may
+// use Serial, Wire and other peripherals.
 
+template <typename T, size_t N>
+class StaticSensorStorage {
+public:
+    void* allocate() { return used_ < N ? slots_[used_++] : nullptr; }
+
+private:
+    alignas(T) unsigned char slots_[N][sizeof(T)];
+    size_t used_ = 0;
+};
+
+// Device class not used by SENSOR_CONFIGS: no storage at all
 template <typename T>
-SensorBase* create_sensor_impl(const SensorConfig& cfg) {
-    return new T(cfg.pin, cfg.uuid);
-}
+class StaticSensorStorage<T, 0> {
+public:
+    void* allocate() { return nullptr; }
+};
+
+template <typename T, CreatorFunc Creator>
+class StaticSensorPool {
+    static_assert(T::CHANNELS == sensorTypeChannels(Creator),
+                  "SENSOR_TYPES channel count does not match the device class");
+
+public:
+    SensorDevice* create(int pin) {
+        void* slot = storage_.allocate();
+        return slot ? new (slot) T(pin) : nullptr;
+    }
 
-// Specialization for sensors that don't accept pin+uuid can be provided in their own files.
+private:
+    StaticSensorStorage<T, sensorPoolSize(Creator)> storage_;
+};
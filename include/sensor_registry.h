@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sensor.h"
+#include "config.h" // SENSOR_CONFIGS
+
+// Compile-time sensor registry. SENSOR_CONFIGS is resolved against the type
+// table below while compiling: the device set, the channel each entry binds to
+// and the number of instances of every device class are all constants, so
+// nothing is looked up or heap-allocated at boot. A SENSOR_CONFIGS type that is
+// missing from the table is a build error.
+
+// Creator of a device class: returns the next instance from the class's
+// statically allocated pool (sensor_creator.h), nullptr once it is exhausted
+using CreatorFunc = SensorDevice*(*)(int pin);
+
+// One creator per device class, defined next to the class in src/
+SensorDevice* createDHT11Sensor(int pin);
+SensorDevice* createDHT20Sensor(int pin);
+SensorDevice* createSoilMoistureSensor(int pin);
+SensorDevice* createBatteryLevelSensor(int pin);
+SensorDevice* createSimulatedSensor(int pin);
+
+struct SensorTypeEntry {
+    const char* name;    // SensorConfig::type
+    CreatorFunc creator;
+    size_t channel;      // channel of the device the entry is bound to
+    size_t channels;     // channel count of the device class
+};
+
+// Multi-value devices list one name per channel with the same creator;
+// entries sharing a creator and pin are served by one device instance.
+constexpr SensorTypeEntry SENSOR_TYPES[] = {
+    { "DHT11TemperatureReader", createDHT11Sensor,        0, 2 },
+    { "DHT11HumidityReader",    createDHT11Sensor,        1, 2 },
+    { "DHT20TemperatureReader", createDHT20Sensor,        0, 2 },
+    { "DHT20HumidityReader",    createDHT20Sensor,        1, 2 },
+    { "SoilMoistureSensor",     createSoilMoistureSensor, 0, 1 },
+    { "BatteryLevelSensor",     createBatteryLevelSensor, 0, 1 },
+    { "SIMULATED",              createSimulatedSensor,    0, 1 },
+};
+constexpr size_t SENSOR_TYPE_COUNT = sizeof(SENSOR_TYPES) / sizeof(SENSOR_TYPES[0]);
+
+constexpr bool sensorTypeNameEquals(const char* a, const char* b) {
+    while (*a && *a == *b) { ++a; ++b; }
+    return *a == *b;
+}
+
+// Index into SENSOR_TYPES, SENSOR_TYPE_COUNT if the name is unknown
+constexpr size_t findSensorType(const char* name) {
+    for (size_t t = 0; t < SENSOR_TYPE_COUNT; ++t) {
+        if (sensorTypeNameEquals(SENSOR_TYPES[t].name, name)) return t;
+    }
+    return SENSOR_TYPE_COUNT;
+}
+
+constexpr bool sensorTypesConsistent() {
+    for (size_t t = 0; t < SENSOR_TYPE_COUNT; ++t) {
+        const SensorTypeEntry& e = SENSOR_TYPES[t];
+        if (e.channels == 0 || e.channels > MAX_SENSOR_CHANNELS || e.channel >= e.channels) return false;
+        if (findSensorType(e.name) != t) return false; // duplicate name
+        for (size_t u = 0; u < t; ++u) {
+            if (SENSOR_TYPES[u].creator == e.creator && SENSOR_TYPES[u].channels != e.channels) return false;
+        }
+    }
+    return true;
+}
+static_assert(sensorTypesConsistent(),
+              "SENSOR_TYPES: duplicate name, channel out of range or conflicting channel counts");
+
+// SENSOR_CONFIGS resolved to devices, in config order. An entry joins an
+// earlier device with the same creator and pin whose channel is still free,
+// otherwise it opens a new device.
+struct SensorPlan {
+    size_t deviceCount = 0;
+    size_t unknownTypes = 0;
+    size_t typeOf[SENSOR_CONFIG_COUNT] = {};    // SENSOR_TYPES index of each entry
+    size_t deviceOf[SENSOR_CONFIG_COUNT] = {};  // device serving each entry
+    bool opensDevice[SENSOR_CONFIG_COUNT] = {}; // entry is the first one of its device
+};
+
+constexpr SensorPlan makeSensorPlan() {
+    SensorPlan plan;
+    CreatorFunc creators[SENSOR_CONFIG_COUNT] = {};
+    int pins[SENSOR_CONFIG_COUNT] = {};
+    uint32_t bound[SENSOR_CONFIG_COUNT] = {}; // channel mask per device
+
+    for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) {
+        const size_t t = findSensorType(SENSOR_CONFIGS[i].type);
+        plan.typeOf[i] = t;
+        if (t == SENSOR_TYPE_COUNT) {
+            ++plan.unknownTypes;
+            continue;
+        }
+
+        const SensorTypeEntry& type = SENSOR_TYPES[t];
+        const uint32_t mask = 1u << type.channel;
+        size_t d = 0;
+        while (d < plan.deviceCount &&
+               !(creators[d] == type.creator && pins[d] == SENSOR_CONFIGS[i].pin && !(bound[d] & mask))) {
+            ++d;
+        }
+        if (d == plan.deviceCount) {
+            creators[d] = type.creator;
+            pins[d] = SENSOR_CONFIGS[i].pin;
+            plan.opensDevice[i] = true;
+            ++plan.deviceCount;
+        }
+        bound[d] |= mask;
+        plan.deviceOf[i] = d;
+    }
+    return plan;
+}
+
+constexpr SensorPlan SENSOR_PLAN = makeSensorPlan();
+static_assert(SENSOR_PLAN.unknownTypes == 0,
+              "SENSOR_CONFIGS uses a sensor type that is not listed in SENSOR_TYPES (sensor_registry.h)");
+
+// Number of physical devices described by SENSOR_CONFIGS
+constexpr size_t SENSOR_DEVICE_COUNT = SENSOR_PLAN.deviceCount;
+
+// Instances of a device class needed for SENSOR_CONFIGS (0 if the class is unused)
+constexpr size_t sensorPoolSize(CreatorFunc creator) {
+    size_t n = 0;
+    for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) {
+        if (SENSOR_PLAN.opensDevice[i] && SENSOR_TYPES[SENSOR_PLAN.typeOf[i]].creator == creator) ++n;
+    }
+    return n;
+}
+
+// Channel count a device class is registered with
+constexpr size_t sensorTypeChannels(CreatorFunc creator) {
+    for (size_t t = 0; t < SENSOR_TYPE_COUNT; ++t) {
+        if (SENSOR_TYPES[t].creator == creator) return SENSOR_TYPES[t].channels;
+    }
+    return 0;
+}
+
+// Devices described by SENSOR_CONFIGS (SENSOR_DEVICE_COUNT entries) with their
+// channels bound. Instances are constructed on the first call, live in static
+// storage and are never freed; later calls return the same array.
+SensorDevice* const* createSensors();
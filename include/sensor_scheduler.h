@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include "sensor.h"
+
+// Result of one published channel within an acquisition cycle
+struct SensorSample {
+    const char* uuid;
+    float value;
+    bool ok;
+    unsigned long latencyMs; // cycle start (power-on) until the device's values were collected
+};
+
+// Per-cycle timing report
+struct AcquisitionReport {
+    size_t deviceCount;
+    size_t sampleCount;         // bound channels written to the sample array
+    size_t okCount;
+    unsigned long wallMs;       // power-on until the last device finished
+    unsigned long sequentialMs; // sum of per-device latencies (cost of warming up and reading one after another)
+};
+
+// Power every gated device at once, start each conversion as soon as the
+// device's warm-up has elapsed (earliest deadline first), then poll and collect
+// each result as soon as it becomes ready. A supply rail is cut, and latched
+// off through deep sleep, right after the last device on it was collected.
+// Awake time is bounded by the slowest device instead of the sum of all of
+// them. One sample is written per bound channel (at most maxSamples,
+// SENSOR_CONFIG_COUNT always suffices); devices not ready within
+// SENSOR_ACQUISITION_TIMEOUT_MS of their start() are failed. A device whose
+// last read is more recent than its minReadIntervalMs() is not powered or
+// read; its last result is reported again. At most SENSOR_DEVICE_COUNT
+// devices are handled; no heap is used.
+AcquisitionReport acquireSensors(SensorDevice* const* devices, size_t deviceCount,
+                                 SensorSample* out, size_t maxSamples);
+
+// Print the timing report, including the milliseconds saved versus sequential reads
+void printAcquisitionReport(const AcquisitionReport& report);
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <sys/time.h>
+
+// Allocation-free filters for sensor samples (header-only).
+//
+// Burst reductions (median, trimmed mean) work in place on caller-owned
+// buffers and reorder them. Smoothing and outlier rejection keep their state in
+// a SignalFilterState owned by the sensor; declare it RTC_DATA_ATTR so it
+// carries across deep sleep:
+//
+//   static RTC_DATA_ATTR SignalFilterState state;
+//   float v;
+//   filterSample(state, raw, 15.0f, 2, 0.5f, 600000, filterClockMs(), v);
+
+// Sort a burst in place (insertion sort: bursts are a few dozen samples)
+template <typename T>
+void sortSamples(T* v, size_t n) {
+    for (size_t i = 1; i < n; ++i) {
+        T x = v[i];
+        size_t k = i;
+        for (; k > 0 && v[k - 1] > x; --k) v[k] = v[k - 1];
+        v[k] = x;
+    }
+}
+
+// Median of n samples (NAN if empty); reorders the buffer
+template <typename T>
+float medianOf(T* v, size_t n) {
+    if (n == 0) return NAN;
+    sortSamples(v, n);
+    if (n % 2) return (float)v[n / 2];
+    return ((float)v[n / 2 - 1] + (float)v[n / 2]) / 2.0f;
+}
+
+// Mean after dropping the `trim` lowest and `trim` highest samples (NAN if
+// nothing is left); reorders the buffer
+template <typename T>
+float trimmedMeanOf(T* v, size_t n, size_t trim) {
+    if (n <= 2 * trim) return NAN;
+    sortSamples(v, n);
+    float sum = 0.0f;
+    for (size_t i = trim; i < n - trim; ++i) sum += (float)v[i];
+    return sum / (float)(n - 2 * trim);
+}
+
+// Fixed-capacity window of samples; pushes past capacity are dropped
+template <typename T, size_t N>
+class SampleWindow {
+public:
+    bool push(T x) {
+        if (count_ >= N) return false;
+        data_[count_++] = x;
+        return true;
+    }
+    void clear() { count_ = 0; }
+    size_t size() const { return count_; }
+    bool full() const { return count_ == N; }
+
+    // Reductions sort the window in place
+    float median() { return medianOf(data_, count_); }
+    float trimmedMean(size_t trim) { return trimmedMeanOf(data_, count_, trim); }
+
+private:
+    T data_[N];
+    size_t count_ = 0;
+};
+
+// Per-channel state for smoothing and outlier rejection. All-zero (the RTC
+// contents after power-on) means no history.
+struct SignalFilterState {
+    float value;      // last accepted, smoothed value
+    uint8_t rejected; // consecutive samples rejected as outliers
+    bool valid;
+    int64_t atMs;     // clock of the last accepted sample (filterClockMs())
+};
+
+// System clock in milliseconds; unlike millis() it keeps running through
+// deep sleep, so it spaces samples taken on different wakes
+inline int64_t filterClockMs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+// Smoothing factor for a sample taken elapsedMs after the previous one, for
+// a filter that applies `alpha` per periodMs. The time constant then stays
+// the same whether samples come every 500 ms (always-on) or once per wake.
+inline float alphaForInterval(float alpha, unsigned long periodMs, int64_t elapsedMs) {
+    if (periodMs == 0 || elapsedMs <= 0 || alpha >= 1.0f) return alpha;
+    return 1.0f - powf(1.0f - alpha, (float)elapsedMs / (float)periodMs);
+}
+
+// Exponential smoothing: alpha in (0, 1], 1 = follow the input
+inline float smoothExponential(SignalFilterState& s, float x, float alpha) {
+    s.value = s.valid ? s.value + alpha * (x - s.value) : x;
+    s.valid = true;
+    return s.value;
+}
+
+// Outlier gate against the last accepted value. A sample more than maxStep
+// away is rejected, unless `confirmations` samples in a row were rejected: then
+// the jump is a real step change and the history restarts from it.
+inline bool acceptSample(SignalFilterState& s, float x, float maxStep, uint8_t confirmations) {
+    if (!s.valid || isnan(s.value) || fabsf(x - s.value) <= maxStep) {
+        s.rejected = 0;
+        return true;
+    }
+    if (++s.rejected < confirmations) return false;
+    s.rejected = 0;
+    s.valid = false; // restart smoothing at the new level
+    return true;
+}
+
+// Outlier gate followed by exponential smoothing, alpha per periodMs scaled
+// to the time since the last accepted sample (nowMs from filterClockMs()).
+// Returns false when the sample was rejected; `out` then holds the last
+// accepted value, which is not a new reading.
+inline bool filterSample(SignalFilterState& s, float x, float maxStep, uint8_t confirmations,
+                         float alpha, unsigned long periodMs, int64_t nowMs, float& out) {
+    if (isnan(x)) {
+        out = s.value;
+        return false;
+    }
+    if (!acceptSample(s, x, maxStep, confirmations)) {
+        out = s.value;
+        return false;
+    }
+    out = smoothExponential(s, x, alphaForInterval(alpha, periodMs, nowMs - s.atMs));
+    s.atMs = nowMs;
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+
+// Fixed-size lock-free queue between exactly one producer task and one
+// consumer task (e.g. the sampling loop and the MQTT service task). push()
+// is only called by the producer, pop() only by the consumer; neither
+// blocks, allocates or disables interrupts. Both indices count up forever
+// and wrap as unsigned integers; Capacity must be a power of two so the slot
+// index survives the wrap.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+public:
+    // Producer: copy item in; false (item dropped) when the queue is full
+    bool push(const T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) return false;
+        items_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: copy the oldest item out; false when the queue is empty
+    bool pop(T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) return false;
+        item = items_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Items queued (a snapshot when read by the other side)
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    T items_[Capacity];
+    std::atomic<size_t> head_{0}; // next item to pop (written by the consumer)
+    std::atomic<size_t> tail_{0}; // next slot to fill (written by the producer)
+};
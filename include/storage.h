@@ -1,20 +1,97 @@
 #pragma once
 #include <Preferences.h>
 #include <Arduino.h>
+#include "config.h"
+#include "payload_encoding.h"
 
 struct MqttCredentials {
-    String server;
-    String username;
-    String password;
+    char server[MQTT_SERVER_MAX_LEN];
+    char username[MQTT_USERNAME_MAX_LEN];
+    char password[MQTT_PASSWORD_MAX_LEN];
     bool isValid;
 };
 
+// Last successful WiFi association and DHCP lease (wifi_connect.h)
+struct WifiLink {
+    uint32_t ssidCrc; // CRC-32 of the SSID the link was made with
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved; // always 0; aligns ip without an unnamed pad byte
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns1;
+    uint32_t dns2;
+};
+
 struct DeviceConfig {
     String baseUrl;
     unsigned long readIntervalMs;
     bool mqttEnabled;
+    uint8_t uploadEveryCycles; // readings batched per upload (1 = no batching)
+    PayloadEncoding payloadEncoding;
+    bool alwaysOn; // mains powered: stay connected and sample continuously, no deep sleep
+    uint32_t sensorMask; // bit i enables SENSOR_CONFIGS[i]
+};
+
+// NVS traffic of this boot (Storage::printStats)
+struct NvsStats {
+    uint16_t opens;  // namespaces opened
+    uint16_t reads;  // keys read
+    uint16_t writes; // keys written or erased
+};
+
+// Everything Storage keeps, stored as one blob. Fields are ordered by
+// alignment so the layout has no padding (checked below): every byte the CRC
+// covers and memcmp compares is a field. Change STORAGE_RECORD_VERSION
+// (storage.cpp) with the layout.
+struct DeviceRecord {
+    uint16_t version;
+    uint16_t size;           // sizeof(DeviceRecord)
+    uint32_t sequence;       // the valid slot with the higher one is current
+
+    uint32_t readIntervalMs;
+    uint32_t sensorMask;
+    uint32_t loraFcnt;
+    WifiLink link;
+    uint8_t linkValid;
+    uint8_t configKeys;      // CONFIG_* fields set; the others follow the firmware defaults
+    uint8_t mqttEnabled;
+    uint8_t uploadEveryCycles;
+    uint8_t payloadEncoding;
+    uint8_t alwaysOn;
+
+    char ssid[WIFI_SSID_MAX_LEN];
+    char pass[WIFI_PASS_MAX_LEN];
+    char baseUrl[BASE_URL_MAX_LEN];
+    char token[AUTH_TOKEN_MAX_LEN];
+    char mqttServer[MQTT_SERVER_MAX_LEN];
+    char mqttUsername[MQTT_USERNAME_MAX_LEN];
+    char mqttPassword[MQTT_PASSWORD_MAX_LEN];
+
+    uint32_t crc;            // CRC-32 of the bytes before it
 };
 
+static_assert(sizeof(WifiLink) == 4 + 6 + 1 + 1 + 5 * 4, "WifiLink has padding");
+static_assert(sizeof(DeviceRecord) ==
+                  2 + 2 + 4 + 3 * 4 + sizeof(WifiLink) + 6 + WIFI_SSID_MAX_LEN + WIFI_PASS_MAX_LEN +
+                      BASE_URL_MAX_LEN + AUTH_TOKEN_MAX_LEN + MQTT_SERVER_MAX_LEN + MQTT_USERNAME_MAX_LEN +
+                      MQTT_PASSWORD_MAX_LEN + 4,
+              "DeviceRecord has padding");
+
+/**
+ * Persistent settings as one DeviceRecord blob in the "device" NVS namespace,
+ * double-buffered: a write goes to the slot not holding the current record,
+ * so a brown-out mid-write leaves the previous record intact (its CRC still
+ * matches, the torn one's does not). The record is read once on first use;
+ * getters are served from it and setters only change it in RAM. flush()
+ * writes it back when something changed: before deep sleep, and at once by
+ * callers whose change must survive a reset (portal save, remote commands,
+ * LoRa frame counter).
+ *
+ * Settings from the earlier per-key layout (namespaces wifi, auth, mqtt,
+ * config, lora) are moved into the record on the first boot without one.
+ */
 class Storage {
 public:
   Storage();
@@ -24,13 +101,20 @@ public:
   bool getWifiCreds(String &ssid, String &pass);
   void setWifiCreds(const String &ssid, const String &pass);
 
+  // Cached WiFi link for fast reconnects after a cold boot
+  bool getWifiLink(WifiLink &link);
+  void setWifiLink(const WifiLink &link);
+  void clearWifiLink();
+
   // Auth token
   String getToken();
+  bool hasToken();
   void setToken(const String &token);
 
-  // MQTT credentials
+  // MQTT credentials; false (nothing stored) when one does not fit its buffer.
+  // The other string setters likewise keep the old value for an over-long one.
   bool getMqttCredentials(MqttCredentials &creds);
-  void setMqttCredentials(const String &server, const String &username, const String &password);
+  bool setMqttCredentials(const String &server, const String &username, const String &password);
   void clearMqttCredentials();
   bool hasMqttCredentials();
 
@@ -41,30 +125,58 @@ public:
   String getBaseUrl();
   unsigned long getReadIntervalMs();
   bool getMqttEnabled();
+  uint8_t getUploadEveryCycles();
+  PayloadEncoding getPayloadEncoding();
+  bool getAlwaysOn();
+  uint32_t getSensorMask();
+  DeviceConfig getConfig();
 
   // Device configuration - Individual Setters
   void setBaseUrl(const String &url);
   void setReadIntervalMs(unsigned long ms);
   void setMqttEnabled(bool enabled);
+  void setUploadEveryCycles(uint8_t cycles);
+  void setPayloadEncoding(PayloadEncoding encoding);
+  void setAlwaysOn(bool enabled);
+  void setSensorMask(uint32_t mask);
 
-  // Device configuration - Atomic Setter
+  // Device configuration - Atomic Setter (fields equal to the current value
+  // are not taken over, so they keep following the defaults)
   void saveConfig(const DeviceConfig& cfg);
 
   // LoRa frame counter persistence
   uint32_t getLoraFcnt();
   void setLoraFcnt(uint32_t fcnt);
 
-  // Clear stored credentials and token
+  // Write the record to NVS; nothing when it is unchanged
+  void flush();
+  bool dirty() const { return _dirty; }
+
+  // Clear stored credentials, token and settings (erased from NVS at once)
   void clearAll();
 
+  const NvsStats& stats() const { return _stats; }
+  // [NVS] line with the counters, printed before deep sleep
+  void printStats() const;
+
 private:
   Preferences prefs;
-  
-  // Config cache and defaults
+  NvsStats _stats = {};
+
+  DeviceRecord _rec;   // current settings
+  uint8_t _slot = 1;   // slot _rec was read from or last written to; flush() uses the other
+  bool _loaded = false;
+  bool _dirty = false; // _rec changed since the last flush()
+
+  // Config cache (record fields or defaults) and defaults
   DeviceConfig _cache;
   DeviceConfig _defaults;
   bool _configLoaded = false;
-  
-  // Lazy-loading helper
+
+  // Lazy-loading helpers
+  void ensureLoaded();
   void ensureConfigLoaded();
+  bool readSlot(uint8_t slot);
+  bool migrateKeys();
+  void open(const char* name, bool readOnly);
 };
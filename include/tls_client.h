@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+// Handshake counters of every TlsClient connection since boot, for diagnostics
+struct TlsStats {
+    uint16_t full;           // full handshakes (certificate + key exchange)
+    uint16_t resumed;        // abbreviated handshakes from a cached session
+    uint16_t failed;
+    unsigned long fullMs;    // total time of full handshakes
+    unsigned long resumedMs; // total time of resumed handshakes
+};
+
+struct TlsContext; // mbedtls state of one connection (tls_client.cpp)
+
+/**
+ * TLS client (mbedtls) on the WiFiClient socket, usable wherever a WiFiClient
+ * or Client is expected (HTTPClient, MqttConnection). After a full handshake the
+ * TLS session (session ID and, if the server issues one, the session ticket)
+ * is saved in RTC memory per host and port. The next connection to that
+ * server, also after deep sleep, offers it, and a server that still knows the
+ * session resumes with an abbreviated handshake: no certificate exchange and
+ * no key agreement. Like WiFiClientSecure::setInsecure(), the server
+ * certificate is not verified.
+ */
+class TlsClient : public WiFiClient {
+public:
+    TlsClient();
+    ~TlsClient();
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs);
+    int connect(const char* host, uint16_t port, int32_t timeoutMs);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+    using Print::write;
+
+private:
+    TlsContext* ctx_;
+    int peeked_; // byte held back by peek(), -1 if none
+
+    // Run the handshake on the connected socket; closes it on failure
+    bool handshake(const char* host, uint16_t port);
+};
+
+const TlsStats& tlsStats();
+
+// One-line summary ("[TLS] ..."); prints nothing when no handshake was made
+void tlsPrintStats();
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Which upload transport DataSender tries first, learned across wake cycles.
+// Per-transport success/failure counts, failure streak and average send time
+// are kept in RTC memory (survive deep sleep, reset on power cycle). A
+// transport that fails TRANSPORT_DEMOTE_AFTER_FAILURES sends in a row is
+// demoted: it is skipped, and tried again first every TRANSPORT_REPROBE_EVERY
+// sends (interval doubling after each failed probe, up to
+// TRANSPORT_REPROBE_MAX). Healthy transports are tried fastest first; one
+// without a measurement yet counts as fastest so it gets measured.
+
+enum class Transport : uint8_t {
+    Mqtt = 0,
+    Http = 1,
+};
+
+constexpr size_t TRANSPORT_COUNT = 2;
+
+// Order in which to try the transports for one send. Demoted transports are
+// left out unless a re-probe is due (then they come first); when every
+// transport is demoted all are tried. Returns the number of entries written to order.
+size_t transportPlan(Transport order[TRANSPORT_COUNT]);
+
+// Outcome of one send attempt on t, elapsed including connection setup
+void transportRecord(Transport t, bool success, uint32_t elapsedMs);
+
+// One-line summary per transport ("[TRANSPORT] ...")
+void transportPrintStats();
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Compact binary encoding of a multi-cycle batch (the same cycles as the JSON
+// batch payload, see json_payload.h), after Gorilla (Pelkonen et al., VLDB 2015):
+//
+//   header (12 bytes, little endian)
+//     0      format version (TS_CODEC_VERSION)
+//     1      flags: bit 0 = "now" known
+//     2..5   sensor table id: CRC-32 of the uuids joined by '\n' (tsSensorTableId)
+//     6..9   now, device clock seconds (0 when unknown)
+//     10     sensor count
+//     11     cycle count
+//   bit stream (MSB first, zero padded to a byte)
+//     timestamps: first as 32 bits, second as delta (32 bits), then
+//       delta-of-delta: '0' = same interval, '10' + 7 bits, '110' + 9 bits,
+//       '1110' + 12 bits (two's complement), '1111' + 32 bits
+//     values, one column per sensor in table order (uuids are not sent; the
+//       receiver maps indices through the table id), each column XOR-chained:
+//       first value as 32 bits, then per value '0' = same as previous, or '1'
+//       followed by '0' + meaningful bits within the previous window, or
+//       '1' + 5 bits leading zeros + 5 bits (length - 1) + meaningful bits
+//
+// A failed read is a NaN like in the JSON payload and round-trips bit-exact.
+
+constexpr uint8_t TS_CODEC_VERSION = 1;
+constexpr size_t TS_CODEC_HEADER_SIZE = 12;
+
+// Upper bound of an encoded batch
+constexpr size_t tsEncodedMaxSize(size_t cycles, size_t sensorCount) {
+    // 36 bits per timestamp (delta-of-delta escape) and 44 bits per value
+    return TS_CODEC_HEADER_SIZE + (cycles * 36 + cycles * sensorCount * 44 + 7) / 8;
+}
+
+struct TimeSeriesHeader {
+    uint8_t version;
+    bool nowKnown;
+    uint32_t sensorTableId;
+    uint32_t now;
+    uint8_t sensorCount;
+    uint8_t cycleCount;
+};
+
+// Identifier of a sensor table (which uuid each value column belongs to)
+uint32_t tsSensorTableId(const char* const* uuids, size_t sensorCount);
+
+// Encode cycleCount cycles; values is row-major (cycleCount x sensorCount),
+// like serializeBatchJson. At most 255 cycles and 255 sensors.
+// Returns the encoded size, or 0 if it does not fit in outSize.
+size_t encodeTimeSeries(bool nowKnown, uint32_t now, uint32_t sensorTableId,
+                        const uint32_t* timestamps, const float* values,
+                        size_t cycleCount, size_t sensorCount,
+                        uint8_t* out, size_t outSize);
+
+// Decode a batch (host/server side). Fills the header, timestamps and
+// row-major values; fails if the data is truncated or malformed, or if the
+// batch holds more than maxCycles cycles or maxSensors sensors.
+bool decodeTimeSeries(const uint8_t* in, size_t len, TimeSeriesHeader& header,
+                      uint32_t* timestamps, float* values,
+                      size_t maxCycles, size_t maxSensors);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Arduino.h>
+
+class Storage; // forward declaration
+
+// Station connect with a fast path: the BSSID, channel and DHCP lease of the
+// last successful connect are kept in RTC memory (and NVS for cold boots) and
+// used for a directed connect with a static IP, which skips the channel scan
+// and DHCP. If that does not associate within WIFI_FAST_CONNECT_TIMEOUT_MS, or
+// every WIFI_LEASE_REFRESH_EVERY fast connects, a full scan + DHCP connect is
+// made and the cache refreshed from it.
+
+// Connect to ssid; returns true once associated (within WIFI_CONNECT_TIMEOUT_MS)
+bool wifiConnect(Storage& storage, const String& ssid, const String& pass);
+
+// The current connection came from the cache but the backend could not be
+// reached at the IP level (DNS failure, no route, TCP connect timeout; e.g.
+// the static IP is no longer ours): forget the cached link so the next connect
+// does a full scan and DHCP. Not for HTTP or MQTT errors from a server that
+// answered. No-op after a full connect.
+void wifiLinkFailed(Storage& storage);
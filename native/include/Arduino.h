@@ -0,0 +1,77 @@
+#pragma once
+
+// Host-native stand-in for the Arduino core (see native/README.md).
+// Only the subset of the API used by the firmware is provided; behaviour is
+// kept deterministic so logic modules can be exercised on Linux.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <string>
+
+#include "WString.h"
+#include "IPAddress.h"
+#include "Print.h"
+
+#define NATIVE_BUILD 1
+
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+void analogReadResolution(uint8_t bits);
+uint16_t analogRead(uint8_t pin);
+uint32_t analogReadMilliVolts(uint8_t pin);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t size) override;
+  using Print::write;
+  int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+  void restart();
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint64_t getEfuseMac();
+};
+
+extern EspClass ESP;
+
+// Host hooks: let harness code drive simulated hardware deterministically.
+void hostSetAnalogValue(uint8_t pin, uint16_t raw, uint32_t millivolts);
+void hostSetDigitalValue(uint8_t pin, int value);
+void hostAdvanceMillis(unsigned long ms);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define DHT11 11
+#define DHT12 12
+#define DHT22 22
+
+// Simulated single-wire DHT: returns values set via hostSetDht(). Like the
+// Adafruit driver, a transfer is only repeated after 2 s unless forced.
+class DHT {
+public:
+  DHT(uint8_t pin, uint8_t type, uint8_t count = 6) : pin_(pin) { (void)type; (void)count; }
+  void begin(uint8_t usec = 55) { (void)usec; }
+  bool read(bool force = false);
+  float readTemperature(bool fahrenheit = false, bool force = false);
+  float readHumidity(bool force = false);
+
+private:
+  uint8_t pin_;
+  unsigned long lastReadMs_ = 0;
+  bool lastResult_ = false;
+  bool haveRead_ = false;
+};
+
+void hostSetDht(uint8_t pin, float temperature, float humidity);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Wire.h"
+
+#define DHT20_OK 0
+#define DHT20_ERROR_CHECKSUM (-10)
+#define DHT20_ERROR_CONNECT (-11)
+#define DHT20_MISSING_BYTES (-12)
+#define DHT20_ERROR_BYTES_ALL_ZERO (-13)
+#define DHT20_ERROR_READ_TIMEOUT (-14)
+#define DHT20_ERROR_LASTREAD (-15)
+
+// Simulated I2C DHT20 with the asynchronous request/read/convert API.
+class DHT20 {
+public:
+  explicit DHT20(TwoWire* wire = &Wire) { (void)wire; }
+  bool begin() { return true; }
+  bool isConnected() { return true; }
+  uint8_t resetSensor() { return 0; }
+  int read();
+  int requestData();
+  int readData();
+  int convert();
+  bool isMeasuring();
+  uint32_t lastRequest() const { return lastRequest_; }
+  uint32_t lastRead() const { return lastRead_; }
+  float getTemperature() const { return temperature_; }
+  float getHumidity() const { return humidity_; }
+
+private:
+  uint32_t lastRequest_ = 0;
+  uint32_t lastRead_ = 0;
+  float temperature_ = 0;
+  float humidity_ = 0;
+};
+
+void hostSetDht20(float temperature, float humidity);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// RAM-backed filesystem shared by every fs::FS instance. Files survive until
+// hostFsReset() is called; hostFsTruncate() simulates a write cut short by a
+// power loss.
+namespace fs {
+
+struct HostFileHandle;
+
+class File {
+public:
+  File() = default;
+  explicit File(std::shared_ptr<HostFileHandle> handle) : handle_(std::move(handle)) {}
+
+  size_t write(const uint8_t* buf, size_t size);
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t read(uint8_t* buf, size_t size);
+  int read();
+  int available();
+  bool seek(uint32_t pos);
+  size_t position() const;
+  size_t size() const;
+  void flush() {}
+  void close() { handle_.reset(); }
+  const char* name() const;   // last path component
+  const char* path() const;
+  bool isDirectory() const;
+  File openNextFile(const char* mode = "r");
+  operator bool() const { return handle_ != nullptr; }
+
+private:
+  std::shared_ptr<HostFileHandle> handle_;
+};
+
+class FS {
+public:
+  File open(const char* path, const char* mode = "r", bool create = false);
+  File open(const String& path, const char* mode = "r", bool create = false) { return open(path.c_str(), mode, create); }
+  bool exists(const char* path);
+  bool exists(const String& path) { return exists(path.c_str()); }
+  bool remove(const char* path);
+  bool remove(const String& path) { return remove(path.c_str()); }
+  bool rename(const char* from, const char* to);
+  bool mkdir(const char* path);
+  bool mkdir(const String& path) { return mkdir(path.c_str()); }
+  bool rmdir(const char* path);
+};
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+
+void hostFsReset();
+bool hostFsTruncate(const char* path, size_t size);
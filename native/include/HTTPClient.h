@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+#include "WiFiClient.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+// Request/response recorder: requests are captured and answered by a host
+// handler, or refused when none is installed.
+struct HostHttpRequest {
+  String method;
+  String url;
+  String contentType;
+  String authorization;
+  std::string body;
+};
+
+typedef int (*HostHttpHandler)(const HostHttpRequest& req, String& responseBody);
+void hostSetHttpHandler(HostHttpHandler handler);
+
+class HTTPClient {
+public:
+  bool begin(const String& url);
+  bool begin(WiFiClient& client, const String& url);
+  void end();
+  void setReuse(bool reuse) { reuse_ = reuse; }
+  void setTimeout(uint16_t ms) { (void)ms; }
+  void setConnectTimeout(int32_t ms) { (void)ms; }
+  bool connected() { return connected_; }
+  void addHeader(const String& name, const String& value, bool first = false, bool replace = true);
+  int GET();
+  int POST(const String& payload);
+  int POST(uint8_t* payload, size_t size);
+  int sendRequest(const char* type, uint8_t* payload, size_t size);
+  String getString() { return response_; }
+  int getSize() { return (int)response_.length(); }
+  WiFiClient& getStream() { return *client_; }
+  static String errorToString(int error);
+
+private:
+  HostHttpRequest req_;
+  String response_;
+  WiFiClient ownClient_;
+  WiFiClient* client_ = &ownClient_;
+  bool reuse_ = true;
+  bool connected_ = false;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include "WString.h"
+#include "Printable.h"
+
+class IPAddress : public Printable {
+public:
+  IPAddress() : addr_(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+  : addr_((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+  IPAddress(uint32_t addr) : addr_(addr) {}
+
+  operator uint32_t() const { return addr_; }
+  uint8_t operator[](int i) const { return (uint8_t)(addr_ >> (8 * i)); }
+  bool operator==(const IPAddress& o) const { return addr_ == o.addr_; }
+  bool operator!=(const IPAddress& o) const { return addr_ != o.addr_; }
+
+  String toString() const;
+  bool fromString(const char* s);
+  size_t printTo(Print& p) const override;
+
+private:
+  uint32_t addr_;
+};
+
+extern const IPAddress INADDR_NONE;
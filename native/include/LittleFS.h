@@ -0,0 +1,19 @@
+#pragma once
+
+#include "FS.h"
+
+namespace fs {
+
+class LittleFSFS : public FS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/littlefs",
+             uint8_t maxOpenFiles = 10, const char* partitionLabel = "spiffs");
+  bool format();
+  size_t totalBytes() { return 1441792; } // default 4 MB partition table
+  size_t usedBytes();
+  void end() {}
+};
+
+} // namespace fs
+
+extern fs::LittleFSFS LittleFS;
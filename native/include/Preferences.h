@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Arduino.h>
+
+// RAM-backed NVS replacement. Contents are shared across Preferences
+// instances (like the real flash partition) and survive until
+// hostPreferencesReset() is called.
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false, const char* partition = nullptr);
+  void end();
+  bool clear();
+  bool remove(const char* key);
+  bool isKey(const char* key);
+
+  size_t putString(const char* key, const String& value);
+  size_t putString(const char* key, const char* value);
+  String getString(const char* key, const String& defaultValue = String());
+  size_t getString(const char* key, char* value, size_t maxLen);
+  size_t putULong(const char* key, uint32_t value);
+  uint32_t getULong(const char* key, uint32_t defaultValue = 0);
+  size_t putUInt(const char* key, uint32_t value);
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+  size_t putUChar(const char* key, uint8_t value);
+  uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+  size_t putBool(const char* key, bool value);
+  bool getBool(const char* key, bool defaultValue = false);
+  size_t putBytes(const char* key, const void* value, size_t len);
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+  size_t getBytesLength(const char* key);
+
+private:
+  String ns_;
+  bool open_ = false;
+  bool readOnly_ = false;
+};
+
+void hostPreferencesReset();
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+#include "WiFiClient.h"
+#include "IPAddress.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+// Station events raised synchronously by begin() / disconnect()
+typedef enum {
+  ARDUINO_EVENT_WIFI_STA_START,
+  ARDUINO_EVENT_WIFI_STA_STOP,
+  ARDUINO_EVENT_WIFI_STA_CONNECTED,
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP,
+  ARDUINO_EVENT_WIFI_STA_LOST_IP,
+  ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+typedef int wifi_event_id_t;
+
+class WiFiClass {
+public:
+  bool mode(wifi_mode_t m) { mode_ = m; return true; }
+  wifi_mode_t getMode() const { return mode_; }
+  wl_status_t begin(const char* ssid, const char* pass = nullptr, int32_t channel = 0,
+                    const uint8_t* bssid = nullptr, bool connect = true);
+  bool config(IPAddress localIp, IPAddress gateway, IPAddress subnet,
+              IPAddress dns1 = (uint32_t)0, IPAddress dns2 = (uint32_t)0);
+  bool disconnect(bool wifioff = false, bool eraseap = false);
+  wl_status_t status() const { return status_; }
+  bool isConnected() const { return status_ == WL_CONNECTED; }
+  bool setSleep(bool enable) { (void)enable; return true; }
+  bool setAutoReconnect(bool enable) { (void)enable; return true; }
+  bool persistent(bool enable) { (void)enable; return true; }
+
+  IPAddress localIP() const { return localIp_; }
+  IPAddress gatewayIP() const { return gateway_; }
+  IPAddress subnetMask() const { return subnet_; }
+  IPAddress dnsIP(uint8_t i = 0) const { (void)i; return dns_; }
+  uint8_t* BSSID() { return bssid_; }
+  int32_t channel() const { return channel_; }
+  int8_t RSSI() const { return -60; }
+  String SSID() const { return ssid_; }
+
+  int16_t scanNetworks(bool async = false, bool hidden = false) { (void)async; (void)hidden; return 0; }
+  String SSID(uint8_t i) const { (void)i; return String(); }
+  int32_t RSSI(uint8_t i) const { (void)i; return 0; }
+  void scanDelete() {}
+
+  bool softAPConfig(IPAddress ip, IPAddress gw, IPAddress subnet) { (void)ip; (void)gw; (void)subnet; return true; }
+  bool softAP(const char* ssid, const char* pass = nullptr) { (void)ssid; (void)pass; return true; }
+  bool softAPdisconnect(bool wifioff = false) { (void)wifioff; return true; }
+
+  int hostByName(const char* host, IPAddress& result);
+
+  wifi_event_id_t onEvent(WiFiEventCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+
+  // Host hook: decide whether begin() succeeds
+  void hostSetReachable(bool reachable) { reachable_ = reachable; }
+
+private:
+  wifi_mode_t mode_ = WIFI_OFF;
+  wl_status_t status_ = WL_DISCONNECTED;
+  bool reachable_ = true;
+  String ssid_;
+  IPAddress localIp_;
+  IPAddress gateway_;
+  IPAddress subnet_;
+  IPAddress dns_;
+  uint8_t bssid_[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+  int32_t channel_ = 1;
+  struct EventHandler { WiFiEventCb cb; arduino_event_id_t event; };
+  EventHandler handlers_[8] = {};
+  int handlerCount_ = 0;
+  void raise(arduino_event_id_t event);
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "Client.h"
+
+struct HostMqttPeer; // broker emulation state of one connection (native/src/mqtt_broker.cpp)
+
+// Loopback TCP client: nothing is ever reachable on the host unless a hook
+// installs a connect handler (see hostSetTcpConnectHandler). Connections to
+// the MQTT ports (1883, 8883) reach the harness broker (hostSetMqttBroker),
+// which answers the MQTT packets written to them.
+class WiFiClient : public Client {
+public:
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  int connect(IPAddress ip, uint16_t port, int32_t timeoutMs) { (void)timeoutMs; return connect(ip, port); }
+  int connect(const char* host, uint16_t port, int32_t timeoutMs) { (void)timeoutMs; return connect(host, port); }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t* buf, size_t size) override;
+  int peek() override;
+  void flush() override {}
+  void stop() override { connected_ = false; mqttPeer_.reset(); }
+  uint8_t connected() override { return connected_; }
+  operator bool() override { return connected_; }
+  void setTimeout(uint32_t seconds) { (void)seconds; }
+  int setNoDelay(bool nodelay) { (void)nodelay; return 0; }
+  using Print::write;
+
+  // Host-side inspection of the byte stream
+  std::string txBytes;
+  std::string rxBytes;
+
+protected:
+  friend class HTTPClient; // keeps the connection open across keep-alive requests
+  bool connected_ = false;
+  std::shared_ptr<HostMqttPeer> mqttPeer_;
+};
+
+typedef bool (*HostTcpConnectHandler)(const char* host, IPAddress ip, uint16_t port);
+void hostSetTcpConnectHandler(HostTcpConnectHandler handler);
+
+// Broker stand-in: CONNECT succeeds when the harness accepts the credentials,
+// PUBLISH is forwarded to it (QoS 1 acknowledged when it returns true), MQTT 5
+// topic aliases are resolved before onPublish sees the topic.
+struct HostMqttBroker {
+  virtual ~HostMqttBroker() = default;
+  virtual bool onConnect(const char* clientId, const char* user, const char* pass, bool cleanSession) = 0;
+  virtual bool onPublish(const char* topic, const uint8_t* payload, size_t len, bool retained) = 0;
+  // false: answer an MQTT 5 CONNECT like a 3.1.1-only broker
+  virtual bool acceptsMqtt5() { return true; }
+  // Granted QoS (at most 1) or a failure code >= 0x80 for a SUBSCRIBE
+  virtual uint8_t onSubscribe(const char* topic, uint8_t qos) { (void)topic; return qos; }
+};
+void hostSetMqttBroker(HostMqttBroker* broker);
+
+// Publish to every session subscribed to topic (exact match): sent at once to
+// a connected client, kept for a persistent session's next connect (QoS 1).
+// Returns the number of sessions reached.
+size_t hostMqttSend(const char* topic, const uint8_t* payload, size_t len, uint8_t qos);
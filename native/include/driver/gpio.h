@@ -0,0 +1,14 @@
+#pragma once
+
+// Host stand-in for ESP-IDF GPIO hold control. Held pins are recorded so a
+// harness can check which rails would stay latched through deep sleep.
+
+#include "esp_sleep.h"
+
+esp_err_t gpio_hold_en(gpio_num_t gpio_num);
+esp_err_t gpio_hold_dis(gpio_num_t gpio_num);
+void gpio_deep_sleep_hold_en();
+void gpio_deep_sleep_hold_dis();
+
+// Host hook: true while gpio_hold_en() is active on the pin
+bool hostGpioHeld(uint8_t pin);
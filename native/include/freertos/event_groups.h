@@ -0,0 +1,16 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Single-threaded event groups: bits are only set by code running on the
+// caller's thread (e.g. WiFi events raised inside WiFi.begin()), so a wait
+// that is not already satisfied just advances the virtual clock by its timeout.
+typedef uint32_t EventBits_t;
+typedef struct HostEventGroup* EventGroupHandle_t;
+
+EventGroupHandle_t xEventGroupCreate();
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAll, TickType_t ticks);
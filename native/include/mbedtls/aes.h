@@ -0,0 +1,26 @@
+#pragma once
+
+// Portable software AES-128/192/256 providing the mbedtls_aes_* subset used
+// by src/lora_crypto.cpp (ECB block encrypt + CTR mode).
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MBEDTLS_AES_ENCRYPT 1
+#define MBEDTLS_AES_DECRYPT 0
+#define MBEDTLS_ERR_AES_INVALID_KEY_LENGTH (-0x0020)
+#define MBEDTLS_ERR_AES_BAD_INPUT_DATA (-0x0021)
+
+typedef struct mbedtls_aes_context {
+  int nr;
+  uint32_t rk[60];
+} mbedtls_aes_context;
+
+void mbedtls_aes_init(mbedtls_aes_context* ctx);
+void mbedtls_aes_free(mbedtls_aes_context* ctx);
+int mbedtls_aes_setkey_enc(mbedtls_aes_context* ctx, const unsigned char* key, unsigned int keybits);
+int mbedtls_aes_crypt_ecb(mbedtls_aes_context* ctx, int mode,
+                          const unsigned char input[16], unsigned char output[16]);
+int mbedtls_aes_crypt_ctr(mbedtls_aes_context* ctx, size_t length, size_t* nc_off,
+                          unsigned char nonce_counter[16], unsigned char stream_block[16],
+                          const unsigned char* input, unsigned char* output);
@@ -0,0 +1,168 @@
+// Host implementation of the Arduino core subset declared in native/include.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <stdarg.h>
+#include <map>
+
+HardwareSerial Serial;
+EspClass ESP;
+TwoWire Wire;
+const IPAddress INADDR_NONE((uint32_t)0);
+
+// Virtual clock: advances only through delay()/hostAdvanceMillis() so host
+// runs are deterministic and never actually sleep.
+static unsigned long hostMillis = 0;
+static unsigned long hostMicrosFraction = 0;
+
+unsigned long millis() { return hostMillis; }
+unsigned long micros() { return hostMillis * 1000UL + hostMicrosFraction; }
+void delay(unsigned long ms) { hostMillis += ms; }
+void delayMicroseconds(unsigned int us) {
+  hostMicrosFraction += us;
+  hostMillis += hostMicrosFraction / 1000;
+  hostMicrosFraction %= 1000;
+}
+void yield() {}
+void hostAdvanceMillis(unsigned long ms) { hostMillis += ms; }
+
+struct AnalogPin { uint16_t raw; uint32_t mv; };
+static std::map<uint8_t, AnalogPin>& analogPins() {
+  static std::map<uint8_t, AnalogPin> pins;
+  return pins;
+}
+static std::map<uint8_t, int>& digitalPins() {
+  static std::map<uint8_t, int> pins;
+  return pins;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (mode == INPUT_PULLUP && !digitalPins().count(pin)) digitalPins()[pin] = HIGH;
+}
+void digitalWrite(uint8_t pin, uint8_t val) { digitalPins()[pin] = val; }
+int digitalRead(uint8_t pin) {
+  auto it = digitalPins().find(pin);
+  return it == digitalPins().end() ? LOW : it->second;
+}
+void hostSetDigitalValue(uint8_t pin, int value) { digitalPins()[pin] = value; }
+
+void analogReadResolution(uint8_t bits) { (void)bits; }
+uint16_t analogRead(uint8_t pin) {
+  auto it = analogPins().find(pin);
+  return it == analogPins().end() ? 0 : it->second.raw;
+}
+uint32_t analogReadMilliVolts(uint8_t pin) {
+  auto it = analogPins().find(pin);
+  return it == analogPins().end() ? 0 : it->second.mv;
+}
+void hostSetAnalogValue(uint8_t pin, uint16_t raw, uint32_t millivolts) {
+  analogPins()[pin] = { raw, millivolts };
+}
+
+long random(long howbig) { return howbig > 0 ? ::random() % howbig : 0; }
+long random(long howsmall, long howbig) {
+  return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+void randomSeed(unsigned long seed) { srandom((unsigned)seed); }
+
+size_t HardwareSerial::write(uint8_t c) { return fwrite(&c, 1, 1, stdout); }
+size_t HardwareSerial::write(const uint8_t* buf, size_t size) { return fwrite(buf, 1, size, stdout); }
+int HardwareSerial::printf(const char* fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vprintf(fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+void EspClass::restart() {
+  printf("[host] ESP.restart()\n");
+  exit(0);
+}
+uint32_t EspClass::getFreeHeap() { return 320 * 1024; }
+uint32_t EspClass::getMinFreeHeap() { return 320 * 1024; }
+uint64_t EspClass::getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+
+// ---- Print ----
+
+size_t Print::print(long v, int base) {
+  char buf[34];
+  if (base == HEX) snprintf(buf, sizeof(buf), "%lX", v);
+  else snprintf(buf, sizeof(buf), "%ld", v);
+  return write(buf);
+}
+
+size_t Print::print(unsigned long v, int base) {
+  char buf[34];
+  if (base == HEX) snprintf(buf, sizeof(buf), "%lX", v);
+  else snprintf(buf, sizeof(buf), "%lu", v);
+  return write(buf);
+}
+
+size_t Print::print(double v, int digits) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", digits, v);
+  return write(buf);
+}
+
+// ---- String ----
+
+static std::string formatFloat(double v, unsigned int decimals) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+  return buf;
+}
+
+String::String(float v, unsigned int decimals) : s_(formatFloat(v, decimals)) {}
+String::String(double v, unsigned int decimals) : s_(formatFloat(v, decimals)) {}
+
+long String::toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+float String::toFloat() const { return strtof(s_.c_str(), nullptr); }
+
+int String::indexOf(char c, unsigned int from) const {
+  size_t p = s_.find(c, from);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+int String::indexOf(const String& s, unsigned int from) const {
+  size_t p = s_.find(s.s_, from);
+  return p == std::string::npos ? -1 : (int)p;
+}
+
+String String::substring(unsigned int from) const {
+  return from >= s_.size() ? String() : String(s_.substr(from));
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) { unsigned int t = from; from = to; to = t; }
+  if (from >= s_.size()) return String();
+  return String(s_.substr(from, to - from));
+}
+
+bool String::startsWith(const String& prefix) const {
+  return s_.compare(0, prefix.s_.size(), prefix.s_) == 0;
+}
+
+void String::trim() {
+  size_t b = s_.find_first_not_of(" \t\r\n");
+  size_t e = s_.find_last_not_of(" \t\r\n");
+  s_ = (b == std::string::npos) ? std::string() : s_.substr(b, e - b + 1);
+}
+
+// ---- IPAddress ----
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+  return String(buf);
+}
+
+bool IPAddress::fromString(const char* s) {
+  unsigned a, b, c, d;
+  if (!s || sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) return false;
+  if (a > 255 || b > 255 || c > 255 || d > 255) return false;
+  *this = IPAddress((uint8_t)a, (uint8_t)b, (uint8_t)c, (uint8_t)d);
+  return true;
+}
+
+size_t IPAddress::printTo(Print& p) const { return p.print(toString()); }
@@ -0,0 +1,121 @@
+// Host implementation of the ESP-IDF sleep API and simulated sensor buses.
+
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <DHT.h>
+#include <DHT20.h>
+#include <map>
+
+static uint64_t hostTimerWakeupUs = 0;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us) {
+  hostTimerWakeupUs = time_in_us;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level) {
+  (void)gpio_num; (void)level;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ext1_wakeup(uint64_t mask, esp_sleep_ext1_wakeup_mode_t mode) {
+  (void)mask; (void)mode;
+  return ESP_OK;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return ESP_SLEEP_WAKEUP_UNDEFINED; }
+
+void esp_deep_sleep_start() {
+  printf("[host] deep sleep for %llu us\n", (unsigned long long)hostTimerWakeupUs);
+  fflush(stdout);
+  exit(0);
+}
+
+// ---- GPIO hold ----
+
+static uint64_t hostHeldPins = 0;
+
+esp_err_t gpio_hold_en(gpio_num_t gpio_num) {
+  hostHeldPins |= 1ULL << gpio_num;
+  return ESP_OK;
+}
+
+esp_err_t gpio_hold_dis(gpio_num_t gpio_num) {
+  hostHeldPins &= ~(1ULL << gpio_num);
+  return ESP_OK;
+}
+
+void gpio_deep_sleep_hold_en() {}
+void gpio_deep_sleep_hold_dis() {}
+
+bool hostGpioHeld(uint8_t pin) { return (hostHeldPins >> pin) & 1; }
+
+// ---- DHT (single wire) ----
+
+struct DhtValues { float t; float h; };
+static std::map<uint8_t, DhtValues>& dhtValues() {
+  static std::map<uint8_t, DhtValues> v;
+  return v;
+}
+
+void hostSetDht(uint8_t pin, float temperature, float humidity) {
+  dhtValues()[pin] = { temperature, humidity };
+}
+
+bool DHT::read(bool force) {
+  if (!force && haveRead_ && millis() - lastReadMs_ < 2000) return lastResult_;
+  delay(25); // bit-banged transfer time
+  lastReadMs_ = millis();
+  haveRead_ = true;
+  lastResult_ = dhtValues().count(pin_) > 0;
+  return lastResult_;
+}
+
+float DHT::readTemperature(bool fahrenheit, bool force) {
+  if (!read(force)) return NAN;
+  float t = dhtValues()[pin_].t;
+  return fahrenheit ? t * 1.8f + 32.0f : t;
+}
+
+float DHT::readHumidity(bool force) {
+  if (!read(force)) return NAN;
+  return dhtValues()[pin_].h;
+}
+
+// ---- DHT20 (I2C) ----
+
+static float dht20T = 21.5f;
+static float dht20H = 48.0f;
+static constexpr uint32_t DHT20_CONVERSION_MS = 80;
+
+void hostSetDht20(float temperature, float humidity) {
+  dht20T = temperature;
+  dht20H = humidity;
+}
+
+int DHT20::requestData() {
+  lastRequest_ = millis();
+  return DHT20_OK;
+}
+
+bool DHT20::isMeasuring() { return millis() - lastRequest_ < DHT20_CONVERSION_MS; }
+
+int DHT20::readData() {
+  if (isMeasuring()) return DHT20_ERROR_READ_TIMEOUT;
+  lastRead_ = millis();
+  return 7;
+}
+
+int DHT20::convert() {
+  temperature_ = dht20T;
+  humidity_ = dht20H;
+  return DHT20_OK;
+}
+
+int DHT20::read() {
+  requestData();
+  delay(DHT20_CONVERSION_MS);
+  readData();
+  return convert();
+}
@@ -0,0 +1,39 @@
+// Host implementation of the FreeRTOS event group API (single-threaded).
+#include <freertos/event_groups.h>
+#include <Arduino.h>
+
+struct HostEventGroup {
+  EventBits_t bits = 0;
+};
+
+EventGroupHandle_t xEventGroupCreate() {
+  return new HostEventGroup();
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+  group->bits |= bits;
+  return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+  EventBits_t before = group->bits;
+  group->bits &= ~bits;
+  return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+  return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAll, TickType_t ticks) {
+  EventBits_t current = group->bits;
+  bool satisfied = waitForAll ? (current & bits) == bits : (current & bits) != 0;
+  if (!satisfied) {
+    // Nothing else runs while we wait: the timeout always expires
+    if (ticks != portMAX_DELAY) hostAdvanceMillis(ticks);
+    return group->bits;
+  }
+  if (clearOnExit) group->bits &= ~bits;
+  return current;
+}
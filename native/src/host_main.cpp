@@ -0,0 +1,57 @@
+// Entry point of the `native` environment: runs one wake cycle of sensor
+// acquisition and LoRa payload construction on the host so the logic modules
+// can be smoke-tested without a board. Unit tests bring their own main().
+
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <DHT.h>
+#include "config.h"
+#include "sensor_registry.h"
+#include "sensor_scheduler.h"
+#include "data_sender.h"
+#include "lora_payload.h"
+#include "lora_crypto.h"
+#include "lora_fcnt.h"
+#include "storage.h"
+
+int main() {
+    // Plausible readings for the pins used by the example device profiles
+    hostSetDht(21, 22.5f, 55.0f);
+    hostSetAnalogValue(32, 2000, 1600);
+    hostSetAnalogValue(0, 2300, 1900);
+
+    Storage storage;
+    fcntInit(storage);
+
+    SensorDevice* const* sensors = createSensors();
+    SensorSample samples[SENSOR_CONFIG_COUNT];
+    AcquisitionReport report = acquireSensors(sensors, SENSOR_DEVICE_COUNT, samples, SENSOR_CONFIG_COUNT);
+    printAcquisitionReport(report);
+
+    SensorReading readings[SENSOR_CONFIG_COUNT];
+    size_t count = 0;
+    for (size_t i = 0; i < report.sampleCount; ++i) {
+        if (!samples[i].ok) continue;
+        readings[count++] = { samples[i].uuid, samples[i].value };
+        Serial.printf("  %s = %.2f\n", samples[i].uuid, samples[i].value);
+    }
+
+    uint8_t plaintext[256];
+    size_t len = serializeReadings(readings, count, plaintext, sizeof(plaintext));
+    uint32_t fcnt = fcntNext(storage);
+    uint8_t nonce[16];
+    uint8_t ciphertext[256];
+    buildNonce(DEFAULT_UUID, fcnt, nonce);
+    if (len == 0 || !encryptPayload(plaintext, len, LORA_AES_KEY, nonce, ciphertext)) {
+        Serial.println("Payload construction failed");
+        return 1;
+    }
+
+    Serial.printf("LoRa payload: %u bytes, fcnt=%u\n", (unsigned)len, (unsigned)fcnt);
+    for (size_t i = 0; i < len; ++i) Serial.printf("%02X", ciphertext[i]);
+    Serial.println();
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,187 @@
+// RAM-backed LittleFS shim.
+
+#include <LittleFS.h>
+#include <map>
+#include <set>
+#include <string.h>
+
+fs::LittleFSFS LittleFS;
+
+namespace fs {
+
+struct HostFileHandle {
+  std::string path;
+  std::string name;
+  bool directory = false;
+  bool writable = false;
+  size_t pos = 0;
+  std::vector<std::string> entries; // directory listing snapshot
+  size_t nextEntry = 0;
+};
+
+} // namespace fs
+
+static std::map<std::string, std::string>& hostFiles() {
+  static std::map<std::string, std::string> files;
+  return files;
+}
+
+static std::set<std::string>& hostDirs() {
+  static std::set<std::string> dirs = { "/" };
+  return dirs;
+}
+
+static std::string parentOf(const std::string& path) {
+  size_t slash = path.find_last_of('/');
+  return slash == 0 || slash == std::string::npos ? "/" : path.substr(0, slash);
+}
+
+void hostFsReset() {
+  hostFiles().clear();
+  hostDirs() = { "/" };
+}
+
+bool hostFsTruncate(const char* path, size_t size) {
+  auto it = hostFiles().find(path);
+  if (it == hostFiles().end() || size > it->second.size()) return false;
+  it->second.resize(size);
+  return true;
+}
+
+namespace fs {
+
+size_t File::write(const uint8_t* buf, size_t size) {
+  if (!handle_ || !handle_->writable || handle_->directory) return 0;
+  std::string& data = hostFiles()[handle_->path];
+  if (handle_->pos > data.size()) handle_->pos = data.size();
+  data.replace(handle_->pos, std::min(size, data.size() - handle_->pos), (const char*)buf, size);
+  handle_->pos += size;
+  return size;
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+  if (!handle_ || handle_->directory) return 0;
+  const std::string& data = hostFiles()[handle_->path];
+  if (handle_->pos >= data.size()) return 0;
+  size_t n = std::min(size, data.size() - handle_->pos);
+  memcpy(buf, data.data() + handle_->pos, n);
+  handle_->pos += n;
+  return n;
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::available() {
+  if (!handle_ || handle_->directory) return 0;
+  size_t total = hostFiles()[handle_->path].size();
+  return handle_->pos < total ? (int)(total - handle_->pos) : 0;
+}
+
+bool File::seek(uint32_t pos) {
+  if (!handle_ || pos > size()) return false;
+  handle_->pos = pos;
+  return true;
+}
+
+size_t File::position() const { return handle_ ? handle_->pos : 0; }
+
+size_t File::size() const {
+  if (!handle_ || handle_->directory) return 0;
+  auto it = hostFiles().find(handle_->path);
+  return it == hostFiles().end() ? 0 : it->second.size();
+}
+
+const char* File::name() const { return handle_ ? handle_->name.c_str() : ""; }
+const char* File::path() const { return handle_ ? handle_->path.c_str() : ""; }
+bool File::isDirectory() const { return handle_ && handle_->directory; }
+
+File File::openNextFile(const char* mode) {
+  if (!handle_ || !handle_->directory || handle_->nextEntry >= handle_->entries.size()) return File();
+  return LittleFS.open(handle_->entries[handle_->nextEntry++].c_str(), mode);
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+  (void)create;
+  if (!path || !mode) return File();
+  std::string p = path;
+  auto handle = std::make_shared<HostFileHandle>();
+  handle->path = p;
+  handle->name = p.substr(p.find_last_of('/') + 1);
+
+  if (hostDirs().count(p)) {
+    handle->directory = true;
+    std::string prefix = p == "/" ? "/" : p + "/";
+    for (const auto& f : hostFiles()) {
+      if (f.first.compare(0, prefix.size(), prefix) == 0 && f.first.find('/', prefix.size()) == std::string::npos) {
+        handle->entries.push_back(f.first);
+      }
+    }
+    for (const auto& d : hostDirs()) {
+      if (d != p && parentOf(d) == p) handle->entries.push_back(d);
+    }
+    return File(handle);
+  }
+
+  if (!hostDirs().count(parentOf(p))) return File();
+  bool exists = hostFiles().count(p) > 0;
+  if (mode[0] == 'r') {
+    if (!exists) return File();
+    handle->writable = strchr(mode, '+') != nullptr;
+  } else if (mode[0] == 'w') {
+    hostFiles()[p].clear();
+    handle->writable = true;
+  } else if (mode[0] == 'a') {
+    handle->writable = true;
+    handle->pos = hostFiles()[p].size();
+  } else {
+    return File();
+  }
+  return File(handle);
+}
+
+bool FS::exists(const char* path) {
+  return path && (hostFiles().count(path) > 0 || hostDirs().count(path) > 0);
+}
+
+bool FS::remove(const char* path) {
+  return path && hostFiles().erase(path) > 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+  auto it = hostFiles().find(from);
+  if (it == hostFiles().end() || !hostDirs().count(parentOf(to))) return false;
+  hostFiles()[to] = it->second;
+  hostFiles().erase(from);
+  return true;
+}
+
+bool FS::mkdir(const char* path) {
+  if (!path || !hostDirs().count(parentOf(path))) return false;
+  hostDirs().insert(path);
+  return true;
+}
+
+bool FS::rmdir(const char* path) {
+  return path && std::string(path) != "/" && hostDirs().erase(path) > 0;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+  (void)formatOnFail; (void)basePath; (void)maxOpenFiles; (void)partitionLabel;
+  return true;
+}
+
+bool LittleFSFS::format() {
+  hostFsReset();
+  return true;
+}
+
+size_t LittleFSFS::usedBytes() {
+  size_t n = 0;
+  for (const auto& f : hostFiles()) n += f.second.size();
+  return n;
+}
+
+} // namespace fs
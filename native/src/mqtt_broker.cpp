@@ -0,0 +1,284 @@
+// Host MQTT broker: answers the MQTT 3.1.1 / 5 packets a WiFiClient writes to
+// an MQTT port and forwards connects, subscribes and publishes to the harness
+// broker object (hostSetMqttBroker). Keeps persistent sessions (subscriptions
+// and messages not yet delivered or acknowledged) by client id for the life of
+// the process; hostMqttSend() publishes to the device's subscriptions.
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+
+static const uint16_t HOST_RECEIVE_MAXIMUM = 8;
+static const uint16_t HOST_TOPIC_ALIAS_MAXIMUM = 8;
+
+static HostMqttBroker* mqttBroker = nullptr;
+
+struct HostMqttMessage {
+  std::string topic;
+  std::string payload;
+  uint8_t qos;
+};
+
+struct HostMqttSession {
+  bool persistent = false;
+  std::map<std::string, uint8_t> subscriptions; // topic (exact match) -> granted QoS
+  std::deque<HostMqttMessage> queued;           // QoS 1, arrived while offline
+  std::map<uint16_t, HostMqttMessage> unacked;  // sent, waiting for the PUBACK
+  uint16_t nextId = 1;
+};
+
+static std::map<std::string, HostMqttSession> sessions; // by client id
+
+void hostSetMqttBroker(HostMqttBroker* broker) { mqttBroker = broker; }
+
+struct HostMqttPeer {
+  std::string in;                      // bytes not yet parsed
+  uint8_t level = 0;                   // protocol level of the CONNECT
+  std::map<uint16_t, std::string> aliases;
+  std::string clientId;                // set once connected
+  std::string* rx = nullptr;           // receive buffer of the client
+  uint32_t maxPacket = 0;              // MQTT 5 Maximum Packet Size, 0 = none
+
+  ~HostMqttPeer();
+};
+
+static std::map<std::string, HostMqttPeer*> online; // connected peers by client id
+
+HostMqttPeer::~HostMqttPeer() {
+  auto it = online.find(clientId);
+  if (clientId.empty() || it == online.end() || it->second != this) return;
+  online.erase(it);
+  auto s = sessions.find(clientId);
+  if (s != sessions.end() && !s->second.persistent) sessions.erase(s);
+}
+
+std::shared_ptr<HostMqttPeer> hostMqttOpen() {
+  return mqttBroker ? std::make_shared<HostMqttPeer>() : nullptr;
+}
+
+namespace {
+
+struct Reader {
+  const uint8_t* p;
+  size_t left;
+
+  uint8_t u8() { if (!left) return 0; --left; return *p++; }
+  uint16_t u16() { uint16_t hi = u8(); return (uint16_t)((hi << 8) | u8()); }
+  uint32_t varInt() {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 28; shift += 7) {
+      uint8_t b = u8();
+      v |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) break;
+    }
+    return v;
+  }
+  std::string str() {
+    size_t n = u16();
+    if (n > left) n = left;
+    std::string s((const char*)p, n);
+    p += n;
+    left -= n;
+    return s;
+  }
+  void skip(size_t n) { if (n > left) n = left; p += n; left -= n; }
+  uint32_t u32() { uint32_t hi = u16(); return (hi << 16) | u16(); }
+};
+
+void putPacket(std::string& rx, uint8_t header, const std::string& body) {
+  rx.push_back((char)header);
+  uint32_t n = (uint32_t)body.size();
+  do {
+    uint8_t b = n & 0x7F;
+    n >>= 7;
+    rx.push_back((char)(n ? (b | 0x80) : b));
+  } while (n);
+  rx += body;
+}
+
+// PUBLISH to a connected device; QoS 1 waits in the session for its PUBACK
+void deliver(HostMqttPeer& peer, HostMqttSession& session, const HostMqttMessage& msg, bool dup, uint16_t id) {
+  std::string body;
+  body.push_back((char)(msg.topic.size() >> 8));
+  body.push_back((char)msg.topic.size());
+  body += msg.topic;
+  if (msg.qos > 0) {
+    if (id == 0) {
+      id = session.nextId++;
+      if (session.nextId == 0) session.nextId = 1;
+    }
+    body.push_back((char)(id >> 8));
+    body.push_back((char)id);
+  }
+  if (peer.level == 5) body.push_back(0); // no properties
+  body += msg.payload;
+
+  std::string packet;
+  putPacket(packet, (uint8_t)(0x30 | (dup ? 0x08 : 0) | (msg.qos << 1)), body);
+  if (peer.maxPacket != 0 && packet.size() > peer.maxPacket) return; // discarded, as MQTT 5 requires
+  if (msg.qos > 0) session.unacked[id] = msg;
+  *peer.rx += packet;
+}
+
+void handleConnect(HostMqttPeer& peer, Reader r, std::string& rx) {
+  r.str(); // "MQTT"
+  peer.level = r.u8();
+  uint8_t flags = r.u8();
+  r.u16(); // keep alive
+  if (peer.level == 5) {
+    if (!mqttBroker->acceptsMqtt5()) {
+      putPacket(rx, 0x20, std::string("\x00\x01", 2)); // 3.1.1: unacceptable protocol version
+      return;
+    }
+    uint32_t propsLen = r.varInt();
+    Reader props = { r.p, propsLen };
+    r.skip(propsLen);
+    while (props.left > 0) {
+      uint8_t prop = props.u8();
+      if (prop == 0x11) props.u32();                      // session expiry
+      else if (prop == 0x27) peer.maxPacket = props.u32(); // maximum packet size
+      else break; // the firmware sends no other connect property
+    }
+  }
+  std::string clientId = r.str();
+  std::string user = (flags & 0x80) ? r.str() : std::string();
+  std::string pass = (flags & 0x40) ? r.str() : std::string();
+  bool clean = (flags & 0x02) != 0;
+
+  bool ok = mqttBroker->onConnect(clientId.c_str(), user.c_str(), pass.c_str(), clean);
+  auto existing = sessions.find(clientId);
+  bool present = ok && !clean && existing != sessions.end() && existing->second.persistent;
+  if (ok && (clean || !present)) sessions[clientId] = HostMqttSession();
+  if (ok) {
+    sessions[clientId].persistent = !clean;
+    auto other = online.find(clientId);
+    if (other != online.end()) other->second->clientId.clear(); // taken over
+    peer.clientId = clientId;
+    online[clientId] = &peer;
+  }
+
+  std::string body;
+  body.push_back((char)(present ? 1 : 0));
+  body.push_back((char)(ok ? 0 : (peer.level == 5 ? 0x87 : 5))); // not authorized
+  if (peer.level == 5) {
+    const char props[] = { 6, 0x21, 0, (char)HOST_RECEIVE_MAXIMUM, 0x22, 0, (char)HOST_TOPIC_ALIAS_MAXIMUM };
+    body.append(props, sizeof(props));
+  }
+  putPacket(rx, 0x20, body);
+  if (!ok) return;
+
+  // A resumed session gets its unacknowledged messages again, then the queued ones
+  HostMqttSession& session = sessions[clientId];
+  for (auto& m : session.unacked) deliver(peer, session, m.second, true, m.first);
+  std::deque<HostMqttMessage> queued;
+  queued.swap(session.queued);
+  for (const HostMqttMessage& m : queued) deliver(peer, session, m, false, 0);
+}
+
+void handleSubscribe(HostMqttPeer& peer, Reader r, std::string& rx) {
+  uint16_t id = r.u16();
+  if (peer.level == 5) r.skip(r.varInt()); // properties
+  std::string body;
+  body.push_back((char)(id >> 8));
+  body.push_back((char)id);
+  if (peer.level == 5) body.push_back(0);
+  HostMqttSession& session = sessions[peer.clientId];
+  while (r.left > 0) {
+    std::string topic = r.str();
+    uint8_t qos = r.u8() & 0x03;
+    uint8_t granted = mqttBroker->onSubscribe(topic.c_str(), qos);
+    if (granted < 0x80) {
+      if (granted > 1) granted = 1; // the emulation delivers QoS 0 and 1 only
+      session.subscriptions[topic] = granted;
+    }
+    body.push_back((char)granted);
+  }
+  putPacket(rx, 0x90, body);
+}
+
+void handlePublish(HostMqttPeer& peer, uint8_t header, Reader r, std::string& rx) {
+  const uint8_t qos = (header >> 1) & 0x03;
+  std::string topic = r.str();
+  uint16_t id = qos > 0 ? r.u16() : 0;
+  if (peer.level == 5) {
+    uint32_t propsLen = r.varInt();
+    Reader props = { r.p, propsLen };
+    r.skip(propsLen);
+    while (props.left > 0) {
+      uint8_t prop = props.u8();
+      if (prop == 0x23) {
+        uint16_t alias = props.u16();
+        if (!topic.empty()) peer.aliases[alias] = topic;
+        else topic = peer.aliases[alias];
+      } else {
+        break; // the firmware sends no other publish property
+      }
+    }
+  }
+
+  bool ok = mqttBroker->onPublish(topic.c_str(), r.p, r.left, (header & 0x01) != 0);
+  if (qos == 0) return;
+  std::string body;
+  body.push_back((char)(id >> 8));
+  body.push_back((char)id);
+  if (!ok && peer.level == 5) body.push_back((char)0x80); // unspecified error
+  if (ok || peer.level == 5) putPacket(rx, 0x40, body);   // 3.1.1 has no negative PUBACK
+}
+
+} // namespace
+
+size_t hostMqttSend(const char* topic, const uint8_t* payload, size_t len, uint8_t qos) {
+  size_t reached = 0;
+  for (auto& s : sessions) {
+    auto sub = s.second.subscriptions.find(topic);
+    if (sub == s.second.subscriptions.end()) continue;
+    HostMqttMessage msg = { topic, std::string((const char*)payload, len), qos < sub->second ? qos : sub->second };
+    auto peer = online.find(s.first);
+    if (peer != online.end() && peer->second->rx) {
+      deliver(*peer->second, s.second, msg, false, 0);
+    } else if (s.second.persistent && msg.qos > 0) {
+      s.second.queued.push_back(msg);
+    } else {
+      continue;
+    }
+    ++reached;
+  }
+  return reached;
+}
+
+void hostMqttWrite(HostMqttPeer& peer, const uint8_t* buf, size_t size, std::string& rx) {
+  peer.rx = &rx;
+  peer.in.append((const char*)buf, size);
+  for (;;) {
+    // Complete packet: header, remaining length, body
+    const uint8_t* p = (const uint8_t*)peer.in.data();
+    size_t avail = peer.in.size(), pos = 1;
+    uint32_t len = 0;
+    int shift = 0;
+    bool complete = false;
+    while (pos < avail && shift < 28) {
+      uint8_t b = p[pos++];
+      len |= (uint32_t)(b & 0x7F) << shift;
+      shift += 7;
+      if (!(b & 0x80)) { complete = true; break; }
+    }
+    if (!complete || avail - pos < len) return;
+
+    uint8_t header = p[0];
+    Reader body = { p + pos, len };
+    if (mqttBroker) {
+      switch (header >> 4) {
+        case 1: handleConnect(peer, body, rx); break;
+        case 3: handlePublish(peer, header, body, rx); break;
+        case 4: sessions[peer.clientId].unacked.erase(body.u16()); break; // PUBACK
+        case 8: handleSubscribe(peer, body, rx); break;
+        case 12: putPacket(rx, 0xD0, std::string()); break; // PINGREQ
+        default: break;
+      }
+    }
+    peer.in.erase(0, pos + len);
+  }
+}
@@ -0,0 +1,193 @@
+// Host implementation of WiFi, TCP and HTTP client shims. Nothing leaves the
+// process: connections are answered by handlers installed by the harness, or
+// refused.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <memory>
+
+WiFiClass WiFi;
+
+static HostTcpConnectHandler tcpHandler = nullptr;
+static HostHttpHandler httpHandler = nullptr;
+
+// Broker emulation (mqtt_broker.cpp)
+std::shared_ptr<HostMqttPeer> hostMqttOpen();
+void hostMqttWrite(HostMqttPeer& peer, const uint8_t* buf, size_t size, std::string& rx);
+
+void hostSetTcpConnectHandler(HostTcpConnectHandler handler) { tcpHandler = handler; }
+void hostSetHttpHandler(HostHttpHandler handler) { httpHandler = handler; }
+
+// ---- WiFi ----
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* pass, int32_t channel,
+                             const uint8_t* bssid, bool connect) {
+  (void)pass; (void)connect;
+  ssid_ = ssid ? ssid : "";
+  if (channel > 0) channel_ = channel;
+  if (bssid) memcpy(bssid_, bssid, sizeof(bssid_));
+  delay(channel > 0 && bssid ? 150 : 1500); // directed connect vs full scan
+  if (!reachable_) {
+    status_ = WL_NO_SSID_AVAIL;
+    raise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    return status_;
+  }
+  if ((uint32_t)localIp_ == 0) {
+    localIp_ = IPAddress(192, 168, 1, 50);
+    gateway_ = IPAddress(192, 168, 1, 1);
+    subnet_ = IPAddress(255, 255, 255, 0);
+    dns_ = IPAddress(192, 168, 1, 1);
+  }
+  status_ = WL_CONNECTED;
+  raise(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+  raise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  return status_;
+}
+
+bool WiFiClass::config(IPAddress localIp, IPAddress gateway, IPAddress subnet,
+                       IPAddress dns1, IPAddress dns2) {
+  (void)dns2;
+  localIp_ = localIp;
+  gateway_ = gateway;
+  subnet_ = subnet;
+  dns_ = dns1;
+  return true;
+}
+
+bool WiFiClass::disconnect(bool wifioff, bool eraseap) {
+  (void)eraseap;
+  bool wasConnected = status_ == WL_CONNECTED;
+  status_ = WL_DISCONNECTED;
+  if (wasConnected) raise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+  if (wifioff) mode_ = WIFI_OFF;
+  return true;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventCb cb, arduino_event_id_t event) {
+  if (handlerCount_ >= (int)(sizeof(handlers_) / sizeof(handlers_[0]))) return -1;
+  handlers_[handlerCount_] = { cb, event };
+  return handlerCount_++;
+}
+
+void WiFiClass::raise(arduino_event_id_t event) {
+  for (int i = 0; i < handlerCount_; ++i) {
+    if (handlers_[i].event == event || handlers_[i].event == ARDUINO_EVENT_MAX) handlers_[i].cb(event);
+  }
+}
+
+int WiFiClass::hostByName(const char* host, IPAddress& result) {
+  if (!host || !*host) return 0;
+  if (result.fromString(host)) return 1;
+  delay(40); // simulated DNS round trip
+  result = IPAddress(10, 0, 0, 10);
+  return 1;
+}
+
+// ---- WiFiClient ----
+
+static bool isMqttPort(uint16_t port) { return port == 1883 || port == 8883; }
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+  rxBytes.clear();
+  mqttPeer_ = isMqttPort(port) ? hostMqttOpen() : nullptr;
+  connected_ = tcpHandler ? tcpHandler(nullptr, ip, port) : mqttPeer_ != nullptr;
+  if (!connected_) mqttPeer_.reset();
+  return connected_ ? 1 : 0;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+  IPAddress ip;
+  if (!WiFi.hostByName(host, ip)) return 0;
+  rxBytes.clear();
+  mqttPeer_ = isMqttPort(port) ? hostMqttOpen() : nullptr;
+  connected_ = tcpHandler ? tcpHandler(host, ip, port) : mqttPeer_ != nullptr;
+  if (!connected_) mqttPeer_.reset();
+  return connected_ ? 1 : 0;
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+  if (!connected_) return 0;
+  txBytes.append((const char*)buf, size);
+  if (mqttPeer_) hostMqttWrite(*mqttPeer_, buf, size, rxBytes);
+  return size;
+}
+
+int WiFiClient::available() { return (int)rxBytes.size(); }
+
+int WiFiClient::read() {
+  if (rxBytes.empty()) return -1;
+  uint8_t c = (uint8_t)rxBytes[0];
+  rxBytes.erase(0, 1);
+  return c;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t size) {
+  size_t n = size < rxBytes.size() ? size : rxBytes.size();
+  memcpy(buf, rxBytes.data(), n);
+  rxBytes.erase(0, n);
+  return (int)n;
+}
+
+int WiFiClient::peek() { return rxBytes.empty() ? -1 : (uint8_t)rxBytes[0]; }
+
+// ---- HTTPClient ----
+
+bool HTTPClient::begin(const String& url) {
+  client_ = &ownClient_;
+  req_ = HostHttpRequest();
+  req_.url = url;
+  return true;
+}
+
+bool HTTPClient::begin(WiFiClient& client, const String& url) {
+  client_ = &client;
+  req_ = HostHttpRequest();
+  req_.url = url;
+  return true;
+}
+
+void HTTPClient::end() {
+  if (!reuse_) {
+    connected_ = false;
+    client_->stop();
+  }
+}
+
+void HTTPClient::addHeader(const String& name, const String& value, bool first, bool replace) {
+  (void)first; (void)replace;
+  if (name == "Content-Type") req_.contentType = value;
+  else if (name == "Authorization") req_.authorization = value;
+}
+
+int HTTPClient::sendRequest(const char* type, uint8_t* payload, size_t size) {
+  req_.method = type;
+  req_.body.assign((const char*)payload, payload ? size : 0);
+  response_ = String();
+  if (!httpHandler) {
+    connected_ = false;
+    client_->stop();
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+  connected_ = true;
+  client_->connected_ = true;
+  return httpHandler(req_, response_);
+}
+
+int HTTPClient::GET() { return sendRequest("GET", nullptr, 0); }
+int HTTPClient::POST(const String& payload) {
+  return sendRequest("POST", (uint8_t*)payload.c_str(), payload.length());
+}
+int HTTPClient::POST(uint8_t* payload, size_t size) { return sendRequest("POST", payload, size); }
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+    case HTTPC_ERROR_CONNECTION_REFUSED: return "connection refused";
+    case HTTPC_ERROR_SEND_HEADER_FAILED: return "send header failed";
+    case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+    case HTTPC_ERROR_NOT_CONNECTED: return "not connected";
+    case HTTPC_ERROR_CONNECTION_LOST: return "connection lost";
+    case HTTPC_ERROR_READ_TIMEOUT: return "read Timeout";
+    default: return String();
+  }
+}
@@ -0,0 +1,92 @@
+// RAM-backed Preferences (NVS) shim.
+
+#include <Preferences.h>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, std::vector<uint8_t>> HostNamespace;
+
+static std::map<std::string, HostNamespace>& hostNvs() {
+  static std::map<std::string, HostNamespace> nvs;
+  return nvs;
+}
+
+void hostPreferencesReset() { hostNvs().clear(); }
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partition) {
+  (void)partition;
+  if (open_ || !name) return false;
+  ns_ = name;
+  readOnly_ = readOnly;
+  open_ = true;
+  return true;
+}
+
+void Preferences::end() { open_ = false; }
+
+bool Preferences::clear() {
+  if (!open_ || readOnly_) return false;
+  hostNvs().erase(ns_.c_str());
+  return true;
+}
+
+bool Preferences::remove(const char* key) {
+  if (!open_ || readOnly_) return false;
+  return hostNvs()[ns_.c_str()].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+  if (!open_) return false;
+  auto ns = hostNvs().find(ns_.c_str());
+  return ns != hostNvs().end() && ns->second.count(key) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  if (!open_ || readOnly_ || !key) return 0;
+  const uint8_t* p = (const uint8_t*)value;
+  hostNvs()[ns_.c_str()][key] = std::vector<uint8_t>(p, p + len);
+  return len;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  if (!isKey(key)) return 0;
+  return hostNvs()[ns_.c_str()][key].size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+  size_t len = getBytesLength(key);
+  if (len == 0 || len > maxLen) return 0;
+  memcpy(buf, hostNvs()[ns_.c_str()][key].data(), len);
+  return len;
+}
+
+size_t Preferences::putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+
+size_t Preferences::putString(const char* key, const char* value) {
+  return putBytes(key, value, strlen(value) + 1) ? strlen(value) : 0;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+  if (!isKey(key)) return defaultValue;
+  return String((const char*)hostNvs()[ns_.c_str()][key].data());
+}
+
+size_t Preferences::getString(const char* key, char* value, size_t maxLen) {
+  return getBytes(key, value, maxLen);
+}
+
+template <typename T>
+static T hostGet(Preferences& p, const char* key, T def) {
+  T v;
+  return p.getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : def;
+}
+
+size_t Preferences::putULong(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+uint32_t Preferences::getULong(const char* key, uint32_t defaultValue) { return hostGet(*this, key, defaultValue); }
+size_t Preferences::putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) { return hostGet(*this, key, defaultValue); }
+size_t Preferences::putUChar(const char* key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+uint8_t Preferences::getUChar(const char* key, uint8_t defaultValue) { return hostGet(*this, key, defaultValue); }
+size_t Preferences::putBool(const char* key, bool value) { return putUChar(key, value ? 1 : 0); }
+bool Preferences::getBool(const char* key, bool defaultValue) { return getUChar(key, defaultValue ? 1 : 0) != 0; }
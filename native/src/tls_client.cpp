@@ -0,0 +1,76 @@
+// Host stand-in for src/tls_client.cpp: plain TCP through the WiFiClient shim.
+// The handshake is simulated — the first connection to a host:port is a full
+// handshake, later ones resume — so the session cache and its counters can be
+// exercised without mbedtls or a server.
+
+#include "tls_client.h"
+#include "dns_cache.h"
+#include <set>
+#include <string>
+
+static const unsigned long HOST_FULL_HANDSHAKE_MS = 400;
+static const unsigned long HOST_RESUMED_HANDSHAKE_MS = 90;
+
+static std::set<std::string> sessions; // "host:port" of cached sessions
+static TlsStats stats = {};
+
+TlsClient::TlsClient() : ctx_(nullptr), peeked_(-1) {}
+
+TlsClient::~TlsClient() {}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+  if (!WiFiClient::connect(ip, port)) return 0;
+  return handshake(ip.toString().c_str(), port) ? 1 : 0;
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+  if (!dnsConnect(*this, host, port)) return 0;
+  return handshake(host, port) ? 1 : 0;
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+  (void)timeoutMs;
+  return connect(ip, port);
+}
+
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+  (void)timeoutMs;
+  return connect(host, port);
+}
+
+bool TlsClient::handshake(const char* host, uint16_t port) {
+  const std::string key = std::string(host) + ":" + std::to_string(port);
+  const bool resumed = sessions.count(key) > 0;
+  const unsigned long elapsed = resumed ? HOST_RESUMED_HANDSHAKE_MS : HOST_FULL_HANDSHAKE_MS;
+  delay(elapsed);
+  if (resumed) {
+    ++stats.resumed;
+    stats.resumedMs += elapsed;
+  } else {
+    ++stats.full;
+    stats.fullMs += elapsed;
+    sessions.insert(key);
+  }
+  Serial.printf("[TLS] %s:%u %s handshake in %lu ms\n", host, (unsigned)port,
+                resumed ? "resumed" : "full", elapsed);
+  return true;
+}
+
+size_t TlsClient::write(uint8_t c) { return WiFiClient::write(&c, 1); }
+size_t TlsClient::write(const uint8_t* buf, size_t size) { return WiFiClient::write(buf, size); }
+int TlsClient::available() { return WiFiClient::available(); }
+int TlsClient::read() { return WiFiClient::read(); }
+int TlsClient::read(uint8_t* buf, size_t size) { return WiFiClient::read(buf, size); }
+int TlsClient::peek() { return WiFiClient::peek(); }
+void TlsClient::stop() { WiFiClient::stop(); }
+// HTTPClient's shim marks a reused client connected directly
+uint8_t TlsClient::connected() { return WiFiClient::connected(); }
+
+const TlsStats& tlsStats() { return stats; }
+
+void tlsPrintStats() {
+  if (stats.full == 0 && stats.resumed == 0 && stats.failed == 0) return;
+  Serial.printf("[TLS] %u full handshakes (%lu ms), %u resumed (%lu ms), %u failed\n",
+                (unsigned)stats.full, stats.fullMs, (unsigned)stats.resumed, stats.resumedMs,
+                (unsigned)stats.failed);
+}
@@ -0,0 +1,173 @@
+#include "adc_sampler.h"
+#include "config.h"
+#include "signal_filter.h"
+#include <Arduino.h>
+
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+#define ADC_SAMPLER_USE_DMA 1
+#else
+#define ADC_SAMPLER_USE_DMA 0
+#endif
+
+AdcSampler& sharedAdcSampler() {
+    static AdcSampler sampler;
+    return sampler;
+}
+
+int AdcSampler::registerPin(int pin) {
+    for (size_t i = 0; i < count_; ++i) {
+        if (pins_[i] == pin) return (int)i;
+    }
+    if (count_ >= MAX_CHANNELS) {
+        Serial.println("ADC sampler: no free channel slot");
+        return -1;
+    }
+    pins_[count_] = pin;
+    results_[count_] = { pin, 0, 0, false };
+    return (int)count_++;
+}
+
+bool AdcSampler::usesRadioAdc() const {
+#if CONFIG_IDF_TARGET_ESP32
+    static const int ADC2_PINS[] = { 0, 2, 4, 12, 13, 14, 15, 25, 26, 27 };
+    for (size_t i = 0; i < count_; ++i) {
+        for (int pin : ADC2_PINS) {
+            if (pins_[i] == pin) return true;
+        }
+    }
+#endif
+    return false;
+}
+
+bool AdcSampler::requestBurst(int slot) {
+    if (slot < 0 || (size_t)slot >= count_) return false;
+    requested_[slot] = true;
+    ready_[slot] = false;
+    return true;
+}
+
+bool AdcSampler::poll(int slot) {
+    if (slot < 0 || (size_t)slot >= count_) return true; // take() reports the failure
+    if (running_ && !finishBurst()) return false;
+    if (requested_[slot]) {
+        beginBurst();
+        if (running_ && !finishBurst()) return false;
+    }
+    return true;
+}
+
+bool AdcSampler::take(int slot, AdcChannelResult &out) {
+    if (slot < 0 || (size_t)slot >= count_ || !ready_[slot]) return false;
+    ready_[slot] = false;
+    out = results_[slot];
+    return out.valid;
+}
+
+// Serve every channel requested so far with one burst
+void AdcSampler::beginBurst() {
+    for (size_t i = 0; i < count_; ++i) {
+        inBurst_[i] = requested_[i];
+        requested_[i] = false;
+    }
+    if (!startBurst()) {
+        for (size_t i = 0; i < count_; ++i) deliver(i, 0, 0, false);
+    }
+}
+
+void AdcSampler::deliver(size_t i, int raw, int millivolts, bool valid) {
+    if (!inBurst_[i]) return;
+    results_[i] = { pins_[i], raw, millivolts, valid };
+    inBurst_[i] = false;
+    ready_[i] = true;
+}
+
+#if ADC_SAMPLER_USE_DMA
+
+// Set from the ADC driver ISR once the conversion frame is complete
+static volatile bool burstFrameDone = false;
+
+static void IRAM_ATTR onBurstFrameDone() {
+    burstFrameDone = true;
+}
+
+bool AdcSampler::startBurst() {
+    uint8_t pins[MAX_CHANNELS];
+    for (size_t i = 0; i < count_; ++i) pins[i] = (uint8_t)pins_[i];
+
+    if (!configured_) {
+        analogContinuousSetWidth(ADC_RESOLUTION_BITS);
+        configured_ = true;
+    }
+
+    burstFrameDone = false;
+    if (!analogContinuous(pins, count_, ADC_BURST_SAMPLES, ADC_SAMPLING_FREQ_HZ, &onBurstFrameDone)) {
+        Serial.println("ADC sampler: continuous mode setup failed");
+        return false;
+    }
+    if (!analogContinuousStart()) {
+        Serial.println("ADC sampler: continuous mode start failed");
+        analogContinuousDeinit();
+        return false;
+    }
+    burstStartMs_ = millis();
+    running_ = true;
+    return true;
+}
+
+bool AdcSampler::finishBurst() {
+    if (!burstFrameDone && millis() - burstStartMs_ < ADC_BURST_TIMEOUT_MS) return false;
+
+    adc_continuous_data_t* data = nullptr;
+    bool ok = burstFrameDone && analogContinuousRead(&data, 0);
+    if (!ok) Serial.println("ADC sampler: burst timed out");
+
+    for (size_t i = 0; i < count_; ++i) {
+        bool found = false;
+        for (size_t k = 0; ok && k < count_; ++k) {
+            if (data[k].pin != pins_[i]) continue;
+            deliver(i, data[k].avg_read_raw, data[k].avg_read_mvolts, true);
+            found = true;
+            break;
+        }
+        if (!found) deliver(i, 0, 0, false);
+    }
+
+    // Release the unit so other ADC users (and the next burst) can configure it
+    analogContinuousStop();
+    analogContinuousDeinit();
+    running_ = false;
+    return true;
+}
+
+#else // oneshot fallback
+
+bool AdcSampler::startBurst() {
+    if (!configured_) {
+        analogReadResolution(ADC_RESOLUTION_BITS);
+        configured_ = true;
+    }
+
+    // Back-to-back conversions without settling delays: a few ms per burst
+    uint16_t raw[MAX_CHANNELS][ADC_BURST_SAMPLES];
+    uint16_t mv[MAX_CHANNELS][ADC_BURST_SAMPLES];
+    for (int s = 0; s < ADC_BURST_SAMPLES; ++s) {
+        for (size_t i = 0; i < count_; ++i) {
+            raw[i][s] = analogRead(pins_[i]);
+            mv[i][s] = (uint16_t)analogReadMilliVolts(pins_[i]);
+        }
+    }
+
+    // Interquartile mean: drops conversion spikes a plain average would keep
+    for (size_t i = 0; i < count_; ++i) {
+        float r = trimmedMeanOf(raw[i], ADC_BURST_SAMPLES, ADC_BURST_TRIM);
+        float m = trimmedMeanOf(mv[i], ADC_BURST_SAMPLES, ADC_BURST_TRIM);
+        deliver(i, (int)lroundf(r), (int)lroundf(m), true);
+    }
+    return true;
+}
+
+bool AdcSampler::finishBurst() {
+    return true;
+}
+
+#endif
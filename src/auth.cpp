@@ -1,10 +1,10 @@
 #include "auth.h"
-#include <HTTPClient.h>
 #include <WiFi.h>
 #include <ArduinoJson.h>
+#include "network_manager.h"
 
-AuthManager::AuthManager(Storage &storage, const char* baseUrl, const char* uuid, const char* secret, unsigned long retryIntervalMs)
-: storage(storage), baseUrl(baseUrl), uuid(uuid), secret(secret), retryIntervalMs(retryIntervalMs), lastAttempt(0) {}
+AuthManager::AuthManager(Storage &storage, HttpSession &http, const char* uuid, const char* secret, unsigned long retryIntervalMs)
+: storage(storage), http(http), uuid(uuid), secret(secret), retryIntervalMs(retryIntervalMs), lastAttempt(0) {}
 
 void AuthManager::begin() {
   // nothing for now
@@ -15,25 +15,23 @@ String AuthManager::getSavedToken() {
 }
 
 bool AuthManager::performAuthRequest() {
-  if (WiFi.status() != WL_CONNECTED) {
+  if (!networkManager().online()) {
     Serial.println("Not connected to WiFi, skipping authentication");
     return false;
   }
 
-  HTTPClient http;
-  String url = String(baseUrl) + "/api/v1/device/login";
-  Serial.print("Authenticating to: "); Serial.println(url);
-
-  http.begin(url);
-  http.addHeader("Content-Type", "application/json");
+  Serial.print("Authenticating to: "); Serial.println(http.url("/api/v1/device/login"));
 
   String payload = String("{\"uuid\":\"") + uuid + "\",\"secret\":\"" + secret + "\"}";
-  int httpCode = http.POST(payload);
+  String resp;
+  int httpCode = http.request("POST", "/api/v1/device/login", payload.c_str(), payload.length(), String(), resp);
 
   if (httpCode > 0) {
     Serial.print("HTTP response code: "); Serial.println(httpCode);
-    String resp = http.getString();
-    Serial.print("Response: "); Serial.println(resp);
+    // A successful response carries the bearer token, which is not logged
+    if (httpCode < 200 || httpCode >= 300) {
+      Serial.print("Response: "); Serial.println(resp);
+    }
 
     // Use ArduinoJson to parse response safely
     // Allocate a document with a reasonable size for expected responses
@@ -42,7 +40,6 @@ bool AuthManager::performAuthRequest() {
     DeserializationError err = deserializeJson(doc, resp);
     if (err) {
       Serial.print("Failed to parse JSON response: "); Serial.println(err.c_str());
-      http.end();
       return false;
     }
 
@@ -52,7 +49,6 @@ bool AuthManager::performAuthRequest() {
         const char* token = doc["token"];
         if (token != nullptr) {
           storage.setToken(String(token));
-          http.end();
           return true;
         }
       }
@@ -64,7 +60,6 @@ bool AuthManager::performAuthRequest() {
         }
       }
 
-      http.end();
       return false;
     }
 
@@ -76,11 +71,9 @@ bool AuthManager::performAuthRequest() {
       }
     }
 
-    http.end();
     return false;
   } else {
-    Serial.print("Request failed, error: "); Serial.println(http.errorToString(httpCode).c_str());
-    http.end();
+    Serial.print("Request failed, error: "); Serial.println(HTTPClient::errorToString(httpCode).c_str());
     return false;
   }
 }
@@ -91,9 +84,8 @@ bool AuthManager::tryAuthenticateOnce() {
 }
 
 void AuthManager::loop() {
-  if (WiFi.status() != WL_CONNECTED) return;
-  String token = storage.getToken();
-  if (token.length() > 0) return; // already have token
+  if (!networkManager().online()) return;
+  if (storage.hasToken()) return; // already have token
   unsigned long now = millis();
   if (now - lastAttempt >= retryIntervalMs) {
     lastAttempt = now;
@@ -106,7 +98,7 @@ bool AuthManager::hasMqttCredentials() {
 }
 
 bool AuthManager::performMqttCredentialsRequest() {
-  if (WiFi.status() != WL_CONNECTED) {
+  if (!networkManager().online()) {
     Serial.println("WiFi not connected, cannot fetch MQTT credentials");
     return false;
   }
@@ -117,20 +109,17 @@ bool AuthManager::performMqttCredentialsRequest() {
     return false;
   }
   
-  HTTPClient http;
-  String url = String(baseUrl) + "/api/v1/device/mqtt-credentials";
-  Serial.print("Fetching MQTT credentials from: "); Serial.println(url);
+  Serial.print("Fetching MQTT credentials from: "); Serial.println(http.url("/api/v1/device/mqtt-credentials"));
   
-  http.begin(url);
-  http.addHeader("Content-Type", "application/json");
-  http.addHeader("Authorization", String("Bearer ") + token);
-  
-  int httpCode = http.GET();
+  String response;
+  int httpCode = http.request("GET", "/api/v1/device/mqtt-credentials", nullptr, 0, token, response);
   
   if (httpCode > 0) {
     Serial.print("HTTP response code: "); Serial.println(httpCode);
-    String response = http.getString();
-    Serial.print("Response: "); Serial.println(response);
+    // A successful response carries the MQTT password, which is not logged
+    if (httpCode < 200 || httpCode >= 300) {
+      Serial.print("Response: "); Serial.println(response);
+    }
     
     if (httpCode >= 200 && httpCode < 300) {
       // Parse JSON response
@@ -141,7 +130,6 @@ bool AuthManager::performMqttCredentialsRequest() {
       if (err) {
         Serial.print("Failed to parse MQTT credentials JSON: ");
         Serial.println(err.c_str());
-        http.end();
         return false;
       }
       
@@ -150,7 +138,6 @@ bool AuthManager::performMqttCredentialsRequest() {
           !doc.containsKey("username") || 
           !doc.containsKey("password")) {
         Serial.println("Missing MQTT credential fields in response");
-        http.end();
         return false;
       }
       
@@ -160,29 +147,24 @@ bool AuthManager::performMqttCredentialsRequest() {
       
       if (server.length() == 0 || username.length() == 0 || password.length() == 0) {
         Serial.println("Empty MQTT credential fields");
-        http.end();
         return false;
       }
       
       // Store credentials
-      storage.setMqttCredentials(server, username, password);
+      if (!storage.setMqttCredentials(server, username, password)) return false;
       
       Serial.println("MQTT credentials obtained successfully:");
       Serial.print("  Server: "); Serial.println(server);
       Serial.print("  Username: "); Serial.println(username);
-      Serial.println("  Password: "); Serial.println(password); // Print actual password
 
-      http.end();
       return true;
     } else {
       Serial.println("Failed to fetch MQTT credentials - non-2xx response");
-      http.end();
       return false;
     }
   } else {
     Serial.print("HTTP request failed: ");
-    Serial.println(http.errorToString(httpCode).c_str());
-    http.end();
+    Serial.println(HTTPClient::errorToString(httpCode).c_str());
     return false;
   }
 }
@@ -1,6 +1,8 @@
 #include "sensor.h"
 #include "config.h"
 #include "sensor_creator.h"
+#include "adc_sampler.h"
+#include "signal_filter.h"
 #include <Arduino.h>
 
 /**
@@ -9,6 +11,7 @@
  * - Built-in voltage divider (2:1 ratio) on the board
  * - 12-bit ADC resolution (0-4096)
  * - Returns battery percentage based on LiPo discharge curve
+ * - Sampled through the shared ADC burst (adc_sampler.h)
  * 
  * Battery Specifications:
  * - Type: Polymer Lithium Ion Battery (single-cell LiPo)
@@ -20,33 +23,24 @@
  * - 3.7V = ~50% (nominal voltage)
  * - 3.0V = 0% (cutoff voltage)
  */
+static RTC_DATA_ATTR SignalFilterState batteryFilterState[AdcSampler::MAX_CHANNELS];
+
 class BatteryLevelSensor : public SensorBase {
 public:
-    BatteryLevelSensor(int pin, const char* uid)
-    : adc_pin_(pin), uuid_(uid) {
-        analogReadResolution(12); // Set 12-bit resolution (0-4096)
-    }
+    explicit BatteryLevelSensor(int pin)
+    : adc_pin_(pin), adcSlot_(sharedAdcSampler().registerPin(pin)) {}
     
-    const char* uuid() const override { return uuid_; }
-    
-    bool read(float &out) override {
-        analogReadResolution(12);
+    bool start() override { return sharedAdcSampler().requestBurst(adcSlot_); }
+    bool ready() override { return sharedAdcSampler().poll(adcSlot_); }
 
-        constexpr int NUM_SAMPLES = 10;
-        long sumMv = 0;
-        int lastRaw = 0;
-        for (int i = 0; i < NUM_SAMPLES; ++i) {
-            lastRaw = analogRead(adc_pin_);
-            int mv = analogReadMilliVolts(adc_pin_);
-            sumMv += mv;
-            delay(10);
-        }
-
-        int avgMv = (int)(sumMv / NUM_SAMPLES);
+    bool read(float &out) override {
+        AdcChannelResult sample;
+        if (!sharedAdcSampler().take(adcSlot_, sample)) return false;
+        int avgMv = sample.millivolts;
 
         // print out averaged values:
-        Serial.print("ADC analog value (last) = ");
-        Serial.println(lastRaw);
+        Serial.print("ADC average analog value = ");
+        Serial.println(sample.raw);
         Serial.print("ADC average millivolts = ");
         Serial.print(avgMv);
         Serial.println(" mV");
@@ -56,13 +50,20 @@ public:
         Serial.println("--------------");
 
         float batteryPercent = voltageToBatteryPercent(avgMv * 2);
-        out = batteryPercent;
+        // Load transients (radio TX) pull the cell down briefly; keep them out
+        // of the reported level (the reading fails instead)
+        if (!filterSample(batteryFilterState[adcSlot_], batteryPercent, BATTERY_MAX_STEP,
+                          BATTERY_CONFIRMATIONS, BATTERY_EMA_ALPHA, SENSORS_READ_INTERVAL_MS,
+                          filterClockMs(), out)) {
+            Serial.printf("Battery outlier rejected: %.1f%% (last accepted %.1f%%)\n", batteryPercent, out);
+            return false;
+        }
         return true;
     }
     
 private:
     int adc_pin_;
-    const char* uuid_;
+    int adcSlot_;
     
     /**
      * Convert battery voltage to percentage using LiPo discharge curve
@@ -102,5 +103,5 @@ private:
     }
 };
 
-// Auto-register with factory using standard creator template
-static bool _reg = registerSensorFactory("BatteryLevelSensor", create_sensor_impl<BatteryLevelSensor>);
+static StaticSensorPool<BatteryLevelSensor, createBatteryLevelSensor> pool;
+SensorDevice* createBatteryLevelSensor(int pin) { return pool.create(pin); }
@@ -0,0 +1,205 @@
+#include "cbor_payload.h"
+#include "data_sender.h"
+#include <math.h>
+#include <string.h>
+
+// Bounded appender: stops writing and flags overflow at the end of the buffer
+struct CborOut {
+    uint8_t* buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+};
+
+// CBOR major types (RFC 8949 section 3.1)
+static const uint8_t CBOR_UINT = 0x00;
+static const uint8_t CBOR_NEGINT = 0x20;
+static const uint8_t CBOR_BYTES = 0x40;
+static const uint8_t CBOR_TEXT = 0x60;
+static const uint8_t CBOR_ARRAY = 0x80;
+static const uint8_t CBOR_MAP = 0xa0;
+static const uint8_t CBOR_TAG = 0xc0;
+static const uint8_t CBOR_NULL = 0xf6;
+static const uint8_t CBOR_HALF = 0xf9;
+static const uint8_t CBOR_FLOAT = 0xfa;
+
+// Tag of a binary UUID (IANA CBOR tags registry)
+static const uint32_t CBOR_TAG_UUID = 37;
+
+static void put(CborOut& o, uint8_t b) {
+    if (o.len < o.size) {
+        o.buf[o.len++] = b;
+    } else {
+        o.overflow = true;
+    }
+}
+
+static void putBigEndian(CborOut& o, uint32_t v, size_t bytes) {
+    while (bytes > 0) put(o, (uint8_t)(v >> (8 * --bytes)));
+}
+
+// Initial byte of a data item with its argument in the shortest form
+static void putHead(CborOut& o, uint8_t majorType, uint32_t arg) {
+    if (arg < 24) {
+        put(o, (uint8_t)(majorType | arg));
+    } else if (arg <= 0xff) {
+        put(o, (uint8_t)(majorType | 24));
+        put(o, (uint8_t)arg);
+    } else if (arg <= 0xffff) {
+        put(o, (uint8_t)(majorType | 25));
+        putBigEndian(o, arg, 2);
+    } else {
+        put(o, (uint8_t)(majorType | 26));
+        putBigEndian(o, arg, 4);
+    }
+}
+
+static void putText(CborOut& o, const char* s) {
+    const size_t n = strlen(s);
+    putHead(o, CBOR_TEXT, (uint32_t)n);
+    for (size_t i = 0; i < n; ++i) put(o, (uint8_t)s[i]);
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Parse "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx" into 16 bytes
+static bool parseUuid(const char* s, uint8_t out[16]) {
+    size_t byte = 0;
+    for (size_t i = 0; i < 36; ++i) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (s[i] != '-') return false;
+            continue;
+        }
+        const int hi = hexDigit(s[i]);
+        const int lo = hi < 0 ? -1 : hexDigit(s[++i]);
+        if (lo < 0) return false;
+        out[byte++] = (uint8_t)((hi << 4) | lo);
+    }
+    return s[36] == '\0';
+}
+
+static void putUuid(CborOut& o, const char* uuid) {
+    uint8_t bytes[16];
+    if (!parseUuid(uuid, bytes)) {
+        putText(o, uuid);
+        return;
+    }
+    putHead(o, CBOR_TAG, CBOR_TAG_UUID);
+    putHead(o, CBOR_BYTES, sizeof(bytes));
+    for (uint8_t b : bytes) put(o, b);
+}
+
+// Half-precision bits of f if the conversion is exact
+static bool floatToHalf(float f, uint16_t& half) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    const int exp = (int)((bits >> 23) & 0xff) - 127;
+    const uint32_t mant = bits & 0x7fffff;
+
+    if (exp >= -14 && exp <= 15) {
+        if (mant & 0x1fff) return false;
+        half = (uint16_t)(sign | ((exp + 15) << 10) | (mant >> 13));
+        return true;
+    }
+    if (exp >= -24 && exp < -14) {
+        // Subnormal half: the implicit leading one becomes part of the fraction
+        const uint32_t full = mant | 0x800000;
+        const int shift = 13 + (-14 - exp);
+        if (full & ((1UL << shift) - 1)) return false;
+        half = (uint16_t)(sign | (full >> shift));
+        return true;
+    }
+    return false;
+}
+
+// Same rounding as the JSON text, in the smallest exact representation
+static void putValue(CborOut& o, float value) {
+    if (isnan(value) || fabsf(value) > 1e15f) {
+        put(o, CBOR_NULL);
+        return;
+    }
+
+    const long long scaled = llroundf(value * 100.0f);
+    if (scaled % 100 == 0) {
+        const long long whole = scaled / 100;
+        if (whole >= 0 && whole <= 0xffffffffLL) {
+            putHead(o, CBOR_UINT, (uint32_t)whole);
+            return;
+        }
+        if (whole < 0 && whole >= -0x100000000LL) {
+            putHead(o, CBOR_NEGINT, (uint32_t)(-1 - whole));
+            return;
+        }
+    }
+
+    const float rounded = (float)((double)scaled / 100.0);
+    uint16_t half;
+    if (floatToHalf(rounded, half)) {
+        put(o, CBOR_HALF);
+        putBigEndian(o, half, 2);
+        return;
+    }
+    uint32_t bits;
+    memcpy(&bits, &rounded, sizeof(bits));
+    put(o, CBOR_FLOAT);
+    putBigEndian(o, bits, 4);
+}
+
+size_t serializeReadingsCbor(const SensorReading* readings, size_t count,
+                             uint8_t* out, size_t outSize) {
+    if (out == nullptr || outSize == 0 || (readings == nullptr && count > 0)) return 0;
+
+    CborOut o = { out, outSize, 0, false };
+    putHead(o, CBOR_MAP, 1);
+    putText(o, "sensors");
+    putHead(o, CBOR_ARRAY, (uint32_t)count);
+    for (size_t i = 0; i < count && !o.overflow; ++i) {
+        putHead(o, CBOR_MAP, 2);
+        putText(o, "uuid");
+        putUuid(o, readings[i].uuid ? readings[i].uuid : "");
+        putText(o, "value");
+        putValue(o, readings[i].value);
+    }
+
+    return o.overflow ? 0 : o.len;
+}
+
+size_t serializeBatchCbor(bool nowKnown, uint32_t now, const char* const* uuids, size_t sensorCount,
+                          const uint32_t* timestamps, const float* values, size_t cycleCount,
+                          uint8_t* out, size_t outSize) {
+    if (out == nullptr || outSize == 0) return 0;
+    if (cycleCount > 0 && (uuids == nullptr || timestamps == nullptr || (values == nullptr && sensorCount > 0))) return 0;
+
+    CborOut o = { out, outSize, 0, false };
+    putHead(o, CBOR_MAP, 3);
+    putText(o, "now");
+    if (nowKnown) {
+        putHead(o, CBOR_UINT, now);
+    } else {
+        put(o, CBOR_NULL);
+    }
+    putText(o, "uuids");
+    putHead(o, CBOR_ARRAY, (uint32_t)sensorCount);
+    for (size_t s = 0; s < sensorCount && !o.overflow; ++s) {
+        putUuid(o, uuids[s] ? uuids[s] : "");
+    }
+    putText(o, "batch");
+    putHead(o, CBOR_ARRAY, (uint32_t)cycleCount);
+    for (size_t c = 0; c < cycleCount && !o.overflow; ++c) {
+        putHead(o, CBOR_MAP, 2);
+        putText(o, "ts");
+        putHead(o, CBOR_UINT, timestamps[c]);
+        putText(o, "values");
+        putHead(o, CBOR_ARRAY, (uint32_t)sensorCount);
+        const float* row = values + c * sensorCount;
+        for (size_t s = 0; s < sensorCount; ++s) putValue(o, row[s]);
+    }
+
+    return o.overflow ? 0 : o.len;
+}
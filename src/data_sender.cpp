@@ -1,107 +1,313 @@
 #include "data_sender.h"
-#include <HTTPClient.h>
 #include <WiFi.h>
-#include <ArduinoJson.h>
-#include "config.h"
 #include "mqtt_client.h"
+#include "reading_batch.h"
+#include "ts_codec.h"
+#include "cbor_payload.h"
+#include "transport_policy.h"
+#include "network_manager.h"
 
-DataSender::DataSender(Storage &storage, const char* baseUrl)
-: storage(storage), baseUrl(baseUrl), mqttClient(nullptr) {}
+// Shared by the MQTT and HTTP paths; sends happen one at a time
+static char payloadBuf[DATA_PAYLOAD_MAX_SIZE];
+
+static_assert(tsEncodedMaxSize(READING_BATCH_MAX_CYCLES, SENSOR_CONFIG_COUNT) <= DATA_PAYLOAD_MAX_SIZE,
+              "Time-series batch does not fit the payload buffer");
+
+// CBOR is never longer than the JSON bound: keys and uuids are shorter, and a
+// value is at most 5 bytes against up to 20 characters of text
+constexpr size_t cborPayloadCapacity() {
+    size_t readings = CBOR_PAYLOAD_ENVELOPE;
+    size_t batch = CBOR_BATCH_ENVELOPE + READING_BATCH_MAX_CYCLES * cborBatchCycleMaxSize(SENSOR_CONFIG_COUNT);
+    for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) {
+        readings += cborReadingMaxSize(SENSOR_CONFIGS[i].uuid);
+        batch += cborUuidMaxSize(SENSOR_CONFIGS[i].uuid);
+    }
+    return readings > batch ? readings : batch;
+}
+static_assert(cborPayloadCapacity() <= DATA_PAYLOAD_MAX_SIZE, "CBOR payload does not fit the payload buffer");
+
+// Binary payloads are published from payloadBuf and kept for a resend until
+// their PUBACK (JSON is streamed and not kept)
+static_assert(cborPayloadCapacity() <= MQTT_INFLIGHT_MAX_PAYLOAD &&
+              tsEncodedMaxSize(READING_BATCH_MAX_CYCLES, SENSOR_CONFIG_COUNT) <= MQTT_INFLIGHT_MAX_PAYLOAD,
+              "Binary payload does not fit an MQTT in-flight slot");
+
+// Content types of HTTP uploads in the binary encodings
+static const char* TS_CONTENT_TYPE = "application/x-agronos-ts";
+static const char* CBOR_CONTENT_TYPE = "application/cbor";
+
+DataSender::DataSender(Storage &storage, HttpSession &http)
+: storage(storage), http(http), mqttClient(nullptr),
+  pipelining(false), pipelineConnected(false), pipelineSends(0), pipelineIds(),
+  json(), jsonPending(false), unreachable(false), connectFailed(false) {}
+
+// JsonChunkWriter feeding a streamed MQTT publish
+static bool writeToMqtt(void* ctx, const char* data, size_t len) {
+    return static_cast<MqttClient*>(ctx)->writeSensorData((const uint8_t*)data, len);
+}
 
 void DataSender::setMqttClient(MqttClient* client) {
     mqttClient = client;
     Serial.println("MQTT client linked to DataSender");
 }
 
-String DataSender::buildUrl() const {
-    return String(baseUrl) + "/api/v1/device/data";
-}
-
-bool DataSender::postJson(const String &json, const String &token) {
-    if (WiFi.status() != WL_CONNECTED) {
+bool DataSender::postPayload(const char* body, size_t len, const char* contentType, const String &token) {
+    if (!networkManager().online()) {
         Serial.println("WiFi not connected, cannot send data");
         return false;
     }
 
-    HTTPClient http;
-    String url = buildUrl();
-    Serial.print("Posting data to: "); Serial.println(url);
+    Serial.print("Posting data to: "); Serial.println(http.url("/api/v1/device/data"));
 
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("Authorization", String("Bearer ") + token);
-
-    int code = http.POST(json);
+    String resp;
+    int code = http.request("POST", "/api/v1/device/data", body, len, token, resp, contentType);
     Serial.print("HTTP code: "); Serial.println(code);
-    String resp = http.getString();
+    // HTTPClient reports a failed DNS lookup or TCP connect as "refused"
+    connectFailed = code == HTTPC_ERROR_CONNECTION_REFUSED;
     Serial.print("Response: "); Serial.println(resp);
 
-    http.end();
     return (code >= 200 && code < 300);
 }
 
 bool DataSender::sendReadings(const SensorReading* readings, size_t count) {
+    unreachable = false;
     if (count == 0 || readings == nullptr) return false;
 
-    // Build JSON payload once (used by MQTT or HTTP) — same shape as previous HTTP payload
-    const size_t capacity = JSON_ARRAY_SIZE(count) + count * JSON_OBJECT_SIZE(2) + 512;
-    DynamicJsonDocument doc(capacity);
-    JsonArray sensorsArr = doc.createNestedArray("sensors");
-    // Round values to a fixed number of decimal places before serializing
-    constexpr int VALUE_PRECISION = 2; // number of decimal places
-    const float factor = powf(10.0f, VALUE_PRECISION);
-    for (size_t i = 0; i < count; ++i) {
-        JsonObject obj = sensorsArr.createNestedObject();
-        obj["uuid"] = readings[i].uuid;
-        float rounded = roundf(readings[i].value * factor) / factor;
-        obj["value"] = rounded;
+    // Time-series mode only applies to batches
+    if (storage.getPayloadEncoding() != PayloadEncoding::Cbor) {
+        JsonSource source = {};
+        source.readings = readings;
+        source.count = count;
+        return sendJson(source);
+    }
+
+    // Build the payload once (used by MQTT or HTTP)
+    size_t payloadLen = serializeReadingsCbor(readings, count, (uint8_t*)payloadBuf, sizeof(payloadBuf));
+    if (payloadLen == 0) {
+        Serial.println("Sensor payload does not fit the payload buffer");
+        return false;
+    }
+    return sendPayload(payloadLen, PayloadEncoding::Cbor);
+}
+
+size_t DataSender::streamJson(JsonChunkWriter write, void* ctx) const {
+    if (json.readings) return streamReadingsJson(json.readings, json.count, write, ctx);
+    return streamBatchJson(json.nowKnown, json.now, json.uuids, SENSOR_CONFIG_COUNT,
+                           json.timestamps, json.values, json.cycles, write, ctx);
+}
+
+// The JSON text is produced by the transport that sends it: streamed into
+// the MQTT publish, rendered into payloadBuf for HTTP. The length pass only
+// counts, so neither path holds the payload twice. jsonPending stays set for
+// the whole send, so MQTT streams even after an HTTP attempt rendered the text
+// (a batch is larger than an MQTT in-flight slot).
+bool DataSender::sendJson(const JsonSource& source) {
+    json = source;
+    const size_t payloadLen = streamJson(nullptr, nullptr);
+    if (payloadLen == 0) return false;
+    if (!json.readings) {
+        Serial.printf("Sending batch of %u cycles (%u bytes)\n", (unsigned)json.cycles, (unsigned)payloadLen);
+    }
+
+    jsonPending = true;
+    bool ok = sendPayload(payloadLen, PayloadEncoding::Json);
+    jsonPending = false;
+    return ok;
+}
+
+bool DataSender::sendBatch(uint32_t now) {
+    return sendCycles(batchTimestamps(), batchValues(), batchCycleCount(), true, now);
+}
+
+bool DataSender::sendCycles(const uint32_t* timestamps, const float* values, size_t cycles,
+                            bool nowKnown, uint32_t now) {
+    unreachable = false;
+    if (cycles == 0) return false;
+
+    const char* uuids[SENSOR_CONFIG_COUNT];
+    for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) uuids[i] = SENSOR_CONFIGS[i].uuid;
+
+    const PayloadEncoding encoding = storage.getPayloadEncoding();
+    if (encoding == PayloadEncoding::TimeSeries) {
+        // Values are referenced by column; the table id names the uuid order
+        static const uint32_t tableId = tsSensorTableId(uuids, SENSOR_CONFIG_COUNT);
+        size_t encodedLen = encodeTimeSeries(nowKnown, now, tableId, timestamps, values,
+                                             cycles, SENSOR_CONFIG_COUNT,
+                                             (uint8_t*)payloadBuf, sizeof(payloadBuf));
+        if (encodedLen == 0) {
+            Serial.println("Batch payload does not fit the payload buffer");
+            return false;
+        }
+        Serial.printf("Sending batch of %u cycles (%u bytes, time series, table %08lx)\n",
+                      (unsigned)cycles, (unsigned)encodedLen, (unsigned long)tableId);
+        return sendPayload(encodedLen, PayloadEncoding::TimeSeries);
+    }
+
+    if (encoding == PayloadEncoding::Cbor) {
+        size_t encodedLen = serializeBatchCbor(nowKnown, now, uuids, SENSOR_CONFIG_COUNT,
+                                               timestamps, values, cycles,
+                                               (uint8_t*)payloadBuf, sizeof(payloadBuf));
+        if (encodedLen == 0) {
+            Serial.println("Batch payload does not fit the payload buffer");
+            return false;
+        }
+        Serial.printf("Sending batch of %u cycles (%u bytes, CBOR)\n", (unsigned)cycles, (unsigned)encodedLen);
+        return sendPayload(encodedLen, PayloadEncoding::Cbor);
     }
 
-    String payload;
-    serializeJson(doc, payload);
+    JsonSource source = {};
+    source.nowKnown = nowKnown;
+    source.now = now;
+    source.uuids = uuids;
+    source.timestamps = timestamps;
+    source.values = values;
+    source.cycles = cycles;
+    return sendJson(source);
+}
 
-    // Try MQTT first if enabled and credentials are available (runtime check)
-    if (MQTT_ENABLED && mqttClient != nullptr && storage.hasMqttCredentials()) {
-        Serial.println("Attempting to send data via MQTT...");
+// Deliver the payload in payloadBuf over the transports in the order chosen
+// by the transport policy (MQTT first by default, HTTP as fallback)
+bool DataSender::sendPayload(size_t payloadLen, PayloadEncoding encoding) {
+    // JSON goes to the plain topic; binary encodings are told apart by topic suffix / content type
+    const char* binaryTopic = nullptr;
+    const char* contentType = "application/json";
+    if (encoding == PayloadEncoding::TimeSeries) {
+        binaryTopic = AGRONOS_MQTT_TOPIC_DATA_TS;
+        contentType = TS_CONTENT_TYPE;
+    } else if (encoding == PayloadEncoding::Cbor) {
+        binaryTopic = AGRONOS_MQTT_TOPIC_DATA_CBOR;
+        contentType = CBOR_CONTENT_TYPE;
+    }
 
-        // Attempt a local connect only for this publish if not already connected
-        bool connectedNow = false;
-        bool alreadyConnected = mqttClient->isConnected();
-        if (!alreadyConnected) {
-            connectedNow = mqttClient->connect();
+    // Without a link every transport would fail; that says nothing about them
+    if (!networkManager().online()) {
+        Serial.println("WiFi not connected, cannot send data");
+        unreachable = true;
+        return false;
+    }
+
+    bool tried = false;
+    bool reached = false; // a transport got through to the server, even if it refused the upload
+    Transport order[TRANSPORT_COUNT];
+    size_t count = transportPlan(order);
+    for (size_t i = 0; i < count; ++i) {
+        // Transports that are not configured are skipped without counting as failures
+        if (order[i] == Transport::Mqtt) {
+            if (!MQTT_ENABLED || mqttClient == nullptr || !storage.hasMqttCredentials()) continue;
+        } else if (!storage.hasToken()) {
+            Serial.println("No auth token available");
+            continue;
         }
 
-        bool success = false;
-        if (alreadyConnected || connectedNow) {
-            // give the MQTT/TCP stack a moment to settle after connect
-            if (connectedNow) mqttClient->process();
-
-            // publish payload created above
-            success = mqttClient->publishSensorDataPayload(payload.c_str());
-            if (success) {
-                Serial.println("Data sent successfully via MQTT");
-                if (connectedNow) mqttClient->disconnect();
-                return true;
-            } else {
-                Serial.println("MQTT publish failed, falling back to HTTP");
+        tried = true;
+        connectFailed = false;
+        unsigned long start = millis();
+        if (pipelining && pipelineSends < PIPELINE_MAX_SENDS) pipelineIds[pipelineSends] = 0;
+        bool ok = order[i] == Transport::Mqtt
+            ? sendViaMqtt(payloadLen, binaryTopic)
+            : sendViaHttp(payloadLen, contentType);
+        transportRecord(order[i], ok, (uint32_t)(millis() - start));
+        if (ok) {
+            if (pipelining) ++pipelineSends;
+            return true;
+        }
+        if (!connectFailed) reached = true;
+    }
+    unreachable = tried && !reached;
+    return false;
+}
+
+void DataSender::beginPipeline() {
+    pipelining = true;
+    pipelineConnected = false;
+    pipelineSends = 0;
+}
+
+size_t DataSender::endPipeline() {
+    if (!pipelining) return 0;
+    pipelining = false;
+
+    size_t confirmed = pipelineSends;
+    if (mqttClient != nullptr) {
+        mqttClient->flush();
+        for (size_t i = 0; i < pipelineSends && i < PIPELINE_MAX_SENDS; ++i) {
+            if (!mqttClient->delivered(pipelineIds[i])) {
+                confirmed = i;
+                break;
             }
+        }
+        if (pipelineConnected) mqttClient->disconnect();
+    }
+    if (confirmed < pipelineSends) {
+        Serial.printf("%u of %u pipelined uploads confirmed\n", (unsigned)confirmed, (unsigned)pipelineSends);
+    }
+    pipelineConnected = false;
+    pipelineSends = 0;
+    return confirmed;
+}
+
+bool DataSender::sendViaMqtt(size_t payloadLen, const char* binaryTopic) {
+    Serial.println("Attempting to send data via MQTT...");
+
+    // Attempt a local connect only for this publish if not already connected
+    bool connectedNow = false;
+    bool alreadyConnected = mqttClient->isConnected();
+    if (!alreadyConnected) {
+        connectedNow = mqttClient->connect();
+    }
+
+    bool success = false;
+    if (alreadyConnected || connectedNow) {
+        // handle anything the broker sent with CONNACK
+        if (connectedNow) mqttClient->process();
+
+        // publish the payload; in a pipeline without waiting for the PUBACK
+        uint16_t* pendingId = pipelining && pipelineSends < PIPELINE_MAX_SENDS ? &pipelineIds[pipelineSends] : nullptr;
+        if (jsonPending) {
+            // JSON goes from the encoder straight into the packet
+            success = mqttClient->beginSensorData(AGRONOS_MQTT_TOPIC_DATA, payloadLen) &&
+                      streamJson(writeToMqtt, mqttClient) == payloadLen &&
+                      mqttClient->endSensorData(pendingId);
+        } else {
+            success = mqttClient->publishSensorDataPayload((const uint8_t*)payloadBuf, payloadLen, binaryTopic, pendingId);
+        }
+        if (success) {
+            Serial.println("Data sent successfully via MQTT");
         } else {
-            Serial.println("MQTT connection failed, falling back to HTTP");
+            Serial.println("MQTT publish failed");
         }
+    } else {
+        Serial.println("MQTT connection failed");
+        // A CONNACK refusal (bad credentials) means the broker was reached
+        connectFailed = !networkManager().online() || mqttClient->state() == MQTT_STATE_CONNECT_FAILED;
+    }
 
-        if (connectedNow && !success) mqttClient->disconnect();
+    // A pipeline keeps the connection until its PUBACKs are in (endPipeline)
+    if (connectedNow && pipelining) {
+        pipelineConnected = true;
+    } else if (connectedNow) {
+        mqttClient->disconnect();
     }
+    return success;
+}
 
-    // Fallback to HTTP (or use HTTP if MQTT is not enabled/configured)
+bool DataSender::sendViaHttp(size_t payloadLen, const char* contentType) {
     Serial.println("Sending data via HTTP...");
-    
-    String token = storage.getToken();
-    if (token.length() == 0) {
-        Serial.println("No auth token available");
-        return false;
+
+    if (jsonPending) {
+        // The request body needs the whole text
+        if (payloadLen >= sizeof(payloadBuf)) {
+            Serial.println("Sensor payload does not fit the payload buffer");
+            return false;
+        }
+        JsonSource& s = json;
+        payloadLen = s.readings
+            ? serializeReadingsJson(s.readings, s.count, payloadBuf, sizeof(payloadBuf))
+            : serializeBatchJson(s.nowKnown, s.now, s.uuids, SENSOR_CONFIG_COUNT,
+                                 s.timestamps, s.values, s.cycles, payloadBuf, sizeof(payloadBuf));
     }
 
-    bool result = postJson(payload, token);
+    bool result = postPayload(payloadBuf, payloadLen, contentType, storage.getToken());
     
     if (result) {
         Serial.println("Data sent successfully via HTTP");
@@ -131,12 +337,9 @@ bool DataSender::sendValues(const float* values, size_t count) {
     }
 
     // Build UUID array from SENSOR_CONFIGS (backwards-compatible behavior)
-    const char** uuids = (const char**)malloc(sizeof(const char*) * count);
-    if (!uuids) return false;
+    const char* uuids[SENSOR_CONFIG_COUNT];
     for (size_t i = 0; i < count; ++i) {
         uuids[i] = SENSOR_CONFIGS[i].uuid;
     }
-    bool result = sendValuesWithUuids(uuids, values, count);
-    free(uuids);
-    return result;
+    return sendValuesWithUuids(uuids, values, count);
 }
@@ -0,0 +1,113 @@
+#include "device_command.h"
+#include <ArduinoJson.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+// Keep the first error: it names the field that made the command unusable
+static void reject(DeviceCommand& cmd, const char* error) {
+    if (!cmd.error) cmd.error = error;
+}
+
+// Ids are echoed into the ack unescaped, so only plain characters are accepted
+static bool copyId(const char* id, DeviceCommand& cmd) {
+    const size_t len = strlen(id);
+    if (len == 0 || len >= sizeof(cmd.id)) return false;
+    for (size_t i = 0; i < len; ++i) {
+        const char c = id[i];
+        if (!isalnum((unsigned char)c) && c != '-' && c != '_' && c != '.' && c != ':') return false;
+    }
+    memcpy(cmd.id, id, len + 1);
+    return true;
+}
+
+void parseDeviceCommand(const uint8_t* payload, size_t len, DeviceCommand& cmd) {
+    cmd = {};
+    // Strings are copied into the document: room for every byte of the payload
+    StaticJsonDocument<JSON_OBJECT_SIZE(8) + MQTT_RX_BUFFER_SIZE> doc;
+    DeserializationError err = deserializeJson(doc, payload, len);
+    if (err || !doc.is<JsonObject>()) {
+        reject(cmd, "not a JSON object");
+        return;
+    }
+
+    for (JsonPair field : doc.as<JsonObject>()) {
+        const char* key = field.key().c_str();
+        JsonVariant value = field.value();
+        if (strcmp(key, "id") == 0) {
+            char number[12];
+            const char* id = value.as<const char*>();
+            if (value.is<unsigned long>()) {
+                snprintf(number, sizeof(number), "%lu", value.as<unsigned long>());
+                id = number;
+            }
+            if (!id || !copyId(id, cmd)) reject(cmd, "invalid id");
+        } else if (strcmp(key, "read_interval_ms") == 0) {
+            if (!value.is<unsigned long>()) reject(cmd, "read_interval_ms must be a number");
+            cmd.readIntervalMs = value.as<unsigned long>();
+            cmd.fields |= COMMAND_READ_INTERVAL;
+        } else if (strcmp(key, "upload_every_cycles") == 0) {
+            if (!value.is<unsigned int>()) reject(cmd, "upload_every_cycles must be a number");
+            unsigned int cycles = value.as<unsigned int>();
+            cmd.uploadEveryCycles = cycles > 255 ? 0 : (uint8_t)cycles; // 0 fails the range check
+            cmd.fields |= COMMAND_UPLOAD_EVERY;
+        } else if (strcmp(key, "transport") == 0) {
+            const char* transport = value.as<const char*>();
+            if (transport && strcmp(transport, "mqtt") == 0) {
+                cmd.mqttEnabled = true;
+            } else if (transport && strcmp(transport, "http") == 0) {
+                cmd.mqttEnabled = false;
+            } else {
+                reject(cmd, "transport must be mqtt or http");
+            }
+            cmd.fields |= COMMAND_TRANSPORT;
+        } else if (strcmp(key, "sensor_mask") == 0) {
+            if (!value.is<unsigned long>()) reject(cmd, "sensor_mask must be a number");
+            cmd.sensorMask = (uint32_t)value.as<unsigned long>();
+            cmd.fields |= COMMAND_SENSOR_MASK;
+        } else {
+            reject(cmd, "unknown field");
+        }
+    }
+
+    if (cmd.id[0] == '\0') reject(cmd, "missing id");
+    if (cmd.fields == 0) reject(cmd, "no settings");
+}
+
+bool applyDeviceCommand(Storage& storage, DeviceCommand& cmd) {
+    if ((cmd.fields & COMMAND_READ_INTERVAL) &&
+        (cmd.readIntervalMs < COMMAND_MIN_READ_INTERVAL_MS || cmd.readIntervalMs > COMMAND_MAX_READ_INTERVAL_MS)) {
+        reject(cmd, "read_interval_ms out of range");
+    }
+    if ((cmd.fields & COMMAND_UPLOAD_EVERY) &&
+        (cmd.uploadEveryCycles < 1 || cmd.uploadEveryCycles > READING_BATCH_MAX_CYCLES)) {
+        reject(cmd, "upload_every_cycles out of range");
+    }
+    if ((cmd.fields & COMMAND_SENSOR_MASK) && (cmd.sensorMask == 0 || (cmd.sensorMask & ~SENSOR_MASK_ALL))) {
+        reject(cmd, "sensor_mask out of range");
+    }
+    if (cmd.error) return false;
+
+    DeviceConfig cfg = storage.getConfig();
+    if (cmd.fields & COMMAND_READ_INTERVAL) cfg.readIntervalMs = cmd.readIntervalMs;
+    if (cmd.fields & COMMAND_UPLOAD_EVERY) cfg.uploadEveryCycles = cmd.uploadEveryCycles;
+    if (cmd.fields & COMMAND_TRANSPORT) cfg.mqttEnabled = cmd.mqttEnabled;
+    if (cmd.fields & COMMAND_SENSOR_MASK) cfg.sensorMask = cmd.sensorMask;
+    storage.saveConfig(cfg);
+    storage.flush(); // acked as applied: must survive a reset
+    return true;
+}
+
+size_t writeCommandAck(const DeviceCommand& cmd, Storage& storage, char* out, size_t size) {
+    int n;
+    if (cmd.error) {
+        n = snprintf(out, size, "{\"id\":\"%s\",\"status\":\"rejected\",\"error\":\"%s\"}", cmd.id, cmd.error);
+    } else {
+        n = snprintf(out, size,
+                     "{\"id\":\"%s\",\"status\":\"applied\",\"read_interval_ms\":%lu,"
+                     "\"upload_every_cycles\":%u,\"transport\":\"%s\",\"sensor_mask\":%lu}",
+                     cmd.id, storage.getReadIntervalMs(), (unsigned)storage.getUploadEveryCycles(),
+                     storage.getMqttEnabled() ? "mqtt" : "http", (unsigned long)storage.getSensorMask());
+    }
+    return n > 0 && (size_t)n < size ? (size_t)n : 0;
+}
@@ -0,0 +1,49 @@
+#include "sensor.h"
+#include "config.h"
+#include "sensor_creator.h"
+#include <Arduino.h>
+#include <DHT.h>
+
+/**
+ * DHT11 Temperature and Humidity Sensor (single-wire)
+ * - One device per pin publishes two channels:
+ *   channel 0 = temperature (°C), channel 1 = relative humidity (%)
+ * - Both values come from a single bit-banged transfer per cycle
+ * - The Adafruit library has no asynchronous API, so the transfer happens
+ *   in collect() (about 25 ms with interrupts disabled)
+ */
+class DHT11Sensor : public SensorDevice {
+public:
+    explicit DHT11Sensor(int pin)
+    : pin_(pin), dht_(pin, DHT11) {
+        dht_.begin();
+    }
+
+    static constexpr size_t CHANNELS = 2;
+    size_t channelCount() const override { return CHANNELS; }
+    unsigned long minWarmupMs() const override { return DHT11_WARMUP_MS; }
+    unsigned long minReadIntervalMs() const override { return DHT11_MIN_READ_INTERVAL_MS; }
+
+    // The driver leaves the data line pulled up, which would keep the
+    // unpowered sensor alive through its protection diodes
+    void powerDown() override { pinMode(pin_, INPUT); }
+
+    bool collect(float* values) override {
+        // Force one transfer; the getters below then reuse the cached frame
+        if (!dht_.read(true)) return false;
+        float t = dht_.readTemperature();
+        float h = dht_.readHumidity();
+        if (isnan(t) || isnan(h)) return false;
+        values[0] = t;
+        values[1] = h;
+        return true;
+    }
+
+private:
+    int pin_;
+    DHT dht_;
+};
+
+// One instance per DHT11 pin listed in SENSOR_CONFIGS
+static StaticSensorPool<DHT11Sensor, createDHT11Sensor> pool;
+SensorDevice* createDHT11Sensor(int pin) { return pool.create(pin); }
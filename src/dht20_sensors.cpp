@@ -9,92 +9,81 @@
  * DHT20 Temperature and Humidity Sensor (I2C)
  * - Uses robtillaart/DHT20 library
  * - Default I2C address is 0x38
- * - Multiple readers share the same DHT20 instance to avoid I2C conflicts
+ * - One device publishes two channels from a single I2C measurement:
+ *   channel 0 = temperature (°C), channel 1 = relative humidity (%)
+ * - Split-phase: start() requests the measurement, ready() polls the busy
+ *   bit (~80 ms conversion) and fetches the frame once
  */
-
-static DHT20* getSharedDHT20() {
-    static DHT20* dht = nullptr;
-    if (!dht) {
+class DHT20Sensor : public SensorDevice {
+public:
+    explicit DHT20Sensor(int /*pin*/)
+    : dht_(&Wire) {
         // Initialize I2C with pins defined in config.h
-        Wire.begin(I2C_SDA, I2C_SCL); 
-        dht = new DHT20(&Wire);
-        if (!dht->begin()) {
+        Wire.begin(I2C_SDA, I2C_SCL);
+        ok_ = dht_.begin();
+        if (ok_) {
+            Serial.println("DHT20: Sensor initialized");
+        } else {
             Serial.println("DHT20: Failed to initialize sensor!");
-            return nullptr;
         }
-        Serial.println("DHT20: Sensor initialized");
     }
-    return dht;
-}
 
-// Guarded read wrapper: only performs I2C read if 2+ seconds have passed
-// Both temperature and humidity readers call this, but only the first triggers the actual read
-static bool readSharedDHT20() {
-    static unsigned long lastReadTime = 0;
-    DHT20* dht = getSharedDHT20();
-    if (!dht) return false;
-    
-    unsigned long now = millis();
-    const unsigned long READ_INTERVAL = 2000; // DHT20 requires 2 seconds between reads
-    
-    // Only perform an actual read if 2+ seconds have passed
-    if (now - lastReadTime >= READ_INTERVAL) {
-        int status = dht->read();
+    static constexpr size_t CHANNELS = 2;
+    size_t channelCount() const override { return CHANNELS; }
+    unsigned long minWarmupMs() const override { return DHT20_WARMUP_MS; }
+
+    bool start() override {
+        // A power-gated sensor is off while the constructor runs
+        if (!ok_) ok_ = dht_.begin();
+        if (!ok_) return false;
+        // Freshly powered: reload the calibration registers if the status asks for it
+        if (powerPin() >= 0) dht_.resetSensor();
+        int status = dht_.requestData();
         if (status != DHT20_OK) {
-            Serial.print("DHT20 Read Error: ");
+            Serial.print("DHT20 Request Error: ");
             Serial.println(status);
             return false;
         }
-        lastReadTime = now;
+        pending_ = true;
+        valid_ = false;
+        return true;
     }
-    
-    return true;
-}
 
-class DHT20TemperatureReader : public SensorBase {
-public:
-    DHT20TemperatureReader(int pin, const char* uid)
-    : uuid_(uid), dht_(getSharedDHT20()) {}
-    
-    const char* uuid() const override { return uuid_; }
-    
-    bool read(float &out) override {
-        if (!dht_) return false;
-        
-        // Use guarded read (only performs I2C transaction once per 2 seconds)
-        if (!readSharedDHT20()) return false;
-        
-        out = dht_->getTemperature();
+    bool ready() override {
+        if (!pending_) return true;
+
+        // The datasheet asks for 80 ms before polling the busy bit
+        const unsigned long CONVERSION_MS = 80;
+        if (millis() - dht_.lastRequest() < CONVERSION_MS || dht_.isMeasuring()) return false;
+
+        pending_ = false;
+        if (dht_.readData() <= 0) {
+            Serial.println("DHT20 Read Error: no data");
+            return true;
+        }
+        int status = dht_.convert();
+        if (status != DHT20_OK) {
+            Serial.print("DHT20 Read Error: ");
+            Serial.println(status);
+            return true;
+        }
+        valid_ = true;
         return true;
     }
-    
-private:
-    const char* uuid_;
-    DHT20* dht_;
-};
 
-class DHT20HumidityReader : public SensorBase {
-public:
-    DHT20HumidityReader(int pin, const char* uid)
-    : uuid_(uid), dht_(getSharedDHT20()) {}
-    
-    const char* uuid() const override { return uuid_; }
-    
-    bool read(float &out) override {
-        if (!dht_) return false;
-        
-        // Use guarded read (only performs I2C transaction once per 2 seconds)
-        if (!readSharedDHT20()) return false;
-        
-        out = dht_->getHumidity();
+    bool collect(float* values) override {
+        if (!valid_) return false;
+        values[0] = dht_.getTemperature();
+        values[1] = dht_.getHumidity();
         return true;
     }
-    
+
 private:
-    const char* uuid_;
-    DHT20* dht_;
+    DHT20 dht_;
+    bool ok_ = false;
+    bool pending_ = false;
+    bool valid_ = false;
 };
 
-// Register the factory creators
-static bool _reg_temp = registerSensorFactory("DHT20TemperatureReader", create_sensor_impl<DHT20TemperatureReader>);
-static bool _reg_hum = registerSensorFactory("DHT20HumidityReader", create_sensor_impl<DHT20HumidityReader>);
+static StaticSensorPool<DHT20Sensor, createDHT20Sensor> pool;
+SensorDevice* createDHT20Sensor(int pin) { return pool.create(pin); }
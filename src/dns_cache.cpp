@@ -0,0 +1,96 @@
+#include "dns_cache.h"
+#include "config.h"
+#include "crc32.h"
+#include <WiFi.h>
+#include <string.h>
+#include <time.h>
+
+struct DnsEntry {
+    uint32_t key;        // crc32 of the host name, 0 = empty
+    uint32_t ip;
+    uint32_t resolvedAt; // device clock (s) of the lookup
+};
+RTC_DATA_ATTR static DnsEntry rtcDns[DNS_CACHE_SLOTS];
+RTC_DATA_ATTR static uint8_t rtcNextEntry = 0;
+
+static uint32_t hostKey(const char* host) {
+    uint32_t key = crc32(host, strlen(host));
+    return key != 0 ? key : 1;
+}
+
+static DnsEntry* findEntry(uint32_t key) {
+    for (DnsEntry& entry : rtcDns) {
+        if (entry.key == key) return &entry;
+    }
+    return nullptr;
+}
+
+static bool cachedAddress(const char* host, IPAddress& ip) {
+    DnsEntry* entry = findEntry(hostKey(host));
+    if (!entry) return false;
+    const uint32_t now = (uint32_t)time(nullptr);
+    // A clock set backwards (NTP) since the lookup also expires the entry
+    if (now < entry->resolvedAt || now - entry->resolvedAt >= DNS_CACHE_TTL_S) {
+        entry->key = 0;
+        return false;
+    }
+    ip = IPAddress(entry->ip);
+    return true;
+}
+
+static bool liveLookup(const char* host, IPAddress& ip) {
+    const unsigned long start = millis();
+    if (!WiFi.hostByName(host, ip)) {
+        Serial.printf("[DNS] Lookup of %s failed\n", host);
+        return false;
+    }
+    Serial.printf("[DNS] %s -> %s in %lu ms\n", host, ip.toString().c_str(), millis() - start);
+
+    const uint32_t key = hostKey(host);
+    DnsEntry* entry = findEntry(key);
+    if (!entry) {
+        entry = &rtcDns[rtcNextEntry];
+        rtcNextEntry = (uint8_t)((rtcNextEntry + 1) % DNS_CACHE_SLOTS);
+    }
+    entry->key = key;
+    entry->ip = (uint32_t)ip;
+    entry->resolvedAt = (uint32_t)time(nullptr);
+    return true;
+}
+
+bool dnsResolve(const char* host, IPAddress& ip) {
+    if (!host || !*host) return false;
+    if (ip.fromString(host)) return true;
+    return cachedAddress(host, ip) || liveLookup(host, ip);
+}
+
+void dnsForget(const char* host) {
+    DnsEntry* entry = findEntry(hostKey(host));
+    if (entry) entry->key = 0;
+}
+
+static int tcpConnect(WiFiClient& client, IPAddress ip, uint16_t port, int32_t timeoutMs) {
+    // Qualified calls: a TCP connect even when client overrides connect()
+    return timeoutMs < 0 ? client.WiFiClient::connect(ip, port)
+                         : client.WiFiClient::connect(ip, port, timeoutMs);
+}
+
+int dnsConnect(WiFiClient& client, const char* host, uint16_t port, int32_t timeoutMs) {
+    IPAddress ip;
+    if (!host || !*host) return 0;
+    if (ip.fromString(host)) return tcpConnect(client, ip, port, timeoutMs);
+
+    if (cachedAddress(host, ip)) {
+        if (tcpConnect(client, ip, port, timeoutMs)) return 1;
+        // The host may have moved: look it up again, but do not retry the
+        // same address
+        dnsForget(host);
+        const IPAddress cached = ip;
+        if (!liveLookup(host, ip) || ip == cached) return 0;
+        Serial.printf("[DNS] %s moved, retrying\n", host);
+        return tcpConnect(client, ip, port, timeoutMs);
+    }
+
+    if (!liveLookup(host, ip)) return 0;
+    return tcpConnect(client, ip, port, timeoutMs);
+}
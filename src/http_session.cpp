@@ -0,0 +1,56 @@
+#include "http_session.h"
+#include <string.h>
+
+HttpSession::HttpSession(const char* baseUrl)
+: baseUrl(baseUrl), secure(strncmp(baseUrl, "https://", 8) == 0), stats_() {
+    http.setReuse(true);
+}
+
+WiFiClient& HttpSession::transport() {
+    if (secure) return secureClient;
+    return plainClient;
+}
+
+int HttpSession::request(const char* method, const char* path, const char* body, size_t len,
+                         const String &bearerToken, String &response,
+                         const char* contentType) {
+    WiFiClient &client = transport();
+    const bool warm = client.connected();
+    const unsigned long start = millis();
+
+    http.begin(client, url(path));
+    http.addHeader("Content-Type", contentType);
+    if (bearerToken.length() > 0) {
+        http.addHeader("Authorization", String("Bearer ") + bearerToken);
+    }
+
+    int code = http.sendRequest(method, (uint8_t*)body, body ? len : 0);
+    response = code > 0 ? http.getString() : String();
+    // Keeps the socket open when the server allows it (HTTP/1.1 keep-alive)
+    http.end();
+
+    const unsigned long elapsed = millis() - start;
+    ++stats_.requests;
+    if (code <= 0) {
+        ++stats_.failures;
+        client.stop(); // never reuse a socket in an unknown state
+    } else if (warm) {
+        ++stats_.reuses;
+        stats_.reuseMs += elapsed;
+    } else {
+        ++stats_.connects;
+        stats_.connectMs += elapsed;
+    }
+    return code;
+}
+
+void HttpSession::close() {
+    http.end();
+    transport().stop();
+}
+
+void HttpSession::printStats() const {
+    Serial.printf("[HTTP] %u requests: %u new connections (%lu ms), %u reused (%lu ms), %u failed\n",
+                  (unsigned)stats_.requests, (unsigned)stats_.connects, stats_.connectMs,
+                  (unsigned)stats_.reuses, stats_.reuseMs, (unsigned)stats_.failures);
+}
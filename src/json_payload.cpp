@@ -0,0 +1,189 @@
+#include "json_payload.h"
+#include "data_sender.h"
+#include <math.h>
+
+// Bounded appender: stops writing and flags overflow at the end of the buffer.
+// When streaming, buf is a chunk handed to write (if any) each time it fills,
+// and overflow means the writer failed.
+struct JsonOut {
+    char* buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+    bool streaming;
+    JsonChunkWriter write;
+    void* ctx;
+    size_t flushed; // streaming: bytes already passed on
+};
+
+static void flush(JsonOut& o) {
+    if (o.len == 0 || o.overflow) return;
+    if (o.write && !o.write(o.ctx, o.buf, o.len)) o.overflow = true;
+    o.flushed += o.len;
+    o.len = 0;
+}
+
+static void put(JsonOut& o, char c) {
+    if (o.len + 1 >= o.size && o.streaming) flush(o);
+    if (o.len + 1 < o.size && !o.overflow) {
+        o.buf[o.len++] = c;
+    } else {
+        o.overflow = true;
+    }
+}
+
+static void put(JsonOut& o, const char* s) {
+    while (*s) put(o, *s++);
+}
+
+static void putEscaped(JsonOut& o, const char* s) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    for (; *s; ++s) {
+        const unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            put(o, '\\');
+            put(o, (char)c);
+        } else if (c < 0x20) {
+            put(o, "\\u00");
+            put(o, HEX_DIGITS[c >> 4]);
+            put(o, HEX_DIGITS[c & 0x0F]);
+        } else {
+            put(o, (char)c);
+        }
+    }
+}
+
+// Integer formatting of value * 100: no printf, no float-to-text conversion
+static void putValue(JsonOut& o, float value) {
+    if (isnan(value) || fabsf(value) > 1e15f) {
+        put(o, "null");
+        return;
+    }
+
+    long long scaled = llroundf(value * 100.0f);
+    if (scaled < 0) {
+        put(o, '-');
+        scaled = -scaled;
+    }
+    unsigned long long whole = (unsigned long long)scaled / 100;
+    unsigned int frac = (unsigned int)((unsigned long long)scaled % 100);
+
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + whole % 10);
+        whole /= 10;
+    } while (whole > 0);
+    while (n > 0) put(o, digits[--n]);
+
+    if (frac != 0) {
+        put(o, '.');
+        put(o, (char)('0' + frac / 10));
+        if (frac % 10) put(o, (char)('0' + frac % 10));
+    }
+}
+
+static void putUnsigned(JsonOut& o, uint32_t v) {
+    char digits[10];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    while (n > 0) put(o, digits[--n]);
+}
+
+static void encodeReadings(JsonOut& o, const SensorReading* readings, size_t count) {
+    put(o, "{\"sensors\":[");
+    for (size_t i = 0; i < count && !o.overflow; ++i) {
+        if (i > 0) put(o, ',');
+        put(o, "{\"uuid\":\"");
+        putEscaped(o, readings[i].uuid ? readings[i].uuid : "");
+        put(o, "\",\"value\":");
+        putValue(o, readings[i].value);
+        put(o, '}');
+    }
+    put(o, "]}");
+}
+
+static void encodeBatch(JsonOut& o, bool nowKnown, uint32_t now, const char* const* uuids, size_t sensorCount,
+                        const uint32_t* timestamps, const float* values, size_t cycleCount) {
+    put(o, "{\"now\":");
+    if (nowKnown) {
+        putUnsigned(o, now);
+    } else {
+        put(o, "null");
+    }
+    put(o, ",\"uuids\":[");
+    for (size_t s = 0; s < sensorCount && !o.overflow; ++s) {
+        if (s > 0) put(o, ',');
+        put(o, '"');
+        putEscaped(o, uuids[s] ? uuids[s] : "");
+        put(o, '"');
+    }
+    put(o, "],\"batch\":[");
+    for (size_t c = 0; c < cycleCount && !o.overflow; ++c) {
+        if (c > 0) put(o, ',');
+        put(o, "{\"ts\":");
+        putUnsigned(o, timestamps[c]);
+        put(o, ",\"values\":[");
+        const float* row = values + c * sensorCount;
+        for (size_t s = 0; s < sensorCount; ++s) {
+            if (s > 0) put(o, ',');
+            putValue(o, row[s]);
+        }
+        put(o, "]}");
+    }
+    put(o, "]}");
+}
+
+static bool validBatch(const char* const* uuids, size_t sensorCount, const uint32_t* timestamps,
+                       const float* values, size_t cycleCount) {
+    return cycleCount == 0 || (uuids != nullptr && timestamps != nullptr && (values != nullptr || sensorCount == 0));
+}
+
+size_t serializeReadingsJson(const SensorReading* readings, size_t count,
+                             char* out, size_t outSize) {
+    if (out == nullptr || outSize == 0 || (readings == nullptr && count > 0)) return 0;
+
+    JsonOut o = { out, outSize, 0, false, false, nullptr, nullptr, 0 };
+    encodeReadings(o, readings, count);
+
+    out[o.len] = '\0';
+    return o.overflow ? 0 : o.len;
+}
+
+size_t serializeBatchJson(bool nowKnown, uint32_t now, const char* const* uuids, size_t sensorCount,
+                          const uint32_t* timestamps, const float* values, size_t cycleCount,
+                          char* out, size_t outSize) {
+    if (out == nullptr || outSize == 0) return 0;
+    if (!validBatch(uuids, sensorCount, timestamps, values, cycleCount)) return 0;
+
+    JsonOut o = { out, outSize, 0, false, false, nullptr, nullptr, 0 };
+    encodeBatch(o, nowKnown, now, uuids, sensorCount, timestamps, values, cycleCount);
+
+    out[o.len] = '\0';
+    return o.overflow ? 0 : o.len;
+}
+
+size_t streamReadingsJson(const SensorReading* readings, size_t count, JsonChunkWriter write, void* ctx) {
+    if (readings == nullptr && count > 0) return 0;
+
+    char chunk[JSON_STREAM_CHUNK_SIZE + 1];
+    JsonOut o = { chunk, sizeof(chunk), 0, false, true, write, ctx, 0 };
+    encodeReadings(o, readings, count);
+    flush(o);
+    return o.overflow ? 0 : o.flushed;
+}
+
+size_t streamBatchJson(bool nowKnown, uint32_t now, const char* const* uuids, size_t sensorCount,
+                       const uint32_t* timestamps, const float* values, size_t cycleCount,
+                       JsonChunkWriter write, void* ctx) {
+    if (!validBatch(uuids, sensorCount, timestamps, values, cycleCount)) return 0;
+
+    char chunk[JSON_STREAM_CHUNK_SIZE + 1];
+    JsonOut o = { chunk, sizeof(chunk), 0, false, true, write, ctx, 0 };
+    encodeBatch(o, nowKnown, now, uuids, sensorCount, timestamps, values, cycleCount);
+    flush(o);
+    return o.overflow ? 0 : o.flushed;
+}
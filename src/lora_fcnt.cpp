@@ -26,6 +26,7 @@ void fcntInit(Storage& storage) {
 
     // Persist the jumped value immediately so the next cold boot starts even higher
     storage.setLoraFcnt(rtcFcnt);
+    storage.flush();
 
     Serial.printf("[FCNT] Cold boot: NVS=%u, starting at %u (gap=%u)\n",
                   nvsFcnt, rtcFcnt, FCNT_COLD_BOOT_GAP);
@@ -38,6 +39,7 @@ uint32_t fcntNext(Storage& storage) {
     // Lazy save: write to NVS only every N transmissions to reduce flash wear
     if (txSinceLastSave >= FCNT_NVS_SAVE_INTERVAL) {
         storage.setLoraFcnt(rtcFcnt);
+        storage.flush();
         txSinceLastSave = 0;
         Serial.printf("[FCNT] Saved to NVS: %u\n", rtcFcnt);
     }
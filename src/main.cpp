@@ -7,13 +7,26 @@
 #include "wifi_portal.h"
 #include "storage.h"
 #include "auth.h"
+#include "http_session.h"
+#include "tls_client.h"
 #include <HTTPClient.h>
 #include "config.h"
 #include "data_sender.h"
 #include <math.h>
 
-#include "sensor.h"
+#include "sensor_registry.h"
+#include "sensor_scheduler.h"
+#include "reading_batch.h"
+#include "offline_queue.h"
+#include "transport_policy.h"
+#include "adc_sampler.h"
+#include "wifi_connect.h"
+#include "network_manager.h"
+#include "spsc_queue.h"
 #include <esp_sleep.h>
+#include <time.h>
+#include <string.h>
+#include <atomic>
 
 #include "mqtt_client.h"
 
@@ -23,28 +36,69 @@ const char* apPass = AP_PASS; // optional
 // Replace global Preferences with Storage instance
 Storage storage;
 
-// Runtime configuration variables (loaded from storage in setup)
+// Runtime configuration variables (loaded from storage in setup); in
+// always-on mode only the service task reads or reloads them
 String baseUrl;
 bool mqttEnabled;
 unsigned long readIntervalMs;
+uint8_t uploadEveryCycles;
+bool alwaysOn;
+// Sensors read and uploaded; changed by remote commands while the loop task samples
+static std::atomic<uint32_t> sensorMask{SENSOR_MASK_ALL};
 
 // These will be constructed after loading config
 WifiPortal* portal = nullptr;
+HttpSession* http = nullptr;
 AuthManager* auth = nullptr;
 DataSender* sender = nullptr;
 MqttClient* mqttClient = nullptr;
 
 // (timing handled by deep sleep across boots)
 
+// While the portal is open and WiFi is down, loop() blocks this long on the
+// network events between portal requests instead of spinning (the service
+// task, in always-on mode, on its notification)
+constexpr unsigned long PORTAL_SERVICE_INTERVAL_MS = 20;
+
 // Backoff for failed send attempts while connected (ms)
 constexpr unsigned long SEND_RETRY_BACKOFF_MS = 10UL * 1000UL; // 30s
 static unsigned long lastSendAttempt = 0;
 
-// Sensor instances created from config
-static std::vector<std::unique_ptr<SensorBase>> sensors;
-
-// Forward declaration for one-time provisioning function
+// Sensor devices created from config (static storage, see sensor_registry.h)
+static SensorDevice* const* sensors = nullptr;
+static bool firstReadLogged = false;
+
+// Saved network credentials exist (portal started only for a limited window)
+static bool hasWifiCreds = false;
+
+// Network bring-up task (runs while the sensors are read, see startNetworkTask)
+constexpr uint32_t NETWORK_TASK_STACK_SIZE = 12 * 1024; // bytes; TLS handshake for https BASE_URL
+static TaskHandle_t setupTask = nullptr;
+
+// Always-on mode: cycles sampled by the loop task, waiting for the service
+// task that owns WiFi, auth and MQTT (see startAlwaysOn)
+struct LiveCycle {
+    uint32_t timestamp;
+    float values[SENSOR_CONFIG_COUNT];
+};
+static SpscQueue<LiveCycle, ALWAYS_ON_QUEUE_CYCLES> liveQueue;
+static TaskHandle_t serviceTask = nullptr;
+static unsigned long nextSampleAt = 0;
+// Counters of the [LIVE] report; sampled/dropped are written by the loop task
+static std::atomic<uint32_t> liveSampled{0};
+static std::atomic<uint32_t> liveDropped{0};
+static uint32_t livePublished = 0;
+static uint32_t liveStored = 0;
+
+// Forward declarations
 static void oneTimeProvisioning();
+static bool startNetworkTask();
+static void waitNetworkTask();
+static void captureBatchCycle();
+static bool storeOffline();
+static void enterDeepSleep();
+static void startAlwaysOn();
+static void reloadConfig();
 
 // Check if button is held for more than 10 seconds to reset all storage
 static void checkButtonReset() {
@@ -70,15 +124,9 @@ void tryAutoConnect() {
   String ssid, pass;
   if (!storage.getWifiCreds(ssid, pass)) return;
   if (ssid.length() == 0) return;
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(ssid.c_str(), pass.c_str());
-  unsigned long start = millis();
-  while (millis() - start < 10000) {
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.println("Connected to saved WiFi");
-      return;
-    }
-    delay(200);
+  if (wifiConnect(storage, ssid, pass)) {
+    Serial.println("Connected to saved WiFi");
+    return;
   }
   Serial.println("Failed to connect to saved WiFi");
   //storage.setWifiCreds("", ""); // clear invalid creds
@@ -95,11 +143,18 @@ void setup()
     // Check for long press to reset storage
     checkButtonReset();
 
+    // Track the WiFi station through driver events from the first connect on
+    networkManager().begin();
+
     // Initialize storage defaults from config.h
     DeviceConfig defaults = {
         .baseUrl = BASE_URL,
         .readIntervalMs = SENSORS_READ_INTERVAL_MS,
-        .mqttEnabled = MQTT_ENABLED
+        .mqttEnabled = MQTT_ENABLED,
+        .uploadEveryCycles = UPLOAD_EVERY_CYCLES,
+        .payloadEncoding = PAYLOAD_ENCODING,
+        .alwaysOn = ALWAYS_ON,
+        .sensorMask = SENSOR_MASK_ALL
     };
     storage.loadDefaults(defaults);
 
@@ -107,41 +162,89 @@ void setup()
     baseUrl = storage.getBaseUrl();
     readIntervalMs = storage.getReadIntervalMs();
     mqttEnabled = storage.getMqttEnabled();
+    uploadEveryCycles = storage.getUploadEveryCycles();
+    alwaysOn = storage.getAlwaysOn();
+    sensorMask = storage.getSensorMask();
     
     Serial.println("Device Configuration:");
     Serial.print("  Base URL: "); Serial.println(baseUrl);
     Serial.print("  MQTT Enabled: "); Serial.println(mqttEnabled ? "Yes" : "No");
     Serial.print("  Read Interval: "); Serial.print(readIntervalMs / 1000); Serial.println(" seconds");
+    Serial.print("  Upload Every: "); Serial.print(uploadEveryCycles); Serial.println(" readings");
+    Serial.print("  Always On: "); Serial.println(alwaysOn ? "Yes" : "No");
+    Serial.printf("  Sensors Enabled: %u of %u\n", (unsigned)__builtin_popcount(sensorMask.load()),
+                  (unsigned)SENSOR_CONFIG_COUNT);
+    Serial.print("  Payload Encoding: ");
+    switch (storage.getPayloadEncoding()) {
+        case PayloadEncoding::TimeSeries: Serial.println("time series"); break;
+        case PayloadEncoding::Cbor: Serial.println("CBOR"); break;
+        default: Serial.println("JSON"); break;
+    }
 
     // Now construct objects with loaded configuration
     portal = new WifiPortal(storage, apSsid, apPass, DEFAULT_UUID, DEFAULT_SECRET, 
                            SENSOR_CONFIGS, SENSOR_CONFIG_COUNT, 
                            baseUrl.c_str(), mqttEnabled, readIntervalMs);
-    auth = new AuthManager(storage, baseUrl.c_str(), DEFAULT_UUID, DEFAULT_SECRET, AUTH_RETRY_INTERVAL_MS);
-    sender = new DataSender(storage, baseUrl.c_str());
+    // One keep-alive connection for login, MQTT credentials and data within a wake cycle
+    http = new HttpSession(baseUrl.c_str());
+    auth = new AuthManager(storage, *http, DEFAULT_UUID, DEFAULT_SECRET, AUTH_RETRY_INTERVAL_MS);
+    sender = new DataSender(storage, *http);
     mqttClient = new MqttClient(storage, DEFAULT_UUID);
 
     // create sensors from config
+    uint32_t heapBefore = ESP.getFreeHeap();
     sensors = createSensors();
+    Serial.printf("[BOOT] %u sensor devices ready at %lu ms, heap used %ld bytes\n",
+                  (unsigned)SENSOR_DEVICE_COUNT, millis(), (long)heapBefore - (long)ESP.getFreeHeap());
+
+    // Every wake stores its readings in the RTC batch. With batching, a timer
+    // wake that does not complete a batch goes back to sleep without touching
+    // WiFi; cold boots and button wakes upload what has been collected so far.
+    esp_sleep_wakeup_cause_t wakeCause = esp_sleep_get_wakeup_cause();
+    const size_t cyclesAfterRead = batchCycleCount() + 1;
+    if (!alwaysOn && uploadEveryCycles > 1 && wakeCause == ESP_SLEEP_WAKEUP_TIMER &&
+        cyclesAfterRead < uploadEveryCycles && cyclesAfterRead < READING_BATCH_MAX_CYCLES) {
+        captureBatchCycle();
+        Serial.printf("[BATCH] %u/%u readings stored, upload not due\n",
+                      (unsigned)batchCycleCount(), (unsigned)uploadEveryCycles);
+        enterDeepSleep();
+    }
 
+    String savedSsid, savedPass;
+    hasWifiCreds = storage.getWifiCreds(savedSsid, savedPass) && savedSsid.length() > 0;
 
-    tryAutoConnect();
-    if (WiFi.status() != WL_CONNECTED) {
+    // Upload due: associate, log in and connect MQTT in a second task while
+    // this one reads the sensors; both take hundreds of ms and are independent.
+    // On the classic ESP32 an ADC2 sensor pin cannot be read with WiFi on, so
+    // then the sensors are read first, as before.
+    if (hasWifiCreds && !sharedAdcSampler().usesRadioAdc() && startNetworkTask()) {
+        captureBatchCycle();
+        waitNetworkTask();
+    } else {
+        captureBatchCycle();
+        tryAutoConnect();
+        // Perform one-time provisioning (auth/mqtt credentials/connect)
+        oneTimeProvisioning();
+    }
+
+    if (!networkManager().online()) {
+        // Network down on a wake from deep sleep: keep the readings in flash
+        // and sleep instead of waiting; the portal only opens on a cold boot
+        // (or when nothing is provisioned)
+        if (!alwaysOn && hasWifiCreds && wakeCause != ESP_SLEEP_WAKEUP_UNDEFINED && storeOffline()) {
+            enterDeepSleep();
+        }
         portal->start();
     } else {
         Serial.print("IP: "); Serial.println(WiFi.localIP());
 
-        // Print saved authentication token if it exists
-        String token = storage.getToken();
-        if (token.length() > 0) {
-            Serial.print("Auth token: ");
-            Serial.println(token);
+        // The bearer token itself is never logged
+        if (storage.hasToken()) {
+            Serial.println("Auth token saved");
         } else {
             Serial.println("No auth token saved");
         }
     }
-    // Perform one-time provisioning (auth/mqtt credentials/connect)
-    oneTimeProvisioning();
     
     // Link MQTT client to DataSender for MQTT support at runtime
     if (mqttEnabled) {
@@ -159,25 +262,27 @@ void setup()
         // Serial.println("No saved MQTT credentials");
     }
     // storage.clearMqttCredentials(); // TESTING: always clear MQTT creds on boot
+
+    if (alwaysOn) {
+        startAlwaysOn();
+    }
 }
 
 // One-time provisioning: perform auth, fetch MQTT credentials and attempt initial MQTT connect
 static void oneTimeProvisioning() {
-    if (WiFi.status() != WL_CONNECTED) return;
+    if (!networkManager().online()) return;
 
     // Ensure we have a JWT token (try once synchronously)
-    String token = storage.getToken();
-    if (token.length() == 0) {
+    if (!storage.hasToken()) {
         Serial.println("No token saved, attempting immediate authentication...");
         auth->tryAuthenticateOnce();
-        token = storage.getToken();
-        if (token.length() > 0) Serial.println("Authentication succeeded and token was saved");
+        if (storage.hasToken()) Serial.println("Authentication succeeded and token was saved");
     }
 
     if (!mqttEnabled) return;
 
     // If we don't have MQTT credentials but we do have a token, fetch them once
-    if (!auth->hasMqttCredentials() && token.length() > 0) {
+    if (!auth->hasMqttCredentials() && storage.hasToken()) {
         Serial.println("Fetching MQTT credentials (one-time)");
         if (auth->fetchMqttCredentials()) {
             Serial.println("MQTT credentials fetched and stored");
@@ -197,43 +302,491 @@ static void oneTimeProvisioning() {
     }
 }
 
-// New helper: read sensors and send measurements
-static bool sendMeasurements() {
-    // Read sensors into a vector (no manual malloc/free)
-    std::vector<SensorReading> readings;
-    readings.reserve(sensors.size());
-
-    for (size_t i = 0; i < sensors.size(); ++i) {
-        float value;
-        if (sensors[i]->read(value)) {
-            float rounded = roundf(value * 100.0f) / 100.0f; // 2 decimal places
-            readings.push_back({ sensors[i]->uuid(), rounded });
+static void networkTask(void*) {
+    tryAutoConnect();
+    oneTimeProvisioning();
+    xTaskNotifyGive(setupTask);
+    vTaskDelete(nullptr);
+}
+
+// Core for a network task: on dual-core chips the one that is not running
+// setup() and loop() (the one the WiFi driver lives on)
+static BaseType_t networkCore() {
+#if CONFIG_FREERTOS_UNICORE
+    return 0;
+#else
+    return xPortGetCoreID() == 0 ? 1 : 0;
+#endif
+}
+
+// Run WiFi association and oneTimeProvisioning() in their own task, pinned to
+// networkCore(); the single-core ESP32-C6 still overlaps the network waits
+// with the sensors' warm-up and conversion waits.
+static bool startNetworkTask() {
+    setupTask = xTaskGetCurrentTaskHandle();
+    if (xTaskCreatePinnedToCore(networkTask, "network", NETWORK_TASK_STACK_SIZE, nullptr,
+                                1, nullptr, networkCore()) != pdPASS) {
+        Serial.println("[BOOT] Network task not started, connecting after the sensor read");
+        return false;
+    }
+    return true;
+}
+
+// Join the network task before anything else uses WiFi, auth or MQTT
+static void waitNetworkTask() {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    Serial.printf("[BOOT] network ready at %lu ms after boot\n", millis());
+}
+
+// Acquire the devices serving a SENSOR_CONFIGS entry enabled in sensorMask;
+// the others stay unpowered. Samples of disabled entries on a shared device
+// (e.g. DHT humidity off, temperature on) are left out.
+static AcquisitionReport acquireEnabledSensors(SensorSample* samples) {
+    const uint32_t mask = sensorMask.load();
+    SensorDevice* enabled[SENSOR_DEVICE_COUNT];
+    size_t deviceCount = 0;
+    for (size_t d = 0; d < SENSOR_DEVICE_COUNT; ++d) {
+        for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) {
+            if (SENSOR_PLAN.deviceOf[i] == d && (mask & (1u << i))) {
+                enabled[deviceCount++] = sensors[d];
+                break;
+            }
+        }
+    }
+
+    AcquisitionReport report = acquireSensors(enabled, deviceCount, samples, SENSOR_CONFIG_COUNT);
+    size_t kept = 0;
+    report.okCount = 0;
+    for (size_t s = 0; s < report.sampleCount; ++s) {
+        for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) {
+            if (SENSOR_CONFIGS[i].uuid != samples[s].uuid) continue;
+            if (mask & (1u << i)) {
+                if (samples[s].ok) ++report.okCount;
+                samples[kept++] = samples[s];
+            }
+            break;
+        }
+    }
+    report.sampleCount = kept;
+    return report;
+}
+
+// Convert all sensors in parallel, then collect results as they become ready
+static AcquisitionReport readSensors(SensorSample* samples) {
+    AcquisitionReport report = acquireEnabledSensors(samples);
+    if (!firstReadLogged) {
+        // Each deep-sleep wake is a fresh boot, so this is the wake-to-data latency
+        Serial.printf("[BOOT] first sensor read done at %lu ms after boot\n", millis());
+        firstReadLogged = true;
+    }
+
+    for (size_t i = 0; i < report.sampleCount; ++i) {
+        samples[i].value = roundf(samples[i].value * 100.0f) / 100.0f; // 2 decimal places
+        if (samples[i].ok) {
             Serial.print("Sensor ");
-            Serial.print(sensors[i]->uuid());
+            Serial.print(samples[i].uuid);
             Serial.print(" = ");
-            Serial.println(rounded);
+            Serial.println(samples[i].value);
         } else {
             Serial.print("Failed to read from sensor ");
-            Serial.println(sensors[i]->uuid());
+            Serial.println(samples[i].uuid);
         }
     }
+    printAcquisitionReport(report);
+    return report;
+}
+
+// Read sensors and add the cycle to the RTC reading batch, stamped with the
+// device clock (kept by the RTC timer through deep sleep)
+static void captureBatchCycle() {
+    SensorSample samples[SENSOR_CONFIG_COUNT];
+    AcquisitionReport report = readSensors(samples);
+    batchAppend((uint32_t)time(nullptr), samples, report.sampleCount);
+}
+
+// Move the batch to the flash queue when it cannot be uploaded now
+static bool storeOffline() {
+    if (batchCycleCount() == 0) return true;
+    if (!queueAppend(batchTimestamps(), batchValues(), batchCycleCount())) return false;
+    batchClear();
+    return true;
+}
+
+// Upload cycles queued in flash by earlier wakes, oldest first, a bounded
+// number of requests per wake. The segments go out back to back (MQTT
+// publishes pipelined on one connection) and are deleted only once delivery
+// is confirmed; a failure leaves the rest for the next upload. Returns false
+// when an upload failed.
+static bool drainOfflineQueue() {
+    if (!queuePending()) return true;
+
+    static uint32_t timestamps[READING_BATCH_MAX_CYCLES];
+    static float values[READING_BATCH_MAX_CYCLES * SENSOR_CONFIG_COUNT];
+    bool hasCycles[OFFLINE_QUEUE_DRAIN_PER_WAKE];
+    size_t segments = queueSegmentCount();
+    if (segments > OFFLINE_QUEUE_DRAIN_PER_WAKE) segments = OFFLINE_QUEUE_DRAIN_PER_WAKE;
+
+    sender->beginPipeline();
+    size_t sent = 0;
+    for (; sent < segments; ++sent) {
+        bool currentSession = false;
+        size_t cycles = queueRead(sent, timestamps, values, currentSession);
+        hasCycles[sent] = cycles > 0;
+        if (cycles > 0 && !sender->sendCycles(timestamps, values, cycles, currentSession, (uint32_t)time(nullptr))) {
+            Serial.println("[QUEUE] Upload failed, keeping the remaining segments");
+            break;
+        }
+    }
+    const size_t confirmed = sender->endPipeline();
+
+    // Segments without a valid record had nothing to send
+    size_t popped = 0;
+    for (size_t upload = 0; popped < sent; ++popped) {
+        if (hasCycles[popped] && upload++ >= confirmed) break;
+        queuePopOldest();
+    }
+    if (queueSegmentCount() > 0) {
+        Serial.printf("[QUEUE] %u segments left for the next upload\n", (unsigned)queueSegmentCount());
+    }
+    return popped == segments;
+}
+
+// Upload the readings of this wake (and earlier batched wakes)
+static bool sendMeasurements() {
+    if (uploadEveryCycles > 1 || batchCycleCount() != 1) {
+        // Upload every cycle stored in the RTC batch
+        bool ok = sender->sendBatch((uint32_t)time(nullptr));
+        if (ok) batchClear();
+        Serial.print("Batch send result: "); Serial.println(ok ? "OK" : "FAILED");
+        return ok;
+    }
 
-    if (readings.empty()) {
+    // Single reading: the {"sensors":[...]} payload
+    const float* row = batchValues();
+    SensorReading readings[SENSOR_CONFIG_COUNT];
+    size_t count = 0;
+    for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) {
+        if (!isnan(row[i])) readings[count++] = { SENSOR_CONFIGS[i].uuid, row[i] };
+    }
+
+    if (count == 0) {
         return false;
     }
 
-    bool ok = sender->sendReadings(readings.data(), readings.size());
+    bool ok = sender->sendReadings(readings, count);
+    if (ok) batchClear();
     Serial.print("Data send result: "); Serial.println(ok ? "OK" : "FAILED");
     return ok;
 }
 
+// Pick up the settings a remote command changed (MqttClient::handleCommands)
+static void reloadConfig() {
+    readIntervalMs = storage.getReadIntervalMs();
+    uploadEveryCycles = storage.getUploadEveryCycles();
+    sensorMask = storage.getSensorMask();
+    if (storage.getMqttEnabled() != mqttEnabled) {
+        mqttEnabled = storage.getMqttEnabled();
+        sender->setMqttClient(mqttEnabled ? mqttClient : nullptr);
+        // Over HTTP only, no more commands arrive until MQTT is enabled in the portal
+        if (!mqttEnabled) mqttClient->disconnect();
+    }
+    Serial.printf("[CMD] Now reading every %lu ms, upload every %u, %s, sensor mask 0x%lx\n",
+                  readIntervalMs, (unsigned)uploadEveryCycles, mqttEnabled ? "MQTT" : "HTTP",
+                  (unsigned long)sensorMask.load());
+}
+
+// Before the session closes, give the broker MQTT_COMMAND_WINDOW_MS to deliver
+// commands it queued while the device slept, then apply them
+static void serviceCommands() {
+    if (!mqttEnabled || !mqttClient->isConnected()) return;
+    const unsigned long start = millis();
+    while (millis() - start < MQTT_COMMAND_WINDOW_MS && mqttClient->isConnected()) {
+        mqttClient->process();
+        delay(1);
+    }
+    if (mqttClient->handleCommands() > 0) reloadConfig();
+}
+
+// Shut the radio down and sleep until the next reading (timer) or a button press
+static void enterDeepSleep() {
+    serviceCommands();
+
+    // Enter deep sleep for the configured interval (milliseconds -> microseconds)
+    uint64_t sleep_us = (uint64_t)readIntervalMs * 1000ULL;
+
+    // Turn off WiFi cleanly to speed shutdown
+    if (mqttEnabled) {
+        mqttClient->disconnect();
+    }
+    if (http->stats().requests > 0) {
+        http->printStats();
+    }
+    transportPrintStats();
+    tlsPrintStats();
+    http->close();
+    storage.flush();
+    storage.printStats();
+    if (WiFi.getMode() != WIFI_OFF) {
+        WiFi.disconnect(true);
+        WiFi.mode(WIFI_OFF);
+        delay(50);
+    }
+
+    // Enable wakeup from button (LOW = pressed)
+    #if defined(CONFIG_IDF_TARGET_ESP32)
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)BUTTON_PIN, 0);
+    #elif defined(CONFIG_IDF_TARGET_ESP32C6)
+    // On ESP32-C6, EXT1 wakeup only supports RTC GPIOs (0-7).
+    // For other pins (like GPIO 14), we use the GPIO deep sleep wakeup.
+    esp_deep_sleep_enable_gpio_wakeup(1ULL << BUTTON_PIN, ESP_GPIO_WAKEUP_GPIO_LOW);
+    #else
+    // Other variants (S2, S3, C3) typically use ext1 for GPIO wakeup
+    esp_sleep_enable_ext1_wakeup(1ULL << BUTTON_PIN, ESP_EXT1_WAKEUP_ANY_LOW);
+    #endif
+    // Also enable timer wakeup
+    esp_sleep_enable_timer_wakeup(sleep_us);
+    esp_deep_sleep_start();
+}
+
+// ==================== Always-on mode ====================
+// Mains-powered devices stay awake: loop() reads the sensors every
+// ALWAYS_ON_SAMPLE_INTERVAL_MS and pushes the cycles into liveQueue, the
+// service task keeps one MQTT session open and publishes them. The queue is
+// lock-free, so a slow publish or a reconnect never holds up sampling.
+
+// Delay before MQTT connect attempt number failures + 1: doubling from
+// AGRONOS_MQTT_RECONNECT_DELAY up to AGRONOS_MQTT_RECONNECT_MAX_DELAY, then a
+// random point in its upper half so devices that lost the broker together do
+// not reconnect in lockstep
+static unsigned long reconnectDelayMs(uint8_t failures) {
+    unsigned long delayMs = AGRONOS_MQTT_RECONNECT_DELAY;
+    for (uint8_t i = 1; i < failures && delayMs < AGRONOS_MQTT_RECONNECT_MAX_DELAY; ++i) delayMs *= 2;
+    if (delayMs > AGRONOS_MQTT_RECONNECT_MAX_DELAY) delayMs = AGRONOS_MQTT_RECONNECT_MAX_DELAY;
+    return delayMs / 2 + (unsigned long)random((long)(delayMs / 2 + 1));
+}
+
+// Fetch the MQTT credentials if they are missing, then open the session
+static bool connectLiveSession() {
+    if (!auth->hasMqttCredentials()) {
+        if (!storage.hasToken() || !auth->fetchMqttCredentials()) return false;
+    }
+    return mqttClient->connect();
+}
+
+// Move up to READING_BATCH_MAX_CYCLES queued cycles into the row buffers
+static size_t popLiveCycles(uint32_t* timestamps, float* values) {
+    LiveCycle cycle;
+    size_t cycles = 0;
+    while (cycles < READING_BATCH_MAX_CYCLES && liveQueue.pop(cycle)) {
+        timestamps[cycles] = cycle.timestamp;
+        memcpy(values + cycles * SENSOR_CONFIG_COUNT, cycle.values, sizeof(cycle.values));
+        ++cycles;
+    }
+    return cycles;
+}
+
+// Send the queued cycles, one message per batch (one cycle each while the
+// publisher keeps up). A batch that fails goes to the flash queue and false
+// is returned.
+static bool publishLiveCycles() {
+    static uint32_t timestamps[READING_BATCH_MAX_CYCLES];
+    static float values[READING_BATCH_MAX_CYCLES * SENSOR_CONFIG_COUNT];
+    size_t cycles;
+    while ((cycles = popLiveCycles(timestamps, values)) > 0) {
+        if (!sender->sendCycles(timestamps, values, cycles, true, (uint32_t)time(nullptr))) {
+            if (queueAppend(timestamps, values, cycles)) liveStored += cycles;
+            return false;
+        }
+        livePublished += cycles;
+    }
+    return true;
+}
+
+// Without a session, write full segments to the flash queue so liveQueue
+// keeps room and the flash sees one write per READING_BATCH_MAX_CYCLES cycles
+static void storeLiveCycles() {
+    static uint32_t timestamps[READING_BATCH_MAX_CYCLES];
+    static float values[READING_BATCH_MAX_CYCLES * SENSOR_CONFIG_COUNT];
+    while (liveQueue.size() >= READING_BATCH_MAX_CYCLES) {
+        size_t cycles = popLiveCycles(timestamps, values);
+        if (!queueAppend(timestamps, values, cycles)) {
+            Serial.printf("[LIVE] Flash queue unusable, %u cycles lost\n", (unsigned)cycles);
+            continue;
+        }
+        liveStored += cycles;
+    }
+}
+
+// Count a failed connect or send and return when to try again
+static unsigned long retryAfterFailure(uint8_t& failures, const char* what) {
+    if (failures < 255) ++failures;
+    const unsigned long wait = reconnectDelayMs(failures);
+    Serial.printf("[LIVE] %s failed (%u in a row), retry in %lu ms\n", what, (unsigned)failures, wait);
+    return millis() + wait;
+}
+
+// Service task: owns the portal, Storage, WiFi reconnects, auth, the MQTT
+// session (keep-alive, PUBACKs, reconnect with jittered backoff), publishing
+// and the flash queue
+static void alwaysOnTask(void*) {
+    uint8_t failures = 0;       // connects and sends, reset by a delivered publish
+    unsigned long retryAt = millis();
+    uint8_t wifiFailures = 0;
+    unsigned long wifiRetryAt = millis();
+    bool drainDue = true;       // flash backlog to upload once the live cycles are out
+    unsigned long lastReport = millis();
+
+    for (;;) {
+        // The portal saves its settings to Storage, so it is served here too
+        portal->handle();
+        if (portal->isRunning() && hasWifiCreds && millis() >= PORTAL_TIMEOUT_MS) {
+            Serial.println("WiFi still down, closing the portal; readings go to flash until it is back");
+            portal->stop();
+        }
+
+        const unsigned long now = millis();
+        bool online = networkManager().online();
+
+        // The driver reconnects a link it had; after a failed boot connect
+        // (once the portal has closed) associate again here
+        if (!online && !portal->isRunning() && hasWifiCreds &&
+            networkManager().state() == NetState::Down && (long)(now - wifiRetryAt) >= 0) {
+            tryAutoConnect();
+            online = networkManager().online();
+            if (online) {
+                wifiFailures = 0;
+            } else {
+                wifiRetryAt = retryAfterFailure(wifiFailures, "WiFi connect");
+            }
+        }
+
+        if (online) auth->loop();
+        if (mqttEnabled && mqttClient->isConnected()) {
+            mqttClient->process(); // PUBACKs, keep-alive ping, commands
+            if (mqttClient->handleCommands() > 0) reloadConfig();
+        }
+
+        bool ready = false;
+        if (online && (long)(now - retryAt) >= 0) {
+            if (!mqttEnabled) {
+                ready = storage.hasToken(); // HTTP uploads on the keep-alive session
+            } else if (mqttClient->isConnected()) {
+                ready = true;
+            } else if (connectLiveSession()) {
+                Serial.println("[LIVE] MQTT session open");
+                drainDue = true;
+                ready = true;
+            } else {
+                retryAt = retryAfterFailure(failures, "MQTT connect");
+            }
+        }
+
+        if (ready) {
+            const uint32_t publishedBefore = livePublished;
+            if (!publishLiveCycles()) {
+                retryAt = retryAfterFailure(failures, "Send");
+            } else if (livePublished != publishedBefore) {
+                failures = 0;
+                drainDue = true;
+            }
+            // Then the backlog; after a failed upload wait for the next delivered publish
+            if (drainDue && liveQueue.size() == 0 && (long)(millis() - retryAt) >= 0) {
+                drainDue = drainOfflineQueue() && queuePending();
+            }
+        } else {
+            storeLiveCycles();
+        }
+
+        // No deep sleep to flush at: store a new token, credentials or link now
+        storage.flush();
+
+        if (millis() - lastReport >= ALWAYS_ON_STATS_INTERVAL_MS) {
+            lastReport = millis();
+            Serial.printf("[LIVE] %lu sampled, %lu published, %lu to flash, %lu dropped, %u queued, session %s\n",
+                          (unsigned long)liveSampled.load(), (unsigned long)livePublished,
+                          (unsigned long)liveStored, (unsigned long)liveDropped.load(),
+                          (unsigned)liveQueue.size(), ready ? "up" : "down");
+            transportPrintStats();
+        }
+
+        // Woken by every sampled cycle; the timeout bounds the keep-alive and
+        // portal service
+        const unsigned long idleMs = portal->isRunning() ? PORTAL_SERVICE_INTERVAL_MS : ALWAYS_ON_SAMPLE_INTERVAL_MS * 2;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(idleMs));
+    }
+}
+
+// Hand the readings taken in setup() to liveQueue and start the service task;
+// from here on only that task touches the portal, Storage and the settings,
+// WiFi, auth, MQTT and the flash queue. The loop task only samples: it reads
+// sensorMask (atomic) and hands cycles over through liveQueue.
+static void startAlwaysOn() {
+    LiveCycle cycle;
+    for (size_t i = 0; i < batchCycleCount(); ++i) {
+        cycle.timestamp = batchTimestamps()[i];
+        memcpy(cycle.values, batchValues() + i * SENSOR_CONFIG_COUNT, sizeof(cycle.values));
+        liveQueue.push(cycle);
+    }
+    batchClear();
+
+    if (xTaskCreatePinnedToCore(alwaysOnTask, "service", NETWORK_TASK_STACK_SIZE, nullptr,
+                                1, &serviceTask, networkCore()) != pdPASS) {
+        Serial.println("[LIVE] Service task not started, using deep sleep cycles");
+        alwaysOn = false;
+        return;
+    }
+    nextSampleAt = millis() + ALWAYS_ON_SAMPLE_INTERVAL_MS;
+    Serial.printf("[LIVE] Always-on, sampling every %lu ms\n", ALWAYS_ON_SAMPLE_INTERVAL_MS);
+}
+
+// Read the sensors (without the per-value log) and queue the cycle
+static void sampleLiveCycle() {
+    SensorSample samples[SENSOR_CONFIG_COUNT];
+    AcquisitionReport report = acquireEnabledSensors(samples);
+    for (size_t i = 0; i < report.sampleCount; ++i) {
+        samples[i].value = roundf(samples[i].value * 100.0f) / 100.0f; // 2 decimal places
+    }
+
+    LiveCycle cycle;
+    cycle.timestamp = (uint32_t)time(nullptr);
+    batchRowFromSamples(samples, report.sampleCount, cycle.values);
+    ++liveSampled;
+    if (!liveQueue.push(cycle)) ++liveDropped; // publisher and flash both behind
+    xTaskNotifyGive(serviceTask);
+}
+
+// loop() body in always-on mode; never sleeps
+static void alwaysOnLoop() {
+    unsigned long now = millis();
+    if ((long)(now - nextSampleAt) >= 0) {
+        nextSampleAt = now + ALWAYS_ON_SAMPLE_INTERVAL_MS;
+        sampleLiveCycle();
+        now = millis();
+    }
+
+    // Sleep until the next reading
+    delay((long)(nextSampleAt - now) > 0 ? nextSampleAt - now : 0);
+}
+
 void loop()
 {
+    if (alwaysOn) {
+        alwaysOnLoop();
+        return;
+    }
+
     portal->handle();
     
-    if (WiFi.status() != WL_CONNECTED) {
-        // Not connected: skip auth.loop() and sendMeasurements()
-        //Serial.println("WiFi not connected, skipping auth and send");
+    if (!networkManager().online()) {
+        // Not connected: skip auth.loop() and sendMeasurements(). With a saved
+        // network the portal stays open for a limited time, then the readings
+        // go to flash and the device sleeps.
+        if (hasWifiCreds && millis() >= PORTAL_TIMEOUT_MS && storeOffline()) {
+            Serial.println("WiFi still down, readings kept in flash");
+            enterDeepSleep();
+        }
+        // Idle until an IP arrives or the portal needs servicing again
+        networkManager().waitOnline(PORTAL_SERVICE_INTERVAL_MS);
         return;
     }
 
@@ -241,13 +794,17 @@ void loop()
     // Let auth manager handle periodic auth attempts when needed
     auth->loop();
     
-    // MQTT runtime processing disabled; initial connect happens in setup() only.
+    // Deep-sleep cycles connect MQTT per upload (setup() or sendMeasurements());
+    // the always-on mode keeps a session in its service task (alwaysOnTask)
 
     // Attempt send immediately when connected; device will deep-sleep on success.
     // Rate-limit attempts when sends fail to avoid hammering the server.
+    // The first attempt of a wake goes out at once (lastSendAttempt == 0).
     unsigned long now = millis();
-    if (now - lastSendAttempt < SEND_RETRY_BACKOFF_MS) {
-        // Wait before trying again
+    if (lastSendAttempt != 0 && now - lastSendAttempt < SEND_RETRY_BACKOFF_MS) {
+        // Wait before trying again; the portal is closed while connected, so
+        // block for the rest of the backoff instead of spinning through loop()
+        delay(SEND_RETRY_BACKOFF_MS - (now - lastSendAttempt));
         return;
     }
 
@@ -257,34 +814,22 @@ void loop()
     // Call extracted function
     bool sent = sendMeasurements();
     if (sent) {
+        // The server is reachable: catch up on what was queued while it was not
+        drainOfflineQueue();
         // reset lastSendAttempt to avoid delaying next cycle after wake
         lastSendAttempt = 0;
-        // Enter deep sleep for the configured interval (milliseconds -> microseconds)
-        uint64_t sleep_us = (uint64_t)readIntervalMs * 1000ULL;
         Serial.print("Measurements sent, entering deep sleep for ms: ");
         Serial.println(readIntervalMs);
+        enterDeepSleep();
+    }
 
-        // Turn off WiFi cleanly to speed shutdown
-        if (mqttEnabled) {
-            mqttClient->disconnect();
-        }
-        WiFi.disconnect(true);
-        WiFi.mode(WIFI_OFF);
-        delay(50);
-
-        // Enable wakeup from button (LOW = pressed)
-        #if defined(CONFIG_IDF_TARGET_ESP32)
-        esp_sleep_enable_ext0_wakeup((gpio_num_t)BUTTON_PIN, 0);
-        #elif defined(CONFIG_IDF_TARGET_ESP32C6)
-        // On ESP32-C6, EXT1 wakeup only supports RTC GPIOs (0-7).
-        // For other pins (like GPIO 14), we use the GPIO deep sleep wakeup.
-        esp_deep_sleep_enable_gpio_wakeup(1ULL << BUTTON_PIN, ESP_GPIO_WAKEUP_GPIO_LOW);
-        #else
-        // Other variants (S2, S3, C3) typically use ext1 for GPIO wakeup
-        esp_sleep_enable_ext1_wakeup(1ULL << BUTTON_PIN, ESP_EXT1_WAKEUP_ANY_LOW);
-        #endif
-        // Also enable timer wakeup
-        esp_sleep_enable_timer_wakeup(sleep_us);
-        esp_deep_sleep_start();
+    // A static IP from an expired lease associates fine but carries no traffic;
+    // an HTTP error or a refused login says nothing about the link
+    if (sender->serverUnreachable()) wifiLinkFailed(storage);
+    if (storeOffline()) {
+        // Keep the readings in flash instead of staying awake to retry;
+        // without a usable flash queue the backoff retry above applies
+        Serial.println("Send failed, readings kept in flash, entering deep sleep");
+        enterDeepSleep();
     }
 }
\ No newline at end of file
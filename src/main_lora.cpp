@@ -6,10 +6,12 @@
 #include <Arduino.h>
 #include <esp_sleep.h>
 #include <cmath>
+#include <vector>
 
 #include "config.h"
 #include "storage.h"
-#include "sensor.h"
+#include "sensor_registry.h"
+#include "sensor_scheduler.h"
 #include "data_sender.h"   // for SensorReading struct
 #include "lora_payload.h"
 #include "lora_crypto.h"
@@ -32,7 +34,7 @@ static void printHex(const char* label, const uint8_t* data, size_t len) {
 }
 
 // Sensor instances created via factory
-static std::vector<std::unique_ptr<SensorBase>> sensors;
+static SensorDevice* const* sensors = nullptr;
 
 // Check if button is held for long press to reset all storage
 static void checkButtonReset() {
@@ -80,23 +82,29 @@ void setup() {
     }
 
     // 3. Create sensors from config (reuses factory pattern)
+    uint32_t heapBefore = ESP.getFreeHeap();
     sensors = createSensors();
-    Serial.printf("Created %u sensors\n", sensors.size());
+    Serial.printf("Created %u sensor devices, heap used %ld bytes\n",
+                  (unsigned)SENSOR_DEVICE_COUNT, (long)heapBefore - (long)ESP.getFreeHeap());
+
+    // 4. Read all sensors (conversions overlap, results collected as ready)
+    SensorSample samples[SENSOR_CONFIG_COUNT];
+    AcquisitionReport report = acquireSensors(sensors, SENSOR_DEVICE_COUNT, samples, SENSOR_CONFIG_COUNT);
+    Serial.printf("[BOOT] first sensor read done at %lu ms after boot\n", millis());
 
-    // 4. Read all sensors
     std::vector<SensorReading> readings;
-    readings.reserve(sensors.size());
-
-    for (size_t i = 0; i < sensors.size(); ++i) {
-        float value;
-        if (sensors[i]->read(value)) {
-            float rounded = roundf(value * 100.0f) / 100.0f;
-            readings.push_back({ sensors[i]->uuid(), rounded });
-            Serial.printf("  %s = %.2f\n", sensors[i]->uuid(), rounded);
+    readings.reserve(report.sampleCount);
+
+    for (size_t i = 0; i < report.sampleCount; ++i) {
+        if (samples[i].ok) {
+            float rounded = roundf(samples[i].value * 100.0f) / 100.0f;
+            readings.push_back({ samples[i].uuid, rounded });
+            Serial.printf("  %s = %.2f\n", samples[i].uuid, rounded);
         } else {
-            Serial.printf("  %s = FAILED\n", sensors[i]->uuid());
+            Serial.printf("  %s = FAILED\n", samples[i].uuid);
         }
     }
+    printAcquisitionReport(report);
 
     if (readings.empty()) {
         Serial.println("No sensor readings. Sleeping...");
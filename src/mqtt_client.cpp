@@ -1,26 +1,42 @@
 #include "mqtt_client.h"
 #include <ArduinoJson.h>
 #include "config.h"
+#include "network_manager.h"
+
+// CONNACK codes for a protocol level the broker does not speak
+static const int CONNACK_V311_BAD_PROTOCOL = 0x01;
+static const int CONNACK_V5_BAD_PROTOCOL = 0x84;
+
+// The broker refused MQTT 5 once: stay on 3.1.1 for the following wakes
+RTC_DATA_ATTR static bool rtcMqttV311Only = false;
+
+// The command topic is subscribed in the broker session (kept across wakes
+// unless the broker reports a new session); reset on power loss
+RTC_DATA_ATTR static bool rtcCommandsSubscribed = false;
+
+// Topic of the publish in progress (templates formatted with the device UUID)
+static char topicBuf[MQTT_TOPIC_MAX_LEN];
 
 MqttClient::MqttClient(Storage &storage, const char* deviceUuid)
 : storage(storage), 
   deviceUuid(deviceUuid),
-    credentialsLoaded(false) {
+    credentialsLoaded(false),
+    commandCount(0) {
     
     // Initialize MQTT client with appropriate WiFi client
-    #ifdef AGRONOS_MQTT_USE_TLS
-    if (AGRONOS_MQTT_USE_TLS) {
-        secureClient.setInsecure(); // For testing; use proper certificates in production
+    if constexpr (AGRONOS_MQTT_USE_TLS) {
+        // Shares the RTC session cache with the HTTPS backend; like
+        // setInsecure(), no certificate check — use proper certificates in production
         mqttClient.setClient(secureClient);
     } else {
-    #endif
         mqttClient.setClient(wifiClient);
-    #ifdef AGRONOS_MQTT_USE_TLS
     }
-    #endif
     
-    // No callback/subscriptions needed for this device (publish-only)
+    // Remote configuration commands (subscribed on connect, see subscribeCommands)
+    mqttClient.setCallback(onMessage, this);
     mqttClient.setKeepAlive(AGRONOS_MQTT_KEEPALIVE);
+    mqttClient.setProtocol(AGRONOS_MQTT_V5 && !rtcMqttV311Only ? MqttVersion::V5 : MqttVersion::V311);
+    mqttClient.setSessionExpiry(AGRONOS_MQTT_SESSION_EXPIRY_S);
 }
 
 bool MqttClient::loadCredentials() {
@@ -32,10 +48,14 @@ bool MqttClient::loadCredentials() {
     return credentialsLoaded && credentials.isValid;
 }
 
-String MqttClient::buildTopic(const char* topicTemplate) const {
-    char topic[128];
-    snprintf(topic, sizeof(topic), topicTemplate, deviceUuid);
-    return String(topic);
+// Format the topic into topicBuf; nullptr if it does not fit
+const char* MqttClient::formatTopic(const char* topicTemplate) const {
+    int n = snprintf(topicBuf, sizeof(topicBuf), topicTemplate, deviceUuid);
+    if (n <= 0 || (size_t)n >= sizeof(topicBuf)) {
+        Serial.println("MQTT topic does not fit MQTT_TOPIC_MAX_LEN");
+        return nullptr;
+    }
+    return topicBuf;
 }
 
 bool MqttClient::connect() {
@@ -47,9 +67,15 @@ bool MqttClient::connect() {
     if (mqttClient.connected()) {
         return true;
     }
+
+    // Without an IP the TCP connect could only time out
+    if (!networkManager().online()) {
+        Serial.println("Cannot connect to MQTT: network down");
+        return false;
+    }
     
     // Set MQTT server
-    mqttClient.setServer(credentials.server.c_str(), AGRONOS_MQTT_PORT);
+    mqttClient.setServer(credentials.server, AGRONOS_MQTT_PORT);
     
     // Generate client ID
     String clientId = String("agronos-") + deviceUuid;
@@ -60,22 +86,22 @@ bool MqttClient::connect() {
     Serial.println(AGRONOS_MQTT_PORT);
     
     // Attempt connection
-    bool connected = mqttClient.connect(
-        clientId.c_str(),
-        credentials.username.c_str(),
-        credentials.password.c_str(),
-        nullptr,  // willTopic
-        0,        // willQos
-        false,    // willRetain
-        nullptr,  // willMessage
-        AGRONOS_MQTT_CLEAN_SESSION
-    );
+    bool connected = mqttClient.connect(clientId.c_str(), credentials.username,
+                                        credentials.password, AGRONOS_MQTT_CLEAN_SESSION);
+    if (!connected && mqttClient.protocol() == MqttVersion::V5 &&
+        (mqttClient.state() == CONNACK_V311_BAD_PROTOCOL || mqttClient.state() == CONNACK_V5_BAD_PROTOCOL)) {
+        Serial.println("Broker does not support MQTT 5, retrying with 3.1.1");
+        rtcMqttV311Only = true;
+        mqttClient.setProtocol(MqttVersion::V311);
+        connected = mqttClient.connect(clientId.c_str(), credentials.username,
+                                       credentials.password, AGRONOS_MQTT_CLEAN_SESSION);
+    }
     
     if (connected) {
-        Serial.println("MQTT connected successfully");
-        
-    // No subscription needed for publish-only device
-        
+        Serial.printf("MQTT connected successfully (MQTT %s, %s session)\n",
+                      mqttClient.protocol() == MqttVersion::V5 ? "5" : "3.1.1",
+                      mqttClient.sessionPresent() ? "resumed" : "new");
+        subscribeCommands();
         return true;
     } else {
         Serial.print("MQTT connection failed, state: ");
@@ -95,14 +121,40 @@ void MqttClient::disconnect() {
 }
 
 void MqttClient::process() {
-    // Run a single pass of the underlying client to let the TCP/MQTT stack settle
+    // Run a single pass of the underlying client; connect() already waited
+    // for CONNACK, so there is nothing to settle
     if (mqttClient.connected()) {
         mqttClient.loop();
-        delay(50);
     }
 }
 
-bool MqttClient::publishSensorDataPayload(const char* payload) {
+bool MqttClient::publishData(const char* topic, const uint8_t* payload, size_t len, uint16_t* pendingId) {
+    uint16_t packetId = 0;
+    bool published = topic && mqttClient.publish(topic, payload, len, AGRONOS_MQTT_QOS_DATA, false, &packetId);
+    return confirmPublish(published, packetId, pendingId);
+}
+
+// Hand out the packet id (pipelined) or wait for the PUBACK
+bool MqttClient::confirmPublish(bool published, uint16_t packetId, uint16_t* pendingId) {
+    if (published && pendingId) {
+        *pendingId = packetId; // confirmed later through flush() / delivered()
+    } else if (published && packetId != 0 && !mqttClient.waitAck(packetId, MQTT_ACK_TIMEOUT_MS)) {
+        // Reported as failed: do not let a later reconnect send it a second time
+        Serial.println("No PUBACK from the broker");
+        mqttClient.disconnect();
+        published = false;
+    }
+
+    if (published) {
+        Serial.println(pendingId && packetId != 0 ? "MQTT publish in flight" : "MQTT publish successful");
+    } else {
+        Serial.println("MQTT publish failed");
+    }
+    return published;
+}
+
+bool MqttClient::publishSensorDataPayload(const char* payload, uint16_t* pendingId) {
+    if (pendingId) *pendingId = 0;
     if (!isConnected()) {
         Serial.println("MQTT not connected, cannot publish sensor data");
         return false;
@@ -113,19 +165,63 @@ bool MqttClient::publishSensorDataPayload(const char* payload) {
         return false;
     }
 
-    String topic = buildTopic(AGRONOS_MQTT_TOPIC_DATA);
-    Serial.print("Publishing to MQTT topic: "); Serial.println(topic);
+    const char* topic = formatTopic(AGRONOS_MQTT_TOPIC_DATA);
+    Serial.print("Publishing to MQTT topic: "); Serial.println(topic ? topic : "");
     Serial.print("Payload: "); Serial.println(payload);
 
-    bool published = mqttClient.publish(topic.c_str(), payload, false);
+    return publishData(topic, (const uint8_t*)payload, strlen(payload), pendingId);
+}
 
-    if (published) {
-        Serial.println("MQTT publish successful");
-    } else {
-        Serial.println("MQTT publish failed");
+bool MqttClient::publishSensorDataPayload(const uint8_t* payload, size_t len, const char* topicTemplate,
+                                          uint16_t* pendingId) {
+    if (pendingId) *pendingId = 0;
+    if (!isConnected()) {
+        Serial.println("MQTT not connected, cannot publish sensor data");
+        return false;
     }
 
-    return published;
+    if (!payload || len == 0) {
+        Serial.println("Empty payload passed to publishSensorDataPayload");
+        return false;
+    }
+
+    const char* topic = formatTopic(topicTemplate);
+    Serial.print("Publishing to MQTT topic: "); Serial.println(topic ? topic : "");
+    Serial.printf("Payload: %u bytes (binary)\n", (unsigned)len);
+
+    return publishData(topic, payload, len, pendingId);
+}
+
+bool MqttClient::beginSensorData(const char* topicTemplate, size_t len) {
+    if (!isConnected()) {
+        Serial.println("MQTT not connected, cannot publish sensor data");
+        return false;
+    }
+
+    const char* topic = formatTopic(topicTemplate);
+    if (!topic) return false;
+    Serial.print("Publishing to MQTT topic: "); Serial.println(topic);
+    Serial.printf("Payload: %u bytes (streamed)\n", (unsigned)len);
+
+    return mqttClient.beginPublish(topic, len, AGRONOS_MQTT_QOS_DATA, false);
+}
+
+bool MqttClient::writeSensorData(const uint8_t* data, size_t len) {
+    return mqttClient.write(data, len) == len;
+}
+
+bool MqttClient::endSensorData(uint16_t* pendingId) {
+    if (pendingId) *pendingId = 0;
+    uint16_t packetId = 0;
+    bool published = mqttClient.endPublish(&packetId);
+    return confirmPublish(published, packetId, pendingId);
+}
+
+bool MqttClient::flush() {
+    if (mqttClient.inFlight() == 0) return true;
+    bool ok = mqttClient.flush(MQTT_ACK_TIMEOUT_MS);
+    if (!ok) Serial.printf("MQTT: %u publishes not acknowledged\n", (unsigned)mqttClient.inFlight());
+    return ok;
 }
 
 bool MqttClient::publishStatus(const char* status) {
@@ -133,8 +229,56 @@ bool MqttClient::publishStatus(const char* status) {
         return false;
     }
     
-    String topic = buildTopic(AGRONOS_MQTT_TOPIC_STATUS);
-    return mqttClient.publish(topic.c_str(), status, false);
+    const char* topic = formatTopic(AGRONOS_MQTT_TOPIC_STATUS);
+    return topic && mqttClient.publish(topic, (const uint8_t*)status, strlen(status), AGRONOS_MQTT_QOS_STATUS, false);
 }
 
-// mqttCallback removed: device is publish-only and does not subscribe to topics
+// Subscribe to the command topic unless the resumed session already has it.
+// A failure only costs the commands; data publishing goes on.
+bool MqttClient::subscribeCommands() {
+    if (rtcCommandsSubscribed && mqttClient.sessionPresent()) return true;
+
+    char topic[MQTT_TOPIC_MAX_LEN];
+    snprintf(topic, sizeof(topic), AGRONOS_MQTT_TOPIC_COMMAND, deviceUuid);
+    rtcCommandsSubscribed = mqttClient.subscribe(topic, AGRONOS_MQTT_QOS_COMMAND);
+    Serial.printf("[CMD] Subscribe to %s %s\n", topic, rtcCommandsSubscribed ? "done" : "failed");
+    return rtcCommandsSubscribed;
+}
+
+// Runs inside the connection's loop(), possibly in the middle of a publish:
+// only parse and queue here, handleCommands() applies and acks
+bool MqttClient::onMessage(void* ctx, const char* topic, const uint8_t* payload, size_t len) {
+    MqttClient* self = static_cast<MqttClient*>(ctx);
+    char commandTopic[MQTT_TOPIC_MAX_LEN];
+    snprintf(commandTopic, sizeof(commandTopic), AGRONOS_MQTT_TOPIC_COMMAND, self->deviceUuid);
+    if (strcmp(topic, commandTopic) != 0) return true;
+
+    if (self->commandCount == MQTT_COMMAND_QUEUE) {
+        // Not acknowledged: the persistent session delivers it again on the next connect
+        Serial.println("[CMD] Command queue full, command left with the broker");
+        return false;
+    }
+    parseDeviceCommand(payload, len, self->commands[self->commandCount++]);
+    return true;
+}
+
+size_t MqttClient::handleCommands() {
+    size_t applied = 0;
+    // Publishing an ack services the connection, which may queue more commands
+    for (size_t i = 0; i < commandCount; ++i) {
+        DeviceCommand& cmd = commands[i];
+        if (applyDeviceCommand(storage, cmd)) ++applied;
+        Serial.printf("[CMD] Command %s %s%s\n", cmd.id[0] ? cmd.id : "(no id)",
+                      cmd.error ? "rejected: " : "applied", cmd.error ? cmd.error : "");
+
+        char ack[192];
+        size_t len = writeCommandAck(cmd, storage, ack, sizeof(ack));
+        const char* topic = formatTopic(AGRONOS_MQTT_TOPIC_COMMAND_ACK);
+        uint16_t packetId = 0;
+        bool published = len > 0 && topic && isConnected() &&
+                         mqttClient.publish(topic, (const uint8_t*)ack, len, AGRONOS_MQTT_QOS_COMMAND, false, &packetId);
+        confirmPublish(published, packetId, nullptr);
+    }
+    commandCount = 0;
+    return applied;
+}
@@ -0,0 +1,752 @@
+#include "mqtt_connection.h"
+#include <string.h>
+
+// Control packet types (high nibble of the fixed header)
+static const uint8_t MQTT_CONNECT = 1;
+static const uint8_t MQTT_CONNACK = 2;
+static const uint8_t MQTT_PUBLISH = 3;
+static const uint8_t MQTT_PUBACK = 4;
+static const uint8_t MQTT_SUBSCRIBE = 8;
+static const uint8_t MQTT_SUBACK = 9;
+static const uint8_t MQTT_PINGREQ = 12;
+static const uint8_t MQTT_PINGRESP = 13;
+static const uint8_t MQTT_DISCONNECT = 14;
+
+// MQTT 5 property identifiers used here
+static const uint8_t PROP_SESSION_EXPIRY = 0x11;
+static const uint8_t PROP_RECEIVE_MAXIMUM = 0x21;
+static const uint8_t PROP_TOPIC_ALIAS_MAXIMUM = 0x22;
+static const uint8_t PROP_TOPIC_ALIAS = 0x23;
+static const uint8_t PROP_MAXIMUM_PACKET_SIZE = 0x27;
+
+// PUBLISH fixed header (at most 5 bytes) + topic + packet id + properties (at most 4 bytes)
+static const size_t PUBLISH_HEADER_MAX = 5 + 2 + MQTT_TOPIC_MAX_LEN + 2 + 4;
+
+static size_t putVarInt(uint8_t* out, uint32_t value) {
+    size_t n = 0;
+    do {
+        uint8_t b = value & 0x7F;
+        value >>= 7;
+        out[n++] = value ? (b | 0x80) : b;
+    } while (value);
+    return n;
+}
+
+static size_t putU16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)value;
+    return 2;
+}
+
+static size_t putU32(uint8_t* out, uint32_t value) {
+    putU16(out, (uint16_t)(value >> 16));
+    putU16(out + 2, (uint16_t)value);
+    return 4;
+}
+
+static size_t putString(uint8_t* out, const char* s, size_t len) {
+    putU16(out, (uint16_t)len);
+    memcpy(out + 2, s, len);
+    return 2 + len;
+}
+
+static size_t varIntSize(uint32_t value) {
+    size_t n = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+// Bounds-checked reader over a received packet body
+struct PacketReader {
+    const uint8_t* p;
+    size_t left;
+    bool ok;
+
+    uint8_t u8() {
+        if (left < 1) { ok = false; return 0; }
+        --left;
+        return *p++;
+    }
+    uint16_t u16() {
+        uint16_t hi = u8();
+        return (uint16_t)((hi << 8) | u8());
+    }
+    uint32_t u32() {
+        uint32_t hi = u16();
+        return (hi << 16) | u16();
+    }
+    uint32_t varInt() {
+        uint32_t value = 0;
+        for (int shift = 0; shift <= 21; shift += 7) {
+            uint8_t b = u8();
+            value |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return value;
+        }
+        ok = false;
+        return 0;
+    }
+    void skip(size_t n) {
+        if (left < n) { ok = false; left = 0; return; }
+        p += n;
+        left -= n;
+    }
+};
+
+// Skip one MQTT 5 property value of the given identifier
+static void skipProperty(PacketReader& r, uint8_t id) {
+    switch (id) {
+        case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+            r.skip(1);
+            break;
+        case 0x13: case 0x21: case 0x22: case 0x23:
+            r.skip(2);
+            break;
+        case 0x02: case 0x11: case 0x18: case 0x27:
+            r.skip(4);
+            break;
+        case 0x0B:
+            r.varInt();
+            break;
+        case 0x26: // user property: string pair
+            r.skip(r.u16());
+            r.skip(r.u16());
+            break;
+        case 0x03: case 0x08: case 0x09: case 0x12: case 0x15: case 0x16: case 0x1A: case 0x1C: case 0x1F:
+            r.skip(r.u16()); // string or binary data
+            break;
+        default:
+            r.ok = false; // unknown: the rest cannot be parsed
+            break;
+    }
+}
+
+MqttConnection::MqttConnection()
+: client_(nullptr), host_(nullptr), port_(1883), keepAliveS_(60), version_(MqttVersion::V311),
+  sessionExpiryS_(0), state_(MQTT_STATE_DISCONNECTED), sessionPresent_(false), nextPacketId_(1),
+  inFlight_(), inFlightCount_(0), window_(MQTT_INFLIGHT_WINDOW), rejected_(), rejectedNext_(0),
+  aliasTopics_(), aliasCount_(0), aliasMax_(0), handler_(nullptr), handlerCtx_(nullptr),
+  subackId_(0), subackCode_(0), streaming_(false), streamLeft_(0), streamId_(0),
+  lastOutMs_(0), pingSentMs_(0) {
+    resetReceive();
+}
+
+void MqttConnection::resetReceive() {
+    rxHeader_ = 0;
+    rxLength_ = 0;
+    rxRead_ = 0;
+    rxLengthShift_ = 0;
+    rxInLength_ = false;
+}
+
+bool MqttConnection::connect(const char* clientId, const char* user, const char* pass, bool cleanSession) {
+    if (!client_ || !host_) {
+        state_ = MQTT_STATE_CONNECT_FAILED;
+        return false;
+    }
+    if (streaming_) abortStream();
+    if (client_->connected()) client_->stop();
+    state_ = MQTT_STATE_DISCONNECTED;
+    resetReceive();
+    pingSentMs_ = 0;
+    subackId_ = 0;
+
+    const bool v5 = version_ == MqttVersion::V5;
+    const size_t idLen = strlen(clientId);
+    const size_t userLen = user ? strlen(user) : 0;
+    const size_t passLen = pass ? strlen(pass) : 0;
+
+    uint8_t props[10];
+    size_t propsLen = 0;
+    if (v5 && !cleanSession && sessionExpiryS_ > 0) {
+        props[propsLen++] = PROP_SESSION_EXPIRY;
+        propsLen += putU32(props + propsLen, sessionExpiryS_);
+    }
+    if (v5) {
+        // Incoming packets larger than the receive buffer are discarded by the server
+        props[propsLen++] = PROP_MAXIMUM_PACKET_SIZE;
+        propsLen += putU32(props + propsLen, (uint32_t)(1 + varIntSize(MQTT_RX_BUFFER_SIZE) + MQTT_RX_BUFFER_SIZE));
+    }
+
+    // Variable header + payload
+    static const size_t CONNECT_MAX = 320;
+    const size_t bodyLen = 10 + (v5 ? varIntSize(propsLen) + propsLen : 0) + 2 + idLen +
+                           (user ? 2 + userLen : 0) + (pass ? 2 + passLen : 0);
+    if (bodyLen > CONNECT_MAX) {
+        Serial.println("[MQTT] CONNECT too large");
+        state_ = MQTT_STATE_CONNECT_FAILED;
+        return false;
+    }
+    uint8_t body[CONNECT_MAX];
+    size_t n = putString(body, "MQTT", 4);
+    body[n++] = (uint8_t)version_;
+    body[n++] = (user ? 0x80 : 0) | (pass ? 0x40 : 0) | (cleanSession ? 0x02 : 0);
+    n += putU16(body + n, keepAliveS_);
+    if (v5) {
+        n += putVarInt(body + n, (uint32_t)propsLen);
+        memcpy(body + n, props, propsLen);
+        n += propsLen;
+    }
+    n += putString(body + n, clientId, idLen);
+    if (user) n += putString(body + n, user, userLen);
+    if (pass) n += putString(body + n, pass, passLen);
+
+    if (!client_->connect(host_, port_)) {
+        state_ = MQTT_STATE_CONNECT_FAILED;
+        return false;
+    }
+
+    uint8_t head[5];
+    head[0] = MQTT_CONNECT << 4;
+    size_t headLen = 1 + putVarInt(head + 1, (uint32_t)n);
+    if (!writePacket(head, headLen, body, n)) {
+        state_ = MQTT_STATE_CONNECT_FAILED;
+        return false;
+    }
+
+    uint8_t header = 0;
+    size_t len = 0;
+    if (!readPacket(header, len, MQTT_CONNECT_TIMEOUT_MS) || (header >> 4) != MQTT_CONNACK || len < 2) {
+        dropConnection(MQTT_STATE_CONNECTION_TIMEOUT);
+        return false;
+    }
+    if (rxBuf_[1] != 0) {
+        dropConnection(rxBuf_[1]);
+        return false;
+    }
+
+    sessionPresent_ = (rxBuf_[0] & 0x01) != 0;
+    window_ = MQTT_INFLIGHT_WINDOW;
+    aliasCount_ = 0;
+    aliasMax_ = 0;
+    const size_t kept = len < MQTT_RX_BUFFER_SIZE ? len : MQTT_RX_BUFFER_SIZE;
+    if (v5 && kept > 2) parseConnackProperties(rxBuf_ + 2, kept - 2);
+    state_ = MQTT_STATE_CONNECTED;
+
+    // Publishes left unacknowledged by a lost connection: again with DUP set
+    // when the broker kept the session, as new messages otherwise
+    if (inFlightCount_ > 0 && !resendInFlight()) return false;
+    return true;
+}
+
+void MqttConnection::parseConnackProperties(const uint8_t* p, size_t len) {
+    PacketReader r = { p, len, true };
+    uint32_t propsLen = r.varInt();
+    PacketReader props = { r.p, propsLen < r.left ? propsLen : r.left, r.ok };
+    while (props.ok && props.left > 0) {
+        uint8_t id = props.u8();
+        if (id == PROP_RECEIVE_MAXIMUM) {
+            uint16_t receiveMax = props.u16();
+            if (receiveMax > 0 && receiveMax < window_) window_ = receiveMax;
+        } else if (id == PROP_TOPIC_ALIAS_MAXIMUM) {
+            uint16_t aliasMax = props.u16();
+            aliasMax_ = aliasMax < MQTT_TOPIC_ALIAS_SLOTS ? aliasMax : (uint16_t)MQTT_TOPIC_ALIAS_SLOTS;
+        } else {
+            skipProperty(props, id);
+        }
+    }
+}
+
+bool MqttConnection::connected() {
+    if (state_ != MQTT_STATE_CONNECTED) return false;
+    if (!client_->connected() && client_->available() <= 0) {
+        dropConnection(MQTT_STATE_CONNECTION_LOST);
+        return false;
+    }
+    return true;
+}
+
+void MqttConnection::disconnect() {
+    if (state_ == MQTT_STATE_CONNECTED) {
+        uint8_t packet[2] = { MQTT_DISCONNECT << 4, 0 };
+        writePacket(packet, sizeof(packet), nullptr, 0);
+    }
+    if (client_) client_->stop();
+    state_ = MQTT_STATE_DISCONNECTED;
+    streaming_ = false;
+    resetReceive();
+    // The caller has settled what was still pending (reported as not delivered)
+    releaseInFlight();
+}
+
+void MqttConnection::dropConnection(int state) {
+    if (client_) client_->stop();
+    state_ = state;
+    resetReceive();
+    pingSentMs_ = 0;
+}
+
+bool MqttConnection::writePacket(const uint8_t* head, size_t headLen, const uint8_t* body, size_t bodyLen) {
+    bool ok = client_->write(head, headLen) == headLen &&
+              (bodyLen == 0 || client_->write(body, bodyLen) == bodyLen);
+    if (!ok) {
+        dropConnection(MQTT_STATE_CONNECTION_LOST);
+        return false;
+    }
+    lastOutMs_ = millis();
+    return true;
+}
+
+size_t MqttConnection::publishHeader(uint8_t* head, const char* topic, size_t len, uint8_t qos,
+                                     bool retained, uint16_t packetId, bool dup) {
+    const size_t topicLen = strlen(topic);
+
+    // MQTT 5: the first publish to a topic registers an alias, later ones
+    // send only the alias with an empty topic name
+    uint16_t alias = 0;
+    bool sendTopic = true;
+    if (version_ == MqttVersion::V5 && aliasMax_ > 0) {
+        for (uint16_t i = 0; i < aliasCount_; ++i) {
+            if (strcmp(aliasTopics_[i], topic) == 0) {
+                alias = i + 1;
+                sendTopic = false;
+                break;
+            }
+        }
+        if (alias == 0 && aliasCount_ < aliasMax_) {
+            memcpy(aliasTopics_[aliasCount_], topic, topicLen + 1);
+            alias = ++aliasCount_;
+        }
+    }
+
+    uint8_t var[2 + MQTT_TOPIC_MAX_LEN + 2 + 4];
+    size_t varLen = putString(var, topic, sendTopic ? topicLen : 0);
+    if (qos > 0) varLen += putU16(var + varLen, packetId);
+    if (version_ == MqttVersion::V5) {
+        if (alias != 0) {
+            var[varLen++] = 3; // property length
+            var[varLen++] = PROP_TOPIC_ALIAS;
+            varLen += putU16(var + varLen, alias);
+        } else {
+            var[varLen++] = 0;
+        }
+    }
+
+    head[0] = (uint8_t)((MQTT_PUBLISH << 4) | (dup ? 0x08 : 0) | (qos << 1) | (retained ? 0x01 : 0));
+    size_t headLen = 1 + putVarInt(head + 1, (uint32_t)(varLen + len));
+    memcpy(head + headLen, var, varLen);
+    return headLen + varLen;
+}
+
+bool MqttConnection::sendPublish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos,
+                                 bool retained, uint16_t packetId, bool dup) {
+    uint8_t head[PUBLISH_HEADER_MAX];
+    size_t headLen = publishHeader(head, topic, len, qos, retained, packetId, dup);
+    return writePacket(head, headLen, payload, len);
+}
+
+bool MqttConnection::validTopic(const char* topic) const {
+    const size_t topicLen = topic ? strlen(topic) : 0;
+    if (topicLen == 0 || topicLen >= MQTT_TOPIC_MAX_LEN) {
+        Serial.printf("[MQTT] Invalid topic length %u\n", (unsigned)topicLen);
+        return false;
+    }
+    return true;
+}
+
+uint16_t MqttConnection::takePacketId() {
+    uint16_t id = nextPacketId_++;
+    if (nextPacketId_ == 0) nextPacketId_ = 1;
+    return id;
+}
+
+// Free in-flight slot for a QoS 1 publish, waiting for a PUBACK only when
+// the window is full; nullptr on timeout or lost connection
+MqttInFlight* MqttConnection::reserveSlot() {
+    const unsigned long start = millis();
+    while (inFlightCount_ >= window_) {
+        if (!loop()) return nullptr;
+        if (inFlightCount_ < window_) break;
+        if (millis() - start >= MQTT_ACK_TIMEOUT_MS) {
+            Serial.println("[MQTT] In-flight window full, no PUBACK");
+            return nullptr;
+        }
+        delay(1);
+    }
+    for (MqttInFlight& m : inFlight_) {
+        if (m.packetId == 0) return &m;
+    }
+    return nullptr;
+}
+
+void MqttConnection::releaseSlot(MqttInFlight& slot, bool rejected) {
+    if (rejected) {
+        rejected_[rejectedNext_] = slot.packetId;
+        rejectedNext_ = (rejectedNext_ + 1) % MQTT_INFLIGHT_WINDOW;
+    }
+    slot = {};
+    --inFlightCount_;
+}
+
+bool MqttConnection::publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos,
+                             bool retained, uint16_t* packetId) {
+    if (packetId) *packetId = 0;
+    if (streaming_ || !connected() || !validTopic(topic)) return false;
+    if (qos == 0) return sendPublish(topic, payload, len, 0, retained, 0, false);
+
+    // QoS 1 (QoS 2 is not supported and is sent as QoS 1). The message is
+    // kept for a resend in the slot's row of the in-flight arena.
+    if (len > MQTT_INFLIGHT_MAX_PAYLOAD) {
+        Serial.printf("[MQTT] Publish of %u bytes exceeds the in-flight buffer\n", (unsigned)len);
+        return false;
+    }
+    MqttInFlight* slot = reserveSlot();
+    if (!slot) return false;
+    const size_t topicLen = strlen(topic);
+    uint8_t* data = inFlightData_[slot - inFlight_];
+    memcpy(data, topic, topicLen + 1);
+    if (len > 0) memcpy(data + topicLen + 1, payload, len);
+
+    uint16_t id = takePacketId();
+    *slot = { id, retained, data, topicLen, len };
+    ++inFlightCount_;
+
+    if (!sendPublish(topic, payload, len, 1, retained, id, false)) {
+        // Not sent at all: the caller handles it (e.g. another transport)
+        releaseSlot(*slot, false);
+        return false;
+    }
+    if (packetId) *packetId = id;
+    return true;
+}
+
+bool MqttConnection::subscribe(const char* topic, uint8_t qos) {
+    if (streaming_ || !connected() || !validTopic(topic)) return false;
+
+    const size_t topicLen = strlen(topic);
+    const uint16_t id = takePacketId();
+    uint8_t body[2 + 1 + 2 + MQTT_TOPIC_MAX_LEN + 1];
+    size_t n = putU16(body, id);
+    if (version_ == MqttVersion::V5) body[n++] = 0; // no properties
+    n += putString(body + n, topic, topicLen);
+    body[n++] = qos > 0 ? 1 : 0; // subscription options: maximum QoS
+
+    uint8_t head[5];
+    head[0] = (MQTT_SUBSCRIBE << 4) | 0x02;
+    size_t headLen = 1 + putVarInt(head + 1, (uint32_t)n);
+    subackId_ = id;
+    if (!writePacket(head, headLen, body, n)) return false;
+
+    const unsigned long start = millis();
+    while (subackId_ != 0) {
+        if (!loop()) return false;
+        if (subackId_ == 0) break;
+        if (millis() - start >= MQTT_ACK_TIMEOUT_MS) {
+            Serial.println("[MQTT] No SUBACK from the broker");
+            subackId_ = 0;
+            return false;
+        }
+        delay(1);
+    }
+    if (subackCode_ >= 0x80) {
+        Serial.printf("[MQTT] Subscription to %s refused (0x%02x)\n", topic, subackCode_);
+        return false;
+    }
+    return true;
+}
+
+bool MqttConnection::beginPublish(const char* topic, size_t len, uint8_t qos, bool retained) {
+    if (streaming_) abortStream(); // the previous one was never completed
+    if (!connected() || !validTopic(topic)) return false;
+
+    uint16_t id = 0;
+    if (qos > 0) {
+        MqttInFlight* slot = reserveSlot();
+        if (!slot) return false;
+        id = takePacketId();
+        *slot = { id, retained, nullptr, strlen(topic), len };
+        ++inFlightCount_;
+    }
+
+    streaming_ = true;
+    streamLeft_ = len;
+    streamId_ = id;
+    uint8_t head[PUBLISH_HEADER_MAX];
+    size_t headLen = publishHeader(head, topic, len, qos > 0 ? 1 : 0, retained, id, false);
+    if (!writePacket(head, headLen, nullptr, 0)) {
+        abortStream();
+        return false;
+    }
+    return true;
+}
+
+size_t MqttConnection::write(const uint8_t* data, size_t len) {
+    if (!streaming_ || len == 0) return 0;
+    if (len > streamLeft_ || state_ != MQTT_STATE_CONNECTED || client_->write(data, len) != len) {
+        abortStream();
+        return 0;
+    }
+    streamLeft_ -= len;
+    lastOutMs_ = millis();
+    return len;
+}
+
+bool MqttConnection::endPublish(uint16_t* packetId) {
+    if (packetId) *packetId = 0;
+    if (!streaming_) return false;
+    if (streamLeft_ != 0 || state_ != MQTT_STATE_CONNECTED) {
+        if (streamLeft_ != 0) Serial.printf("[MQTT] Streamed publish %u bytes short\n", (unsigned)streamLeft_);
+        abortStream();
+        return false;
+    }
+    streaming_ = false;
+    if (packetId) *packetId = streamId_;
+    streamId_ = 0;
+    return true;
+}
+
+// A publish cut off after its header leaves the stream unframed: the
+// connection is dropped and the message was not sent
+void MqttConnection::abortStream() {
+    if (state_ == MQTT_STATE_CONNECTED) dropConnection(MQTT_STATE_CONNECTION_LOST);
+    for (MqttInFlight& m : inFlight_) {
+        if (streamId_ != 0 && m.packetId == streamId_) releaseSlot(m, false);
+    }
+    streaming_ = false;
+    streamLeft_ = 0;
+    streamId_ = 0;
+}
+
+bool MqttConnection::resendInFlight() {
+    // Oldest first: the further a packet id is behind the next one, the older
+    MqttInFlight* pending[MQTT_INFLIGHT_WINDOW];
+    size_t count = 0;
+    size_t streamed = 0;
+    for (MqttInFlight& m : inFlight_) {
+        if (m.packetId == 0) continue;
+        if (!m.data) {
+            // Streamed: the payload was not kept, report it as not delivered
+            releaseSlot(m, true);
+            ++streamed;
+            continue;
+        }
+        size_t i = count++;
+        const uint16_t age = (uint16_t)(nextPacketId_ - m.packetId);
+        while (i > 0 && (uint16_t)(nextPacketId_ - pending[i - 1]->packetId) < age) {
+            pending[i] = pending[i - 1];
+            --i;
+        }
+        pending[i] = &m;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const MqttInFlight& m = *pending[i];
+        if (!sendPublish((const char*)m.data, m.data + m.topicLen + 1, m.len, 1, m.retained,
+                         m.packetId, sessionPresent_)) {
+            return false;
+        }
+    }
+    if (streamed > 0) Serial.printf("[MQTT] %u streamed publishes lost with the connection\n", (unsigned)streamed);
+    if (count > 0) Serial.printf("[MQTT] Resent %u unacknowledged publishes\n", (unsigned)count);
+    return true;
+}
+
+void MqttConnection::releaseInFlight() {
+    for (MqttInFlight& m : inFlight_) m = {};
+    inFlightCount_ = 0;
+}
+
+bool MqttConnection::acked(uint16_t packetId) const {
+    if (packetId == 0) return true;
+    for (const MqttInFlight& m : inFlight_) {
+        if (m.packetId == packetId) return false;
+    }
+    for (uint16_t id : rejected_) {
+        if (id == packetId) return false;
+    }
+    return true;
+}
+
+bool MqttConnection::waitAck(uint16_t packetId, unsigned long timeoutMs) {
+    const unsigned long start = millis();
+    for (;;) {
+        bool pending = false;
+        for (const MqttInFlight& m : inFlight_) {
+            if (m.packetId == packetId && packetId != 0) pending = true;
+        }
+        if (!pending) return acked(packetId);
+        if (!loop() || millis() - start >= timeoutMs) return false;
+        delay(1);
+    }
+}
+
+bool MqttConnection::flush(unsigned long timeoutMs) {
+    const unsigned long start = millis();
+    while (inFlightCount_ > 0) {
+        if (!loop() || millis() - start >= timeoutMs) return false;
+        if (inFlightCount_ > 0) delay(1);
+    }
+    return true;
+}
+
+bool MqttConnection::loop() {
+    if (!connected()) return false;
+    // Nothing is read while a streamed publish is open: an incoming PUBLISH
+    // would need its PUBACK written into the middle of it
+    if (streaming_) return true;
+
+    uint8_t header;
+    size_t len;
+    while (state_ == MQTT_STATE_CONNECTED && pollPacket(header, len)) handlePacket(header, len);
+    if (state_ != MQTT_STATE_CONNECTED) return false;
+
+    if (keepAliveS_ > 0) {
+        const unsigned long now = millis();
+        const unsigned long keepAliveMs = keepAliveS_ * 1000UL;
+        if (pingSentMs_ != 0 && now - pingSentMs_ > keepAliveMs) {
+            Serial.println("[MQTT] No PINGRESP, connection lost");
+            dropConnection(MQTT_STATE_CONNECTION_TIMEOUT);
+            return false;
+        }
+        if (pingSentMs_ == 0 && now - lastOutMs_ >= keepAliveMs) {
+            uint8_t ping[2] = { MQTT_PINGREQ << 4, 0 };
+            if (!writePacket(ping, sizeof(ping), nullptr, 0)) return false;
+            pingSentMs_ = now != 0 ? now : 1;
+        }
+    }
+    return true;
+}
+
+bool MqttConnection::pollPacket(uint8_t& header, size_t& len) {
+    while (client_->available() > 0) {
+        if (rxHeader_ == 0) {
+            int c = client_->read();
+            if (c < 0) return false;
+            if (c == 0) { // packet type 0 is reserved
+                dropConnection(MQTT_STATE_CONNECTION_LOST);
+                return false;
+            }
+            rxHeader_ = (uint8_t)c;
+            rxInLength_ = true;
+            rxLength_ = 0;
+            rxLengthShift_ = 0;
+            rxRead_ = 0;
+            continue;
+        }
+        if (rxInLength_) {
+            int c = client_->read();
+            if (c < 0) return false;
+            rxLength_ |= (uint32_t)(c & 0x7F) << rxLengthShift_;
+            rxLengthShift_ += 7;
+            if (c & 0x80) {
+                if (rxLengthShift_ > 21) {
+                    dropConnection(MQTT_STATE_CONNECTION_LOST);
+                    return false;
+                }
+                continue;
+            }
+            rxInLength_ = false;
+        } else {
+            // Body: what fits the buffer is kept, the rest only read
+            uint8_t scratch[32];
+            size_t want = rxLength_ - rxRead_;
+            uint8_t* dst = scratch;
+            if (rxRead_ < MQTT_RX_BUFFER_SIZE) {
+                dst = rxBuf_ + rxRead_;
+                if (want > MQTT_RX_BUFFER_SIZE - rxRead_) want = MQTT_RX_BUFFER_SIZE - rxRead_;
+            } else if (want > sizeof(scratch)) {
+                want = sizeof(scratch);
+            }
+            int n = client_->read(dst, want);
+            if (n <= 0) return false;
+            rxRead_ += (uint32_t)n;
+        }
+        if (!rxInLength_ && rxRead_ == rxLength_) {
+            header = rxHeader_;
+            len = rxLength_;
+            rxHeader_ = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MqttConnection::readPacket(uint8_t& header, size_t& len, unsigned long timeoutMs) {
+    const unsigned long start = millis();
+    for (;;) {
+        if (pollPacket(header, len)) return true;
+        if (!client_->connected() && client_->available() <= 0) return false;
+        if (millis() - start >= timeoutMs) return false;
+        delay(1);
+    }
+}
+
+void MqttConnection::handlePacket(uint8_t header, size_t len) {
+    switch (header >> 4) {
+        case MQTT_PUBACK: {
+            if (len < 2) break;
+            const uint16_t id = (uint16_t)((rxBuf_[0] << 8) | rxBuf_[1]);
+            const uint8_t reason = (version_ == MqttVersion::V5 && len >= 3) ? rxBuf_[2] : 0;
+            for (MqttInFlight& m : inFlight_) {
+                if (m.packetId != id) continue;
+                if (reason >= 0x80) {
+                    Serial.printf("[MQTT] Publish %u rejected by the broker (0x%02x)\n", (unsigned)id, reason);
+                }
+                releaseSlot(m, reason >= 0x80);
+                break;
+            }
+            break;
+        }
+        case MQTT_PUBLISH:
+            handlePublish(header, len);
+            break;
+        case MQTT_SUBACK: {
+            // Packet id, properties (MQTT 5), one return code per topic
+            PacketReader r = { rxBuf_, len < MQTT_RX_BUFFER_SIZE ? len : MQTT_RX_BUFFER_SIZE, true };
+            const uint16_t id = r.u16();
+            if (version_ == MqttVersion::V5) r.skip(r.varInt());
+            const uint8_t code = r.u8();
+            if (r.ok && id == subackId_) {
+                subackCode_ = code;
+                subackId_ = 0;
+            }
+            break;
+        }
+        case MQTT_PINGRESP:
+            pingSentMs_ = 0;
+            break;
+        case MQTT_DISCONNECT:
+            Serial.printf("[MQTT] Broker disconnected (reason 0x%02x)\n", len > 0 ? rxBuf_[0] : 0);
+            dropConnection(MQTT_STATE_CONNECTION_LOST);
+            break;
+        default:
+            break;
+    }
+}
+
+void MqttConnection::handlePublish(uint8_t header, size_t len) {
+    const uint8_t qos = (header >> 1) & 0x03;
+    const bool complete = len <= MQTT_RX_BUFFER_SIZE;
+    PacketReader r = { rxBuf_, complete ? len : MQTT_RX_BUFFER_SIZE, true };
+
+    char topic[MQTT_TOPIC_MAX_LEN];
+    const size_t topicLen = r.u16();
+    const uint8_t* topicName = r.p;
+    r.skip(topicLen);
+    const uint16_t id = qos > 0 ? r.u16() : 0;
+    if (version_ == MqttVersion::V5) r.skip(r.varInt()); // properties: none used
+    if (!r.ok || qos > 1) {
+        // QoS 2 is never granted by subscribe(); a header cut off by the buffer has no id to ack
+        Serial.println("[MQTT] Unreadable incoming publish dropped");
+        return;
+    }
+
+    if (!complete) {
+        Serial.printf("[MQTT] Incoming publish of %u bytes dropped (MQTT_RX_BUFFER_SIZE)\n", (unsigned)len);
+    } else if (topicLen == 0 || topicLen >= sizeof(topic)) {
+        Serial.println("[MQTT] Incoming publish without a usable topic dropped");
+    } else if (handler_) {
+        memcpy(topic, topicName, topicLen);
+        topic[topicLen] = '\0';
+        if (!handler_(handlerCtx_, topic, r.p, r.left)) return; // redelivered after a reconnect
+    }
+
+    // Dropped messages are acknowledged too, so the server does not send them again
+    if (qos == 1) {
+        uint8_t puback[4] = { MQTT_PUBACK << 4, 2 };
+        putU16(puback + 2, id);
+        writePacket(puback, sizeof(puback), nullptr, 0);
+    }
+}
@@ -0,0 +1,69 @@
+#include "network_manager.h"
+
+// Event group bits
+static const EventBits_t NET_ONLINE_BIT = 1 << 0;
+static const EventBits_t NET_DOWN_BIT = 1 << 1;
+
+NetworkManager& networkManager() {
+    static NetworkManager manager;
+    return manager;
+}
+
+static void onWifiEvent(arduino_event_id_t event) {
+    networkManager().handleEvent(event);
+}
+
+void NetworkManager::begin() {
+    if (events_ != nullptr) return;
+    events_ = xEventGroupCreate();
+    xEventGroupSetBits(events_, NET_DOWN_BIT);
+    WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_LOST_IP);
+    WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_STOP);
+}
+
+void NetworkManager::connecting() {
+    begin();
+    xEventGroupClearBits(events_, NET_ONLINE_BIT | NET_DOWN_BIT);
+    connectStart_ = millis();
+    state_ = NetState::Connecting;
+}
+
+void NetworkManager::handleEvent(arduino_event_id_t event) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+            if (state_ != NetState::Online) state_ = NetState::Associated;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            lastConnectMs_ = millis() - connectStart_;
+            state_ = NetState::Online;
+            xEventGroupClearBits(events_, NET_DOWN_BIT);
+            xEventGroupSetBits(events_, NET_ONLINE_BIT);
+            break;
+        case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+            // Still associated; DHCP may hand out an address again
+            state_ = NetState::Associated;
+            xEventGroupClearBits(events_, NET_ONLINE_BIT);
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        case ARDUINO_EVENT_WIFI_STA_STOP:
+            state_ = NetState::Down;
+            xEventGroupClearBits(events_, NET_ONLINE_BIT);
+            xEventGroupSetBits(events_, NET_DOWN_BIT);
+            break;
+        default:
+            break;
+    }
+}
+
+bool NetworkManager::waitOnline(unsigned long timeoutMs, bool failFast) {
+    begin();
+    if (online()) return true;
+
+    // Only a down event raised after this connect started counts for failFast
+    const EventBits_t waitFor = NET_ONLINE_BIT | (failFast ? NET_DOWN_BIT : 0);
+    EventBits_t bits = xEventGroupWaitBits(events_, waitFor, pdFALSE, pdFALSE, pdMS_TO_TICKS(timeoutMs));
+    return (bits & NET_ONLINE_BIT) != 0;
+}
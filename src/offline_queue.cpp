@@ -0,0 +1,203 @@
+#include "offline_queue.h"
+#include "config.h"
+#include "crc32.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <string.h>
+
+static const char* QUEUE_DIR = "/queue";
+static constexpr uint32_t RECORD_MAGIC = 0x51434741; // "AGCQ"
+
+// One cycle as stored in flash
+struct QueueRecord {
+    uint32_t magic;
+    uint32_t session;  // power session the timestamp belongs to
+    uint32_t timestamp;
+    float values[SENSOR_CONFIG_COUNT];
+    uint32_t crc;      // CRC-32 of every field above
+};
+
+// Power session of the device clock: time() restarts on power-up, so
+// timestamps from different sessions cannot be compared. Set on the first
+// mount after a cold boot, one above the newest session found in flash.
+RTC_DATA_ATTR static uint32_t rtcSession = 0;
+
+// Set while the flash queue is known to be empty
+RTC_DATA_ATTR static bool rtcKnownEmpty = false;
+
+// Segment index, rebuilt at the first mount of every wake
+static bool mounted = false;
+static uint32_t oldestSeq = 0;     // valid when segmentCount > 0
+static uint32_t newestSeq = 0;
+static size_t segmentCount = 0;
+static size_t newestRecords = 0;   // records in the newest segment
+static uint32_t newestSession = 0; // session of the newest segment
+static bool newestSealed = true;   // true: the next append starts a new segment
+
+static bool recordValid(const QueueRecord& r) {
+    return r.magic == RECORD_MAGIC && r.crc == crc32(&r, offsetof(QueueRecord, crc));
+}
+
+static void segmentPath(uint32_t seq, char* out, size_t outSize) {
+    snprintf(out, outSize, "%s/%08lu.seg", QUEUE_DIR, (unsigned long)seq);
+}
+
+// Sequence number of a segment file name, or -1
+static long segmentSeq(const char* name) {
+    const char* base = strrchr(name, '/');
+    base = base ? base + 1 : name;
+    if (strlen(base) != 12 || strcmp(base + 8, ".seg") != 0) return -1;
+    long seq = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (base[i] < '0' || base[i] > '9') return -1;
+        seq = seq * 10 + (base[i] - '0');
+    }
+    return seq;
+}
+
+// Index the newest segment: record count, session, and whether a torn
+// record at its end forbids appending to it
+static void indexNewest() {
+    char path[32];
+    segmentPath(newestSeq, path, sizeof(path));
+    File f = LittleFS.open(path, "r");
+    if (!f) {
+        newestSealed = true;
+        return;
+    }
+    size_t size = f.size();
+    newestRecords = size / sizeof(QueueRecord);
+    newestSealed = (size % sizeof(QueueRecord)) != 0 || newestRecords >= READING_BATCH_MAX_CYCLES;
+    newestSession = 0;
+    QueueRecord r;
+    for (size_t i = newestRecords; i-- > 0;) {
+        f.seek(i * sizeof(QueueRecord));
+        if (f.read((uint8_t*)&r, sizeof(r)) == sizeof(r) && recordValid(r)) {
+            newestSession = r.session;
+            break;
+        }
+    }
+    f.close();
+}
+
+bool queueBegin() {
+    if (mounted) return true;
+    if (!LittleFS.begin(true)) {
+        Serial.println("[QUEUE] LittleFS mount failed");
+        return false;
+    }
+    if (!LittleFS.exists(QUEUE_DIR)) LittleFS.mkdir(QUEUE_DIR);
+
+    File dir = LittleFS.open(QUEUE_DIR);
+    if (!dir || !dir.isDirectory()) {
+        Serial.println("[QUEUE] Cannot open queue directory");
+        return false;
+    }
+    segmentCount = 0;
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        long seq = segmentSeq(f.name());
+        if (seq < 0) continue;
+        if (segmentCount == 0 || (uint32_t)seq < oldestSeq) oldestSeq = (uint32_t)seq;
+        if (segmentCount == 0 || (uint32_t)seq > newestSeq) newestSeq = (uint32_t)seq;
+        ++segmentCount;
+    }
+    dir.close();
+
+    newestSealed = true;
+    if (segmentCount > 0) {
+        // Segments are created and deleted in order, so the range has no gaps
+        segmentCount = newestSeq - oldestSeq + 1;
+        indexNewest();
+    }
+    if (rtcSession == 0) rtcSession = newestSession + 1;
+
+    rtcKnownEmpty = segmentCount == 0;
+    mounted = true;
+    Serial.printf("[QUEUE] %u segments pending\n", (unsigned)segmentCount);
+    return true;
+}
+
+bool queueAppend(const uint32_t* timestamps, const float* values, size_t cycles) {
+    if (!queueBegin()) return false;
+
+    for (size_t c = 0; c < cycles; ++c) {
+        if (segmentCount == 0 || newestSealed || newestSession != rtcSession) {
+            if (segmentCount >= OFFLINE_QUEUE_MAX_SEGMENTS) {
+                Serial.println("[QUEUE] Full, dropping the oldest segment");
+                queuePopOldest();
+            }
+            newestSeq = segmentCount == 0 ? oldestSeq : newestSeq + 1;
+            ++segmentCount;
+            newestRecords = 0;
+            newestSession = rtcSession;
+            newestSealed = false;
+        }
+
+        QueueRecord r;
+        r.magic = RECORD_MAGIC;
+        r.session = rtcSession;
+        r.timestamp = timestamps[c];
+        memcpy(r.values, values + c * SENSOR_CONFIG_COUNT, sizeof(r.values));
+        r.crc = crc32(&r, offsetof(QueueRecord, crc));
+
+        char path[32];
+        segmentPath(newestSeq, path, sizeof(path));
+        File f = LittleFS.open(path, "a");
+        bool ok = f && f.write((const uint8_t*)&r, sizeof(r)) == sizeof(r);
+        if (f) f.close(); // the record is committed to flash on close
+        if (!ok) {
+            Serial.println("[QUEUE] Write failed");
+            newestSealed = true;
+            return false;
+        }
+        rtcKnownEmpty = false;
+        if (++newestRecords >= READING_BATCH_MAX_CYCLES) newestSealed = true;
+    }
+
+    Serial.printf("[QUEUE] Stored %u cycles, %u segments pending\n",
+                  (unsigned)cycles, (unsigned)segmentCount);
+    return true;
+}
+
+size_t queueSegmentCount() {
+    return queueBegin() ? segmentCount : 0;
+}
+
+bool queuePending() {
+    return !rtcKnownEmpty;
+}
+
+size_t queueRead(size_t index, uint32_t* timestamps, float* values, bool& currentSession) {
+    currentSession = false;
+    if (!queueBegin() || index >= segmentCount) return 0;
+
+    char path[32];
+    segmentPath(oldestSeq + (uint32_t)index, path, sizeof(path));
+    File f = LittleFS.open(path, "r");
+    if (!f) return 0;
+
+    size_t count = 0;
+    QueueRecord r;
+    while (count < READING_BATCH_MAX_CYCLES && f.read((uint8_t*)&r, sizeof(r)) == sizeof(r)) {
+        if (!recordValid(r)) continue; // torn or corrupt record
+        timestamps[count] = r.timestamp;
+        memcpy(values + count * SENSOR_CONFIG_COUNT, r.values, sizeof(r.values));
+        currentSession = r.session == rtcSession;
+        ++count;
+    }
+    f.close();
+    return count;
+}
+
+void queuePopOldest() {
+    if (!queueBegin() || segmentCount == 0) return;
+    char path[32];
+    segmentPath(oldestSeq, path, sizeof(path));
+    LittleFS.remove(path);
+    ++oldestSeq;
+    --segmentCount;
+    if (segmentCount == 0) {
+        newestSealed = true;
+        rtcKnownEmpty = true;
+    }
+}
@@ -0,0 +1,72 @@
+#include "reading_batch.h"
+#include "config.h"
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+// One row per wake cycle, in RTC memory: survives deep sleep, lost on power cycle
+RTC_DATA_ATTR static uint32_t rtcTimestamps[READING_BATCH_MAX_CYCLES];
+RTC_DATA_ATTR static float rtcValues[READING_BATCH_MAX_CYCLES][SENSOR_CONFIG_COUNT];
+RTC_DATA_ATTR static size_t rtcCycleCount = 0;
+
+static_assert(READING_BATCH_MAX_CYCLES > 0 && READING_BATCH_MAX_CYCLES <= 255,
+              "READING_BATCH_MAX_CYCLES must fit DeviceConfig::uploadEveryCycles");
+// RTC slow memory is 8 KB on the ESP32 and is shared with other RTC data
+static_assert(sizeof(rtcTimestamps) + sizeof(rtcValues) <= 4096,
+              "Reading batch does not fit RTC memory; lower READING_BATCH_MAX_CYCLES");
+
+// Column of a sample: the factory binds the SENSOR_CONFIGS uuid pointers
+static int configIndexOf(const char* uuid) {
+    for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) {
+        if (SENSOR_CONFIGS[i].uuid == uuid) return (int)i;
+    }
+    for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) {
+        if (uuid && strcmp(SENSOR_CONFIGS[i].uuid, uuid) == 0) return (int)i;
+    }
+    return -1;
+}
+
+void batchRowFromSamples(const SensorSample* samples, size_t count, float* row) {
+    for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) row[i] = NAN;
+    for (size_t i = 0; i < count; ++i) {
+        int column = configIndexOf(samples[i].uuid);
+        if (column >= 0 && samples[i].ok) row[column] = samples[i].value;
+    }
+}
+
+void batchAppend(uint32_t timestamp, const SensorSample* samples, size_t count) {
+    if (rtcCycleCount == READING_BATCH_MAX_CYCLES) {
+        // Rows are shifted so the batch stays contiguous for the serializer
+        memmove(rtcTimestamps, rtcTimestamps + 1, sizeof(rtcTimestamps[0]) * (READING_BATCH_MAX_CYCLES - 1));
+        memmove(rtcValues, rtcValues + 1, sizeof(rtcValues[0]) * (READING_BATCH_MAX_CYCLES - 1));
+        --rtcCycleCount;
+        Serial.println("[BATCH] Full, dropped the oldest cycle");
+    }
+
+    batchRowFromSamples(samples, count, rtcValues[rtcCycleCount]);
+    rtcTimestamps[rtcCycleCount] = timestamp;
+    ++rtcCycleCount;
+
+    Serial.printf("[BATCH] Stored cycle %u/%u at t=%u s\n",
+                  (unsigned)rtcCycleCount, (unsigned)READING_BATCH_MAX_CYCLES, (unsigned)timestamp);
+}
+
+size_t batchCycleCount() {
+    return rtcCycleCount;
+}
+
+bool batchFull() {
+    return rtcCycleCount >= READING_BATCH_MAX_CYCLES;
+}
+
+const uint32_t* batchTimestamps() {
+    return rtcTimestamps;
+}
+
+const float* batchValues() {
+    return &rtcValues[0][0];
+}
+
+void batchClear() {
+    rtcCycleCount = 0;
+}
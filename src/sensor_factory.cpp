@@ -1,45 +1,22 @@
-#include "sensor.h"
-#include "config.h"
+#include "sensor_registry.h"
 #include <Arduino.h>
-#include <cstring>
-#include <vector>
-#include <memory>
-#include <algorithm>
 
-// Registry using a vector of pairs to avoid manual malloc and linked list
-static std::vector<std::pair<const char*, CreatorFunc>>& registry() {
-    static std::vector<std::pair<const char*, CreatorFunc>> r;
-    return r;
-}
-
-bool registerSensorFactory(const char* name, CreatorFunc creator) {
-    registry().emplace_back(name, creator);
-    return true;
-}
-
-SensorBase* createSensorByType(const char* name, const SensorConfig& cfg) {
-    for (auto &p : registry()) {
-        if (strcmp(p.first, name) == 0) return p.second(cfg);
-    }
-    return nullptr;
-}
-
-std::vector<std::unique_ptr<SensorBase>> createSensors() {
-    std::vector<std::unique_ptr<SensorBase>> vec;
-    vec.reserve(SENSOR_CONFIG_COUNT);
+SensorDevice* const* createSensors() {
+    static SensorDevice* devices[SENSOR_DEVICE_COUNT] = {};
+    static bool created = false;
+    if (created) return devices;
 
+    // Types, grouping and pool sizes were resolved at compile time; only the
+    // constructors and UUID bindings are left for boot
     for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) {
         const SensorConfig &cfg = SENSOR_CONFIGS[i];
-        SensorBase* inst = createSensorByType(cfg.type, cfg);
-        if (!inst) {
-            // Unknown type -> fallback to registered SIMULATED creator if present
-            inst = createSensorByType("SIMULATED", cfg);
-            if (!inst) {
-                // skip sensor if we cannot create it
-                continue;
-            }
-        }
-        vec.emplace_back(inst);
+        const SensorTypeEntry &type = SENSOR_TYPES[SENSOR_PLAN.typeOf[i]];
+        const size_t d = SENSOR_PLAN.deviceOf[i];
+
+        if (SENSOR_PLAN.opensDevice[i]) devices[d] = type.creator(cfg.pin);
+        devices[d]->bindChannel(type.channel, cfg.uuid);
+        devices[d]->bindPower(cfg.powerPin, cfg.warmupMs);
     }
-    return vec;
+    created = true;
+    return devices;
 }
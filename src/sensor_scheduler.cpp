@@ -0,0 +1,163 @@
+#include "sensor_scheduler.h"
+#include "config.h"
+#include "sensor_registry.h"
+#include <Arduino.h>
+#include <driver/gpio.h>
+
+// Write one sample per bound channel of a device, starting at `slot`
+static void storeSamples(const SensorDevice& dev, const float* values, bool ok,
+                         unsigned long latencyMs, SensorSample* out, size_t slot, size_t end) {
+    for (size_t ch = 0; ch < dev.channelCount() && slot < end; ++ch) {
+        const char* uuid = dev.channelUuid(ch);
+        if (!uuid) continue;
+        out[slot++] = { uuid, ok ? values[ch] : 0.0f, ok, latencyMs };
+    }
+}
+
+// First bound UUID, used to name the device in log messages
+static const char* deviceName(const SensorDevice& dev) {
+    for (size_t ch = 0; ch < dev.channelCount(); ++ch) {
+        if (dev.channelUuid(ch)) return dev.channelUuid(ch);
+    }
+    return "(unbound)";
+}
+
+static size_t boundChannels(const SensorDevice& dev) {
+    size_t n = 0;
+    for (size_t ch = 0; ch < dev.channelCount(); ++ch) {
+        if (dev.channelUuid(ch)) ++n;
+    }
+    return n;
+}
+
+// Drive a sensor supply rail. An off rail is latched with gpio hold so it
+// stays off through deep sleep instead of floating (and leaking) until wake.
+static void setSensorPower(int pin, bool on) {
+    gpio_hold_dis((gpio_num_t)pin);
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, on ? HIGH : LOW);
+    if (!on) {
+        gpio_hold_en((gpio_num_t)pin);
+#if CONFIG_IDF_TARGET_ESP32
+        gpio_deep_sleep_hold_en(); // classic ESP32 only keeps digital pads held with this
+#endif
+    }
+}
+
+AcquisitionReport acquireSensors(SensorDevice* const* devices, size_t deviceCount,
+                                 SensorSample* out, size_t maxSamples) {
+    if (deviceCount > SENSOR_DEVICE_COUNT) deviceCount = SENSOR_DEVICE_COUNT;
+    AcquisitionReport report = { deviceCount, 0, 0, 0, 0 };
+    if (deviceCount == 0 || devices == nullptr || out == nullptr) return report;
+
+    enum : uint8_t { WARMING, CONVERTING, DONE };
+    uint8_t state[SENSOR_DEVICE_COUNT] = {};
+    unsigned long startedAt[SENSOR_DEVICE_COUNT] = {};
+    size_t firstSlot[SENSOR_DEVICE_COUNT] = {};
+    size_t order[SENSOR_DEVICE_COUNT] = {};
+    size_t remaining = deviceCount;
+    float values[MAX_SENSOR_CHANNELS];
+
+    // Every bound channel gets a fixed slot so the output keeps config order
+    // regardless of which device finishes first
+    for (size_t i = 0; i < deviceCount; ++i) {
+        firstSlot[i] = report.sampleCount;
+        report.sampleCount += boundChannels(*devices[i]);
+    }
+    if (report.sampleCount > maxSamples) report.sampleCount = maxSamples;
+
+    // Visit devices by readiness deadline (warm-up), earliest first
+    for (size_t i = 0; i < deviceCount; ++i) {
+        size_t k = i;
+        for (; k > 0 && devices[order[k - 1]]->warmupMs() > devices[i]->warmupMs(); --k) {
+            order[k] = order[k - 1];
+        }
+        order[k] = i;
+    }
+
+    // Devices read too recently for the part repeat their last result
+    const unsigned long cycleStart = millis();
+    for (size_t i = 0; i < deviceCount; ++i) {
+        if (devices[i]->readDue(cycleStart)) continue;
+        bool ok = devices[i]->lastRead(values);
+        storeSamples(*devices[i], values, ok, 0, out, firstSlot[i], report.sampleCount);
+        state[i] = DONE;
+        --remaining;
+    }
+
+    // Phase 1: switch every gated supply still needed on at once so the warm-ups overlap
+    for (size_t i = 0; i < deviceCount; ++i) {
+        int pin = devices[i]->powerPin();
+        bool seen = false;
+        for (size_t j = 0; j < i && !seen; ++j) seen = devices[j]->powerPin() == pin && state[j] != DONE;
+        if (pin >= 0 && state[i] != DONE && !seen) setSensorPower(pin, true);
+    }
+
+    // Store the result of a device and cut its supply once no other device on
+    // the same rail still needs it. Reads are stamped with the cycle start, so
+    // cycles that far apart read the part again.
+    auto finish = [&](size_t i, bool ok) {
+        unsigned long latency = millis() - cycleStart;
+        devices[i]->recordRead(values, ok, cycleStart);
+        storeSamples(*devices[i], values, ok, latency, out, firstSlot[i], report.sampleCount);
+        report.sequentialMs += latency;
+        state[i] = DONE;
+        --remaining;
+
+        int pin = devices[i]->powerPin();
+        if (pin < 0) return;
+        for (size_t j = 0; j < deviceCount; ++j) {
+            if (state[j] != DONE && devices[j]->powerPin() == pin) return;
+        }
+        for (size_t j = 0; j < deviceCount; ++j) {
+            if (devices[j]->powerPin() == pin) devices[j]->powerDown();
+        }
+        setSensorPower(pin, false);
+    };
+
+    // Phase 2: start every device whose warm-up has elapsed back to back, then
+    // poll, collecting each result as soon as it is ready. Devices becoming due
+    // together start before any of them is polled, so they can share work (e.g.
+    // one ADC burst).
+    while (remaining > 0) {
+        for (size_t k = 0; k < deviceCount; ++k) {
+            const size_t i = order[k];
+            if (state[i] != WARMING || millis() - cycleStart < devices[i]->warmupMs()) continue;
+            startedAt[i] = millis();
+            if (devices[i]->start()) {
+                state[i] = CONVERTING;
+            } else {
+                Serial.print("Failed to start conversion on sensor ");
+                Serial.println(deviceName(*devices[i]));
+                finish(i, false);
+            }
+        }
+
+        for (size_t k = 0; k < deviceCount; ++k) {
+            const size_t i = order[k];
+            if (state[i] != CONVERTING) continue;
+            if (devices[i]->ready()) {
+                finish(i, devices[i]->collect(values));
+            } else if (millis() - startedAt[i] >= SENSOR_ACQUISITION_TIMEOUT_MS) {
+                Serial.print("Sensor timed out: ");
+                Serial.println(deviceName(*devices[i]));
+                finish(i, false);
+            }
+        }
+
+        if (remaining > 0) delay(1); // let the conversions progress (and the idle task run)
+    }
+
+    for (size_t i = 0; i < report.sampleCount; ++i) {
+        if (out[i].ok) ++report.okCount;
+    }
+    report.wallMs = millis() - cycleStart;
+    return report;
+}
+
+void printAcquisitionReport(const AcquisitionReport& report) {
+    unsigned long saved = report.sequentialMs > report.wallMs ? report.sequentialMs - report.wallMs : 0;
+    Serial.printf("[ACQ] %u/%u values from %u devices in %lu ms (sequential %lu ms, saved %lu ms)\n",
+                  (unsigned)report.okCount, (unsigned)report.sampleCount, (unsigned)report.deviceCount,
+                  report.wallMs, report.sequentialMs, saved);
+}
@@ -1,7 +1,9 @@
 // sensors.cpp is now a placeholder. Individual sensor implementations live in:
-// - src/dht11_temp.cpp
-// - src/dht11_hum.cpp
+// - src/dht11_sensor.cpp
+// - src/dht20_sensors.cpp
+// - src/soil_moisture.cpp
+// - src/battery_level.cpp
 // - src/simulated.cpp
-// The factory/registry is implemented in src/sensor_factory.cpp
+// The type table is in include/sensor_registry.h, the factory in src/sensor_factory.cpp
 
 // This file intentionally left minimal to keep the project readable.
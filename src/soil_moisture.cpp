@@ -1,6 +1,8 @@
 #include "sensor.h"
 #include "config.h"
 #include "sensor_creator.h"
+#include "adc_sampler.h"
+#include "signal_filter.h"
 #include <Arduino.h>
 
 /**
@@ -9,25 +11,26 @@
  * - Connected to GPIO32 (ADC1_CH4)
  * - Requires calibration (air value = dry, water value = wet)
  * - Returns moisture percentage: 0% (dry) to 100% (wet)
+ * - Sampled through the shared ADC burst (adc_sampler.h)
  */
+// Filter history per ADC slot, kept across deep sleep
+static RTC_DATA_ATTR SignalFilterState soilFilterState[AdcSampler::MAX_CHANNELS];
+
 class SoilMoistureSensor : public SensorBase {
 public:
-    SoilMoistureSensor(int pin, const char* uid)
-    : pin_(pin), uuid_(uid) {}
-    
-    const char* uuid() const override { return uuid_; }
+    explicit SoilMoistureSensor(int pin)
+    : pin_(pin), adcSlot_(sharedAdcSampler().registerPin(pin)) {}
     
+    unsigned long minWarmupMs() const override { return SOIL_MOISTURE_WARMUP_MS; }
+
+    bool start() override { return sharedAdcSampler().requestBurst(adcSlot_); }
+    bool ready() override { return sharedAdcSampler().poll(adcSlot_); }
+
     bool read(float &out) override {
-        // Average multiple readings for stability
-        const int numSamples = 10;
-        long sum = 0;
-        
-        for (int i = 0; i < numSamples; i++) {
-            sum += analogRead(pin_);
-            delay(10);
-        }
-        
-        int rawValue = sum / numSamples;
+        // Burst average over ADC_BURST_SAMPLES conversions
+        AdcChannelResult sample;
+        if (!sharedAdcSampler().take(adcSlot_, sample)) return false;
+        int rawValue = sample.raw;
         
         // Calibration values (MUST be determined empirically)
         // These are estimates scaled from Arduino 10-bit to ESP32 12-bit ADC
@@ -44,14 +47,21 @@ public:
         // Convert to percentage: 100% = wet (waterValue), 0% = dry (airValue)
         float moisturePercent = 100.0f * (float)(airValue - rawValue) / (float)(airValue - waterValue);
         
-        out = moisturePercent;
+        // Drop single-reading spikes (reported as a failed reading), smooth
+        // the rest across wake cycles
+        if (!filterSample(soilFilterState[adcSlot_], moisturePercent, SOIL_MOISTURE_MAX_STEP,
+                          SOIL_MOISTURE_CONFIRMATIONS, SOIL_MOISTURE_EMA_ALPHA, SENSORS_READ_INTERVAL_MS,
+                          filterClockMs(), out)) {
+            Serial.printf("Soil moisture outlier rejected: %.1f%% (last accepted %.1f%%)\n", moisturePercent, out);
+            return false;
+        }
         return true;
     }
     
 private:
     int pin_;
-    const char* uuid_;
+    int adcSlot_;
 };
 
-// Auto-register with factory using standard creator template
-static bool _reg = registerSensorFactory("SoilMoistureSensor", create_sensor_impl<SoilMoistureSensor>);
+static StaticSensorPool<SoilMoistureSensor, createSoilMoistureSensor> pool;
+SensorDevice* createSoilMoistureSensor(int pin) { return pool.create(pin); }
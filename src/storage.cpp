@@ -1,74 +1,274 @@
 #include "storage.h"
+#include "config.h"
+#include "crc32.h"
+#include <stddef.h>
+#include <string.h>
+
+static constexpr uint16_t STORAGE_RECORD_VERSION = 1;
+static const char* const RECORD_NAMESPACE = "device";
+static const char* const RECORD_SLOTS[2] = {"rec_a", "rec_b"};
+
+// DeviceRecord::configKeys bits
+enum : uint8_t {
+  CONFIG_BASE_URL = 1 << 0,
+  CONFIG_INTERVAL = 1 << 1,
+  CONFIG_MQTT_ENABLED = 1 << 2,
+  CONFIG_UPLOAD_EVERY = 1 << 3,
+  CONFIG_PAYLOAD_ENC = 1 << 4,
+  CONFIG_ALWAYS_ON = 1 << 5,
+  CONFIG_SENSOR_MASK = 1 << 6,
+};
+
+// Namespaces of the per-key layout, read once by migrateKeys()
+static const char* const LEGACY_NAMESPACES[] = {"wifi", "auth", "mqtt", "config", "lora"};
+
+static uint32_t recordCrc(const DeviceRecord &rec) {
+  return crc32(&rec, offsetof(DeviceRecord, crc));
+}
+
+// Copy into a fixed record buffer; false (dst unchanged) if it does not fit
+static bool copyField(char *dst, size_t size, const String &src) {
+  if (src.length() >= size) return false;
+  memcpy(dst, src.c_str(), src.length() + 1);
+  return true;
+}
 
 Storage::Storage() {
-  // nothing
+  memset(&_rec, 0, sizeof(_rec));
 }
 
-bool Storage::getWifiCreds(String &ssid, String &pass) {
-  prefs.begin("wifi", false);
-  ssid = prefs.getString("ssid", "");
-  pass = prefs.getString("pass", "");
+void Storage::open(const char* name, bool readOnly) {
+  ++_stats.opens;
+  prefs.begin(name, readOnly);
+}
+
+// Read a slot into _rec; true if it holds a complete record of this layout.
+// A slot that was written but fails the check is reported as damaged.
+bool Storage::readSlot(uint8_t slot) {
+  ++_stats.reads;
+  size_t len = prefs.getBytes(RECORD_SLOTS[slot], &_rec, sizeof(_rec));
+  if (len == 0) return false;
+  if (len == sizeof(_rec) && _rec.version == STORAGE_RECORD_VERSION &&
+      _rec.size == sizeof(_rec) && _rec.crc == recordCrc(_rec)) {
+    return true;
+  }
+  Serial.printf("[NVS] Record slot %c damaged or of another layout, ignored\n", 'A' + slot);
+  return false;
+}
+
+void Storage::ensureLoaded() {
+  if (_loaded) return;
+  _loaded = true;
+
+  open(RECORD_NAMESPACE, true);
+  bool validA = readSlot(0);
+  uint32_t seqA = _rec.sequence;
+  bool validB = readSlot(1);
+  if (validB && (!validA || (int32_t)(_rec.sequence - seqA) > 0)) {
+    _slot = 1;
+  } else if (validA) {
+    readSlot(0); // B was read over it
+    _slot = 0;
+  }
   prefs.end();
+
+  if (validA || validB) return;
+
+  memset(&_rec, 0, sizeof(_rec));
+  _slot = 1; // first write goes to slot A
+  if (migrateKeys()) {
+    flush();
+    if (_dirty) return; // keep the keys until the record is stored
+    // The keys would be migrated again after a clearAll(): remove them
+    for (const char* name : LEGACY_NAMESPACES) {
+      open(name, false);
+      ++_stats.writes;
+      prefs.clear();
+      prefs.end();
+    }
+    Serial.println("[NVS] Settings moved from the key layout to the device record");
+  }
+}
+
+// Fill _rec from the per-key layout; false if none of its keys exist
+bool Storage::migrateKeys() {
+  bool found = false;
+
+  // A namespace that was never written cannot be opened read-only
+  if (prefs.begin("wifi", true)) {
+    ++_stats.opens;
+    _stats.reads += 3;
+    found |= copyField(_rec.ssid, sizeof(_rec.ssid), prefs.getString("ssid", "")) && _rec.ssid[0];
+    copyField(_rec.pass, sizeof(_rec.pass), prefs.getString("pass", ""));
+    _rec.linkValid = prefs.getBytes("link", &_rec.link, sizeof(_rec.link)) == sizeof(_rec.link);
+    prefs.end();
+  }
+
+  if (prefs.begin("auth", true)) {
+    ++_stats.opens;
+    ++_stats.reads;
+    found |= copyField(_rec.token, sizeof(_rec.token), prefs.getString("token", "")) && _rec.token[0];
+    prefs.end();
+  }
+
+  if (prefs.begin("mqtt", true)) {
+    ++_stats.opens;
+    _stats.reads += 3;
+    if (!copyField(_rec.mqttServer, sizeof(_rec.mqttServer), prefs.getString("server", "")) ||
+        !copyField(_rec.mqttUsername, sizeof(_rec.mqttUsername), prefs.getString("username", "")) ||
+        !copyField(_rec.mqttPassword, sizeof(_rec.mqttPassword), prefs.getString("password", ""))) {
+      _rec.mqttServer[0] = _rec.mqttUsername[0] = _rec.mqttPassword[0] = '\0'; // fetched again
+    }
+    found |= _rec.mqttServer[0] != '\0';
+    prefs.end();
+  }
+
+  if (prefs.begin("config", true)) {
+    ++_stats.opens;
+    _stats.reads += 7;
+    if (prefs.isKey("base_url") &&
+        copyField(_rec.baseUrl, sizeof(_rec.baseUrl), prefs.getString("base_url", ""))) {
+      _rec.configKeys |= CONFIG_BASE_URL;
+    }
+    if (prefs.isKey("interval_ms")) {
+      _rec.readIntervalMs = prefs.getULong("interval_ms", 0);
+      _rec.configKeys |= CONFIG_INTERVAL;
+    }
+    if (prefs.isKey("mqtt_enabled")) {
+      _rec.mqttEnabled = prefs.getBool("mqtt_enabled", false);
+      _rec.configKeys |= CONFIG_MQTT_ENABLED;
+    }
+    if (prefs.isKey("upload_every")) {
+      _rec.uploadEveryCycles = prefs.getUChar("upload_every", 1);
+      _rec.configKeys |= CONFIG_UPLOAD_EVERY;
+    }
+    if (prefs.isKey("payload_enc")) {
+      _rec.payloadEncoding = prefs.getUChar("payload_enc", 0);
+      _rec.configKeys |= CONFIG_PAYLOAD_ENC;
+    }
+    if (prefs.isKey("always_on")) {
+      _rec.alwaysOn = prefs.getBool("always_on", false);
+      _rec.configKeys |= CONFIG_ALWAYS_ON;
+    }
+    if (prefs.isKey("sensor_mask")) {
+      _rec.sensorMask = prefs.getULong("sensor_mask", 0);
+      _rec.configKeys |= CONFIG_SENSOR_MASK;
+    }
+    found |= _rec.configKeys != 0;
+    prefs.end();
+  }
+
+  if (prefs.begin("lora", true)) {
+    ++_stats.opens;
+    ++_stats.reads;
+    _rec.loraFcnt = prefs.getULong("fcnt", 0);
+    found |= _rec.loraFcnt != 0;
+    prefs.end();
+  }
+
+  _dirty = found;
+  return found;
+}
+
+bool Storage::getWifiCreds(String &ssid, String &pass) {
+  ensureLoaded();
+  ssid = _rec.ssid;
+  pass = _rec.pass;
   return ssid.length() > 0;
 }
 
 void Storage::setWifiCreds(const String &ssid, const String &pass) {
-  prefs.begin("wifi", false);
-  String oldS = prefs.getString("ssid", "");
-  String oldP = prefs.getString("pass", "");
-  if (ssid != oldS || pass != oldP) {
-    prefs.putString("ssid", ssid);
-    prefs.putString("pass", pass);
+  ensureLoaded();
+  if (ssid == _rec.ssid && pass == _rec.pass) return;
+  if (ssid.length() >= sizeof(_rec.ssid) || pass.length() >= sizeof(_rec.pass)) {
+    Serial.println("WiFi credentials too long, not saved");
+    return;
   }
-  prefs.end();
+  copyField(_rec.ssid, sizeof(_rec.ssid), ssid);
+  copyField(_rec.pass, sizeof(_rec.pass), pass);
+  _dirty = true;
+}
+
+bool Storage::getWifiLink(WifiLink &link) {
+  ensureLoaded();
+  if (_rec.linkValid) link = _rec.link;
+  return _rec.linkValid;
+}
+
+void Storage::setWifiLink(const WifiLink &link) {
+  // Set after every full connect; only a changed link is written
+  ensureLoaded();
+  WifiLink stored = link;
+  stored.reserved = 0;
+  if (_rec.linkValid && memcmp(&_rec.link, &stored, sizeof(stored)) == 0) return;
+  _rec.link = stored;
+  _rec.linkValid = true;
+  _dirty = true;
+}
+
+void Storage::clearWifiLink() {
+  ensureLoaded();
+  if (!_rec.linkValid) return;
+  _rec.linkValid = false;
+  _dirty = true;
 }
 
 String Storage::getToken() {
-  prefs.begin("auth", false);
-  String t = prefs.getString("token", "");
-  prefs.end();
-  return t;
+  ensureLoaded();
+  return String(_rec.token);
+}
+
+bool Storage::hasToken() {
+  ensureLoaded();
+  return _rec.token[0] != '\0';
 }
 
 void Storage::setToken(const String &token) {
-  prefs.begin("auth", false);
-  String old = prefs.getString("token", "");
-  if (token != old) prefs.putString("token", token);
-  prefs.end();
+  ensureLoaded();
+  if (token == _rec.token) return;
+  if (!copyField(_rec.token, sizeof(_rec.token), token)) {
+    Serial.println("Auth token too long, not saved (AUTH_TOKEN_MAX_LEN)");
+    return;
+  }
+  _dirty = true;
 }
 
 bool Storage::getMqttCredentials(MqttCredentials &creds) {
-  prefs.begin("mqtt", false);
-  creds.server = prefs.getString("server", "");
-  creds.username = prefs.getString("username", "");
-  creds.password = prefs.getString("password", "");
-  prefs.end();
-  
-  creds.isValid = (creds.server.length() > 0 && 
-                   creds.username.length() > 0 && 
-                   creds.password.length() > 0);
+  ensureLoaded();
+  memcpy(creds.server, _rec.mqttServer, sizeof(creds.server));
+  memcpy(creds.username, _rec.mqttUsername, sizeof(creds.username));
+  memcpy(creds.password, _rec.mqttPassword, sizeof(creds.password));
+  creds.isValid = creds.server[0] && creds.username[0] && creds.password[0];
   return creds.isValid;
 }
 
-void Storage::setMqttCredentials(const String &server, const String &username, const String &password) {
-  prefs.begin("mqtt", false);
-  prefs.putString("server", server);
-  prefs.putString("username", username);
-  prefs.putString("password", password);
-  prefs.end();
+bool Storage::setMqttCredentials(const String &server, const String &username, const String &password) {
+  ensureLoaded();
+  if (server.length() >= sizeof(_rec.mqttServer) || username.length() >= sizeof(_rec.mqttUsername) ||
+      password.length() >= sizeof(_rec.mqttPassword)) {
+    Serial.println("MQTT credentials too long, not saved (MQTT_*_MAX_LEN)");
+    return false;
+  }
+  copyField(_rec.mqttServer, sizeof(_rec.mqttServer), server);
+  copyField(_rec.mqttUsername, sizeof(_rec.mqttUsername), username);
+  copyField(_rec.mqttPassword, sizeof(_rec.mqttPassword), password);
+  _dirty = true;
   Serial.println("MQTT credentials saved to storage");
+  return true;
 }
 
 void Storage::clearMqttCredentials() {
-  prefs.begin("mqtt", false);
-  prefs.clear();
-  prefs.end();
+  ensureLoaded();
+  memset(_rec.mqttServer, 0, sizeof(_rec.mqttServer));
+  memset(_rec.mqttUsername, 0, sizeof(_rec.mqttUsername));
+  memset(_rec.mqttPassword, 0, sizeof(_rec.mqttPassword));
+  _dirty = true;
   Serial.println("MQTT credentials cleared");
 }
 
 bool Storage::hasMqttCredentials() {
-  MqttCredentials creds;
-  return getMqttCredentials(creds);
+  ensureLoaded();
+  return _rec.mqttServer[0] && _rec.mqttUsername[0] && _rec.mqttPassword[0];
 }
 
 // ==================== Device Configuration (Config Struct Pattern) ====================
@@ -80,21 +280,21 @@ Storage* Storage::loadDefaults(const DeviceConfig& defaults) {
 
 void Storage::ensureConfigLoaded() {
   if (_configLoaded) return;
-  
-  prefs.begin("config", true); // read-only mode
-  
-  // Load all config values with defaults as fallback
-  _cache.baseUrl = prefs.getString("base_url", _defaults.baseUrl);
-  _cache.readIntervalMs = prefs.getULong("interval_ms", _defaults.readIntervalMs);
-  
-  // Handle mqttEnabled with isKey check for proper default
-  if (prefs.isKey("mqtt_enabled")) {
-    _cache.mqttEnabled = prefs.getBool("mqtt_enabled", _defaults.mqttEnabled);
-  } else {
-    _cache.mqttEnabled = _defaults.mqttEnabled;
-  }
-  
-  prefs.end();
+  ensureLoaded();
+
+  // Record values where set, defaults as fallback
+  const uint8_t keys = _rec.configKeys;
+  _cache.baseUrl = (keys & CONFIG_BASE_URL) ? String(_rec.baseUrl) : _defaults.baseUrl;
+  _cache.readIntervalMs = (keys & CONFIG_INTERVAL) ? _rec.readIntervalMs : _defaults.readIntervalMs;
+  _cache.mqttEnabled = (keys & CONFIG_MQTT_ENABLED) ? _rec.mqttEnabled != 0 : _defaults.mqttEnabled;
+  _cache.uploadEveryCycles = (keys & CONFIG_UPLOAD_EVERY) ? _rec.uploadEveryCycles : _defaults.uploadEveryCycles;
+  if (_cache.uploadEveryCycles == 0) _cache.uploadEveryCycles = 1;
+  _cache.payloadEncoding = (keys & CONFIG_PAYLOAD_ENC) ? (PayloadEncoding)_rec.payloadEncoding : _defaults.payloadEncoding;
+  _cache.alwaysOn = (keys & CONFIG_ALWAYS_ON) ? _rec.alwaysOn != 0 : _defaults.alwaysOn;
+  // Bits of sensors no longer in SENSOR_CONFIGS are ignored; none left means all
+  _cache.sensorMask = ((keys & CONFIG_SENSOR_MASK) ? _rec.sensorMask : _defaults.sensorMask) & SENSOR_MASK_ALL;
+  if (_cache.sensorMask == 0) _cache.sensorMask = SENSOR_MASK_ALL;
+
   _configLoaded = true;
 }
 
@@ -113,78 +313,182 @@ bool Storage::getMqttEnabled() {
   return _cache.mqttEnabled;
 }
 
+uint8_t Storage::getUploadEveryCycles() {
+  ensureConfigLoaded();
+  return _cache.uploadEveryCycles;
+}
+
+PayloadEncoding Storage::getPayloadEncoding() {
+  ensureConfigLoaded();
+  return _cache.payloadEncoding;
+}
+
+bool Storage::getAlwaysOn() {
+  ensureConfigLoaded();
+  return _cache.alwaysOn;
+}
+
+uint32_t Storage::getSensorMask() {
+  ensureConfigLoaded();
+  return _cache.sensorMask;
+}
+
+DeviceConfig Storage::getConfig() {
+  ensureConfigLoaded();
+  return _cache;
+}
+
 void Storage::saveConfig(const DeviceConfig& cfg) {
   ensureConfigLoaded(); // Ensure cache is populated
-  
-  prefs.begin("config", false);
-  
-  // Only write changed fields to prevent Flash wear
+
+  // Only changed fields are taken into the record
+  const uint8_t keysBefore = _rec.configKeys;
+  DeviceConfig next = cfg;
   if (cfg.baseUrl != _cache.baseUrl) {
-    prefs.putString("base_url", cfg.baseUrl);
+    if (copyField(_rec.baseUrl, sizeof(_rec.baseUrl), cfg.baseUrl)) {
+      _rec.configKeys |= CONFIG_BASE_URL;
+    } else {
+      Serial.println("Base URL too long, not saved (BASE_URL_MAX_LEN)");
+      next.baseUrl = _cache.baseUrl;
+    }
   }
-  
   if (cfg.readIntervalMs != _cache.readIntervalMs) {
-    prefs.putULong("interval_ms", cfg.readIntervalMs);
+    _rec.readIntervalMs = cfg.readIntervalMs;
+    _rec.configKeys |= CONFIG_INTERVAL;
   }
-  
   if (cfg.mqttEnabled != _cache.mqttEnabled) {
-    prefs.putBool("mqtt_enabled", cfg.mqttEnabled);
+    _rec.mqttEnabled = cfg.mqttEnabled;
+    _rec.configKeys |= CONFIG_MQTT_ENABLED;
   }
-  
-  prefs.end();
-  
+  if (cfg.uploadEveryCycles != _cache.uploadEveryCycles) {
+    _rec.uploadEveryCycles = cfg.uploadEveryCycles;
+    _rec.configKeys |= CONFIG_UPLOAD_EVERY;
+  }
+  if (cfg.payloadEncoding != _cache.payloadEncoding) {
+    _rec.payloadEncoding = (uint8_t)cfg.payloadEncoding;
+    _rec.configKeys |= CONFIG_PAYLOAD_ENC;
+  }
+  if (cfg.alwaysOn != _cache.alwaysOn) {
+    _rec.alwaysOn = cfg.alwaysOn;
+    _rec.configKeys |= CONFIG_ALWAYS_ON;
+  }
+  if (cfg.sensorMask != _cache.sensorMask) {
+    _rec.sensorMask = cfg.sensorMask;
+    _rec.configKeys |= CONFIG_SENSOR_MASK;
+  }
+
+  // Unchanged fields leave the record as it is
+  if (_rec.configKeys != keysBefore || next.baseUrl != _cache.baseUrl ||
+      next.readIntervalMs != _cache.readIntervalMs || next.mqttEnabled != _cache.mqttEnabled ||
+      next.uploadEveryCycles != _cache.uploadEveryCycles || next.payloadEncoding != _cache.payloadEncoding ||
+      next.alwaysOn != _cache.alwaysOn || next.sensorMask != _cache.sensorMask) {
+    _dirty = true;
+  }
+
   // Update cache to match new values
-  _cache = cfg;
+  _cache = next;
 }
 
 void Storage::setBaseUrl(const String &url) {
-  DeviceConfig cfg = _cache;
+  DeviceConfig cfg = getConfig();
   cfg.baseUrl = url;
   saveConfig(cfg);
 }
 
 void Storage::setReadIntervalMs(unsigned long ms) {
-  DeviceConfig cfg = _cache;
+  DeviceConfig cfg = getConfig();
   cfg.readIntervalMs = ms;
   saveConfig(cfg);
 }
 
 void Storage::setMqttEnabled(bool enabled) {
-  DeviceConfig cfg = _cache;
+  DeviceConfig cfg = getConfig();
   cfg.mqttEnabled = enabled;
   saveConfig(cfg);
 }
 
+void Storage::setUploadEveryCycles(uint8_t cycles) {
+  DeviceConfig cfg = getConfig();
+  cfg.uploadEveryCycles = cycles > 0 ? cycles : 1;
+  saveConfig(cfg);
+}
+
+void Storage::setPayloadEncoding(PayloadEncoding encoding) {
+  DeviceConfig cfg = getConfig();
+  cfg.payloadEncoding = encoding;
+  saveConfig(cfg);
+}
+
+void Storage::setAlwaysOn(bool enabled) {
+  DeviceConfig cfg = getConfig();
+  cfg.alwaysOn = enabled;
+  saveConfig(cfg);
+}
+
+void Storage::setSensorMask(uint32_t mask) {
+  DeviceConfig cfg = getConfig();
+  cfg.sensorMask = mask;
+  saveConfig(cfg);
+}
+
 uint32_t Storage::getLoraFcnt() {
-  prefs.begin("lora", true);
-  uint32_t fcnt = prefs.getULong("fcnt", 0);
-  prefs.end();
-  return fcnt;
+  ensureLoaded();
+  return _rec.loraFcnt;
 }
 
 void Storage::setLoraFcnt(uint32_t fcnt) {
-  prefs.begin("lora", false);
-  prefs.putULong("fcnt", fcnt);
+  ensureLoaded();
+  if (fcnt == _rec.loraFcnt) return;
+  _rec.loraFcnt = fcnt;
+  _dirty = true;
+}
+
+void Storage::flush() {
+  if (!_dirty) return;
+
+  // Into the other slot: until this write completes, the current one stays valid
+  const uint8_t slot = _slot ^ 1;
+  _rec.version = STORAGE_RECORD_VERSION;
+  _rec.size = sizeof(_rec);
+  _rec.sequence++;
+  _rec.crc = recordCrc(_rec);
+
+  open(RECORD_NAMESPACE, false);
+  ++_stats.writes;
+  bool ok = prefs.putBytes(RECORD_SLOTS[slot], &_rec, sizeof(_rec)) == sizeof(_rec);
   prefs.end();
+
+  if (!ok) {
+    Serial.println("[NVS] Record write failed");
+    return; // still dirty: retried by the next flush()
+  }
+  _slot = slot;
+  _dirty = false;
+}
+
+void Storage::printStats() const {
+  Serial.printf("[NVS] %u namespace opens, %u key reads, %u key writes\n",
+                (unsigned)_stats.opens, (unsigned)_stats.reads, (unsigned)_stats.writes);
 }
 
 void Storage::clearAll() {
-  prefs.begin("wifi", false);
-  prefs.clear();
-  prefs.end();
-  prefs.begin("auth", false);
-  prefs.clear();
-  prefs.end();
-  prefs.begin("mqtt", false);
+  // Both slots, and the per-key namespaces: a reset before the migration ran
+  // must not leave them to be migrated on the next boot
+  open(RECORD_NAMESPACE, false);
+  ++_stats.writes;
   prefs.clear();
   prefs.end();
-  prefs.begin("config", false);
-  prefs.clear();
-  prefs.end();
-  prefs.begin("lora", false);
-  prefs.clear();
-  prefs.end();
-  
+  for (const char* name : LEGACY_NAMESPACES) {
+    open(name, false);
+    ++_stats.writes;
+    prefs.clear();
+    prefs.end();
+  }
+
   // Invalidate cache since NVS was cleared
+  memset(&_rec, 0, sizeof(_rec));
+  _slot = 1;
+  _dirty = false;
+  _loaded = true; // nothing left to read
   _configLoaded = false;
 }
@@ -0,0 +1,345 @@
+#include "tls_client.h"
+#include "dns_cache.h"
+#include "config.h"
+#include "crc32.h"
+#include <errno.h>
+#include <string.h>
+#include <lwip/sockets.h>
+#include <mbedtls/version.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+
+struct TlsContext {
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    int fd;
+};
+
+// Serialized sessions (mbedtls_ssl_session_save) in RTC memory — survive deep
+// sleep, lost on power cycle. One slot per server (backend HTTPS, MQTT broker).
+struct TlsSessionSlot {
+    uint32_t key; // sessionKey(host, port), 0 = empty
+    uint16_t len;
+    uint8_t data[TLS_SESSION_MAX_SIZE];
+};
+RTC_DATA_ATTR static TlsSessionSlot rtcSessions[TLS_SESSION_CACHE_SLOTS];
+RTC_DATA_ATTR static uint8_t rtcNextSlot = 0;
+
+static_assert(sizeof(rtcSessions) <= 4096, "TLS session cache does not fit RTC memory; lower TLS_SESSION_MAX_SIZE");
+
+static TlsStats stats = {};
+
+static uint32_t sessionKey(const char* host, uint16_t port) {
+    const uint8_t portBytes[2] = { (uint8_t)(port >> 8), (uint8_t)port };
+    uint32_t key = crc32(portBytes, sizeof(portBytes), crc32((const uint8_t*)host, strlen(host)));
+    return key != 0 ? key : 1;
+}
+
+static TlsSessionSlot* findSession(uint32_t key) {
+    for (TlsSessionSlot& slot : rtcSessions) {
+        if (slot.key == key && slot.len > 0) return &slot;
+    }
+    return nullptr;
+}
+
+static void dropSession(uint32_t key) {
+    TlsSessionSlot* slot = findSession(key);
+    if (slot) slot->key = 0;
+}
+
+// Offer the cached session of this server, if any
+static bool offerSession(mbedtls_ssl_context* ssl, uint32_t key) {
+    TlsSessionSlot* slot = findSession(key);
+    if (!slot) return false;
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    bool ok = mbedtls_ssl_session_load(&session, slot->data, slot->len) == 0 &&
+              mbedtls_ssl_set_session(ssl, &session) == 0;
+    mbedtls_ssl_session_free(&session);
+    if (!ok) slot->key = 0; // saved by a different mbedtls build
+    return ok;
+}
+
+static void saveSession(const mbedtls_ssl_context* ssl, uint32_t key, const char* host) {
+    TlsSessionSlot* slot = findSession(key);
+    if (!slot) {
+        slot = &rtcSessions[rtcNextSlot];
+        rtcNextSlot = (uint8_t)((rtcNextSlot + 1) % TLS_SESSION_CACHE_SLOTS);
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    size_t len = 0;
+    int ret = mbedtls_ssl_get_session(ssl, &session);
+    if (ret == 0) ret = mbedtls_ssl_session_save(&session, slot->data, sizeof(slot->data), &len);
+    mbedtls_ssl_session_free(&session);
+
+    if (ret == 0) {
+        slot->key = key;
+        slot->len = (uint16_t)len;
+    } else {
+        slot->key = 0;
+        // Most likely the server certificate kept in the session
+        // (CONFIG_MBEDTLS_SSL_KEEP_PEER_CERTIFICATE) exceeds TLS_SESSION_MAX_SIZE
+        Serial.printf("[TLS] Session for %s not cached (-0x%04x, %u bytes needed)\n",
+                      host, (unsigned)-ret, (unsigned)len);
+    }
+}
+
+static int handshakeState(const mbedtls_ssl_context* ssl) {
+#if MBEDTLS_VERSION_MAJOR >= 3
+    return ssl->MBEDTLS_PRIVATE(state);
+#else
+    return ssl->state;
+#endif
+}
+
+// Socket I/O for mbedtls. Receives block in select() until data or timeout,
+// so the task sleeps while waiting on the server.
+static int bioSend(void* ctx, const unsigned char* buf, size_t len) {
+    int fd = *(int*)ctx;
+    int n = send(fd, buf, len, 0);
+    if (n >= 0) return n;
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+static int bioRecvTimeout(void* ctx, unsigned char* buf, size_t len, uint32_t timeoutMs) {
+    int fd = *(int*)ctx;
+    fd_set readFds;
+    FD_ZERO(&readFds);
+    FD_SET(fd, &readFds);
+    struct timeval tv = { (time_t)(timeoutMs / 1000), (suseconds_t)((timeoutMs % 1000) * 1000) };
+    int ready = select(fd + 1, &readFds, nullptr, nullptr, timeoutMs > 0 ? &tv : nullptr);
+    if (ready == 0) return MBEDTLS_ERR_SSL_TIMEOUT;
+    if (ready < 0) return MBEDTLS_ERR_NET_RECV_FAILED;
+
+    int n = recv(fd, buf, len, 0);
+    if (n == 0) return MBEDTLS_ERR_NET_CONN_RESET;
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_RECV_FAILED;
+    return n;
+}
+
+static void freeContext(TlsContext* ctx) {
+    mbedtls_ssl_free(&ctx->ssl);
+    mbedtls_ssl_config_free(&ctx->conf);
+    mbedtls_ctr_drbg_free(&ctx->drbg);
+    mbedtls_entropy_free(&ctx->entropy);
+    delete ctx;
+}
+
+TlsClient::TlsClient() : ctx_(nullptr), peeked_(-1) {}
+
+TlsClient::~TlsClient() {
+    stop();
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+    stop();
+    if (!WiFiClient::connect(ip, port)) return 0;
+    return handshake(ip.toString().c_str(), port) ? 1 : 0;
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+    stop();
+    if (!dnsConnect(*this, host, port)) return 0;
+    return handshake(host, port) ? 1 : 0;
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+    stop();
+    if (!WiFiClient::connect(ip, port, timeoutMs)) return 0;
+    return handshake(ip.toString().c_str(), port) ? 1 : 0;
+}
+
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+    stop();
+    if (!dnsConnect(*this, host, port, timeoutMs)) return 0;
+    return handshake(host, port) ? 1 : 0;
+}
+
+bool TlsClient::handshake(const char* host, uint16_t port) {
+    TlsContext* ctx = new (std::nothrow) TlsContext;
+    if (!ctx) {
+        WiFiClient::stop();
+        return false;
+    }
+    mbedtls_ssl_init(&ctx->ssl);
+    mbedtls_ssl_config_init(&ctx->conf);
+    mbedtls_ctr_drbg_init(&ctx->drbg);
+    mbedtls_entropy_init(&ctx->entropy);
+    ctx->fd = fd();
+
+    static const char PERSONALIZATION[] = "agronos-tls";
+    int ret = mbedtls_ctr_drbg_seed(&ctx->drbg, mbedtls_entropy_func, &ctx->entropy,
+                                    (const unsigned char*)PERSONALIZATION, sizeof(PERSONALIZATION) - 1);
+    if (ret == 0) ret = mbedtls_ssl_config_defaults(&ctx->conf, MBEDTLS_SSL_IS_CLIENT,
+                                                    MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret == 0) {
+        mbedtls_ssl_conf_authmode(&ctx->conf, MBEDTLS_SSL_VERIFY_NONE);
+        mbedtls_ssl_conf_rng(&ctx->conf, mbedtls_ctr_drbg_random, &ctx->drbg);
+        mbedtls_ssl_conf_read_timeout(&ctx->conf, TLS_HANDSHAKE_TIMEOUT_MS);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        mbedtls_ssl_conf_session_tickets(&ctx->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+        // TLS 1.3 delivers tickets after the handshake; the cache saves the
+        // session right after it, which works for TLS 1.2
+        mbedtls_ssl_conf_max_tls_version(&ctx->conf, MBEDTLS_SSL_VERSION_TLS1_2);
+#endif
+        ret = mbedtls_ssl_setup(&ctx->ssl, &ctx->conf);
+    }
+    if (ret == 0) ret = mbedtls_ssl_set_hostname(&ctx->ssl, host);
+    if (ret != 0) {
+        Serial.printf("[TLS] Setup failed: -0x%04x\n", (unsigned)-ret);
+        freeContext(ctx);
+        WiFiClient::stop();
+        return false;
+    }
+    mbedtls_ssl_set_bio(&ctx->ssl, &ctx->fd, bioSend, nullptr, bioRecvTimeout);
+
+    const uint32_t key = sessionKey(host, port);
+    const bool offered = offerSession(&ctx->ssl, key);
+
+    // Step through the handshake: a resumed one goes from ServerHello
+    // straight to ChangeCipherSpec without a server certificate
+    const unsigned long start = millis();
+    bool sawCertificate = false;
+    ret = 0;
+    while (handshakeState(&ctx->ssl) != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        if (handshakeState(&ctx->ssl) == MBEDTLS_SSL_SERVER_CERTIFICATE) sawCertificate = true;
+        ret = mbedtls_ssl_handshake_step(&ctx->ssl);
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            if (millis() - start > TLS_HANDSHAKE_TIMEOUT_MS) break;
+            continue;
+        }
+        if (ret != 0) break;
+    }
+    const unsigned long elapsed = millis() - start;
+
+    if (handshakeState(&ctx->ssl) != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        ++stats.failed;
+        Serial.printf("[TLS] Handshake with %s:%u failed after %lu ms: -0x%04x\n",
+                      host, (unsigned)port, elapsed, (unsigned)-ret);
+        if (offered) dropSession(key);
+        freeContext(ctx);
+        WiFiClient::stop();
+        return false;
+    }
+
+    const bool resumed = offered && !sawCertificate;
+    if (resumed) {
+        ++stats.resumed;
+        stats.resumedMs += elapsed;
+    } else {
+        ++stats.full;
+        stats.fullMs += elapsed;
+        saveSession(&ctx->ssl, key, host);
+    }
+    Serial.printf("[TLS] %s:%u %s handshake in %lu ms\n", host, (unsigned)port,
+                  resumed ? "resumed" : (offered ? "full (session not accepted)" : "full"), elapsed);
+
+    ctx_ = ctx;
+    peeked_ = -1;
+    return true;
+}
+
+size_t TlsClient::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size) {
+    if (!ctx_) return 0;
+    size_t written = 0;
+    while (written < size) {
+        int ret = mbedtls_ssl_write(&ctx_->ssl, buf + written, size - written);
+        if (ret > 0) {
+            written += (size_t)ret;
+        } else if (ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_WANT_READ) {
+            stop();
+            break;
+        }
+    }
+    return written;
+}
+
+int TlsClient::available() {
+    if (!ctx_) return 0;
+    int n = (int)mbedtls_ssl_get_bytes_avail(&ctx_->ssl);
+    if (n == 0) {
+        // Decrypt the next record only if its bytes have started to arrive;
+        // otherwise mbedtls would block for the read timeout
+        int pending = 0;
+        if (ioctl(ctx_->fd, FIONREAD, &pending) == 0 && pending > 0) {
+            int ret = mbedtls_ssl_read(&ctx_->ssl, nullptr, 0);
+            if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_TIMEOUT) {
+                stop();
+                return peeked_ >= 0 ? 1 : 0;
+            }
+            n = (int)mbedtls_ssl_get_bytes_avail(&ctx_->ssl);
+        }
+    }
+    return n + (peeked_ >= 0 ? 1 : 0);
+}
+
+int TlsClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int TlsClient::read(uint8_t* buf, size_t size) {
+    if (size == 0) return 0;
+    size_t n = 0;
+    if (peeked_ >= 0) {
+        buf[n++] = (uint8_t)peeked_;
+        peeked_ = -1;
+    }
+    // Non-blocking like WiFiClient: only what has already arrived
+    if (n < size && ctx_ && available() > 0) {
+        int ret = mbedtls_ssl_read(&ctx_->ssl, buf + n, size - n);
+        if (ret > 0) {
+            n += (size_t)ret;
+        } else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_TIMEOUT) {
+            stop(); // close notify or error
+        }
+    }
+    return n > 0 ? (int)n : -1;
+}
+
+int TlsClient::peek() {
+    if (peeked_ < 0) {
+        uint8_t c;
+        if (ctx_ && available() > 0 && mbedtls_ssl_read(&ctx_->ssl, &c, 1) == 1) peeked_ = c;
+    }
+    return peeked_;
+}
+
+void TlsClient::stop() {
+    if (ctx_) {
+        mbedtls_ssl_close_notify(&ctx_->ssl);
+        freeContext(ctx_);
+        ctx_ = nullptr;
+    }
+    peeked_ = -1;
+    WiFiClient::stop();
+}
+
+uint8_t TlsClient::connected() {
+    if (!ctx_) return peeked_ >= 0;
+    return WiFiClient::connected() || mbedtls_ssl_get_bytes_avail(&ctx_->ssl) > 0;
+}
+
+const TlsStats& tlsStats() {
+    return stats;
+}
+
+void tlsPrintStats() {
+    if (stats.full == 0 && stats.resumed == 0 && stats.failed == 0) return;
+    Serial.printf("[TLS] %u full handshakes (%lu ms), %u resumed (%lu ms), %u failed\n",
+                  (unsigned)stats.full, stats.fullMs, (unsigned)stats.resumed, stats.resumedMs,
+                  (unsigned)stats.failed);
+}
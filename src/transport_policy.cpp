@@ -0,0 +1,117 @@
+#include "transport_policy.h"
+#include "config.h"
+#include <Arduino.h>
+
+struct TransportState {
+    uint16_t successes;
+    uint16_t failures;
+    uint8_t failStreak;
+    bool demoted;
+    uint16_t reprobeInterval; // sends between probes while demoted
+    uint16_t sinceProbe;      // sends since demotion or the last probe
+    uint32_t avgMs;           // moving average of successful sends, 0 = not measured
+};
+
+// In RTC memory — survives deep sleep, lost on power cycle
+RTC_DATA_ATTR static TransportState rtcTransports[TRANSPORT_COUNT];
+
+static const char* TRANSPORT_NAMES[TRANSPORT_COUNT] = { "MQTT", "HTTP" };
+
+static_assert(TRANSPORT_DEMOTE_AFTER_FAILURES > 0, "TRANSPORT_DEMOTE_AFTER_FAILURES must be at least 1");
+static_assert(TRANSPORT_REPROBE_EVERY > 0 && TRANSPORT_REPROBE_EVERY <= TRANSPORT_REPROBE_MAX,
+              "TRANSPORT_REPROBE_EVERY must be between 1 and TRANSPORT_REPROBE_MAX");
+
+static TransportState& stateOf(Transport t) {
+    return rtcTransports[(size_t)t];
+}
+
+// Unmeasured first, then by average send time; ties keep the default order
+static bool fasterThan(Transport a, Transport b) {
+    const uint32_t msA = stateOf(a).avgMs;
+    const uint32_t msB = stateOf(b).avgMs;
+    if (msA == 0 || msB == 0) return msA == 0 && msB != 0;
+    return msA < msB;
+}
+
+size_t transportPlan(Transport order[TRANSPORT_COUNT]) {
+    size_t count = 0;
+
+    // A demoted transport due for a re-probe goes first: a success on the
+    // healthy one would otherwise end the send before the probe runs
+    for (size_t i = 0; i < TRANSPORT_COUNT; ++i) {
+        TransportState& s = rtcTransports[i];
+        if (!s.demoted) continue;
+        if (++s.sinceProbe >= s.reprobeInterval) {
+            s.sinceProbe = 0;
+            order[count++] = (Transport)i;
+            Serial.printf("[TRANSPORT] Re-probing %s\n", TRANSPORT_NAMES[i]);
+        }
+    }
+
+    const size_t probes = count;
+    for (size_t i = 0; i < TRANSPORT_COUNT; ++i) {
+        if (rtcTransports[i].demoted) continue;
+        // Insertion sort of the healthy transports by speed
+        size_t pos = count++;
+        while (pos > probes && fasterThan((Transport)i, order[pos - 1])) {
+            order[pos] = order[pos - 1];
+            --pos;
+        }
+        order[pos] = (Transport)i;
+    }
+
+    // Nothing healthy: try the demoted ones as well rather than not sending
+    if (count == probes) {
+        for (size_t i = 0; i < TRANSPORT_COUNT; ++i) {
+            bool planned = false;
+            for (size_t j = 0; j < probes; ++j) planned = planned || order[j] == (Transport)i;
+            if (!planned) order[count++] = (Transport)i;
+        }
+    }
+    return count;
+}
+
+void transportRecord(Transport t, bool success, uint32_t elapsedMs) {
+    TransportState& s = stateOf(t);
+    const char* name = TRANSPORT_NAMES[(size_t)t];
+
+    if (success) {
+        if (s.successes < UINT16_MAX) s.successes++;
+        if (elapsedMs == 0) elapsedMs = 1;
+        s.avgMs = s.avgMs == 0 ? elapsedMs : (3 * s.avgMs + elapsedMs) / 4;
+        if (s.demoted) Serial.printf("[TRANSPORT] %s recovered\n", name);
+        s.failStreak = 0;
+        s.demoted = false;
+        return;
+    }
+
+    if (s.failures < UINT16_MAX) s.failures++;
+    if (s.failStreak < UINT8_MAX) s.failStreak++;
+
+    if (s.demoted) {
+        // Failed probe: back off further
+        s.reprobeInterval = s.reprobeInterval >= TRANSPORT_REPROBE_MAX / 2
+            ? TRANSPORT_REPROBE_MAX
+            : s.reprobeInterval * 2;
+        s.sinceProbe = 0;
+        Serial.printf("[TRANSPORT] %s still failing, next probe in %u sends\n",
+                      name, (unsigned)s.reprobeInterval);
+    } else if (s.failStreak >= TRANSPORT_DEMOTE_AFTER_FAILURES) {
+        s.demoted = true;
+        s.reprobeInterval = TRANSPORT_REPROBE_EVERY;
+        s.sinceProbe = 0;
+        Serial.printf("[TRANSPORT] %s demoted after %u failures, next probe in %u sends\n",
+                      name, (unsigned)s.failStreak, (unsigned)s.reprobeInterval);
+    }
+}
+
+void transportPrintStats() {
+    for (size_t i = 0; i < TRANSPORT_COUNT; ++i) {
+        const TransportState& s = rtcTransports[i];
+        if (s.successes == 0 && s.failures == 0) continue;
+        Serial.printf("[TRANSPORT] %s: %u ok, %u failed (streak %u), avg %lu ms%s\n",
+                      TRANSPORT_NAMES[i], (unsigned)s.successes, (unsigned)s.failures,
+                      (unsigned)s.failStreak, (unsigned long)s.avgMs,
+                      s.demoted ? ", demoted" : "");
+    }
+}
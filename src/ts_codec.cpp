@@ -0,0 +1,251 @@
+#include "ts_codec.h"
+#include "crc32.h"
+#include <string.h>
+
+// MSB-first bit appender; stops writing and flags overflow at the end of the buffer
+struct BitWriter {
+    uint8_t* buf;
+    size_t size;
+    size_t bitPos;
+    bool overflow;
+};
+
+static void writeBits(BitWriter& w, uint32_t value, unsigned count) {
+    for (unsigned i = count; i-- > 0;) {
+        size_t byte = w.bitPos >> 3;
+        if (byte >= w.size) {
+            w.overflow = true;
+            return;
+        }
+        uint8_t mask = (uint8_t)(0x80 >> (w.bitPos & 7));
+        if ((value >> i) & 1) {
+            w.buf[byte] |= mask;
+        } else {
+            w.buf[byte] &= (uint8_t)~mask;
+        }
+        ++w.bitPos;
+    }
+}
+
+struct BitReader {
+    const uint8_t* buf;
+    size_t size;
+    size_t bitPos;
+    bool underflow;
+};
+
+static uint32_t readBits(BitReader& r, unsigned count) {
+    uint32_t value = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        size_t byte = r.bitPos >> 3;
+        if (byte >= r.size) {
+            r.underflow = true;
+            return 0;
+        }
+        value = (value << 1) | ((r.buf[byte] >> (7 - (r.bitPos & 7))) & 1);
+        ++r.bitPos;
+    }
+    return value;
+}
+
+static void putLe32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t getLe32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t floatBits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static float bitsFloat(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static unsigned leadingZeros(uint32_t v) {
+    unsigned n = 0;
+    for (uint32_t m = 0x80000000u; m && !(v & m); m >>= 1) ++n;
+    return n;
+}
+
+static unsigned trailingZeros(uint32_t v) {
+    unsigned n = 0;
+    for (uint32_t m = 1; m && !(v & m); m <<= 1) ++n;
+    return n;
+}
+
+// Sign-extend the low `bits` bits
+static int32_t signExtend(uint32_t v, unsigned bits) {
+    uint32_t sign = 1u << (bits - 1);
+    return (int32_t)((v ^ sign) - sign);
+}
+
+uint32_t tsSensorTableId(const char* const* uuids, size_t sensorCount) {
+    uint32_t crc = 0;
+    for (size_t i = 0; i < sensorCount; ++i) {
+        if (i > 0) crc = crc32("\n", 1, crc);
+        const char* uuid = uuids[i] ? uuids[i] : "";
+        crc = crc32(uuid, strlen(uuid), crc);
+    }
+    return crc;
+}
+
+static void encodeDeltaOfDelta(BitWriter& w, int32_t dod) {
+    if (dod == 0) {
+        writeBits(w, 0, 1);
+    } else if (dod >= -64 && dod <= 63) {
+        writeBits(w, 0b10, 2);
+        writeBits(w, (uint32_t)dod & 0x7F, 7);
+    } else if (dod >= -256 && dod <= 255) {
+        writeBits(w, 0b110, 3);
+        writeBits(w, (uint32_t)dod & 0x1FF, 9);
+    } else if (dod >= -2048 && dod <= 2047) {
+        writeBits(w, 0b1110, 4);
+        writeBits(w, (uint32_t)dod & 0xFFF, 12);
+    } else {
+        writeBits(w, 0b1111, 4);
+        writeBits(w, (uint32_t)dod, 32);
+    }
+}
+
+static int32_t decodeDeltaOfDelta(BitReader& r) {
+    if (readBits(r, 1) == 0) return 0;
+    if (readBits(r, 1) == 0) return signExtend(readBits(r, 7), 7);
+    if (readBits(r, 1) == 0) return signExtend(readBits(r, 9), 9);
+    if (readBits(r, 1) == 0) return signExtend(readBits(r, 12), 12);
+    return (int32_t)readBits(r, 32);
+}
+
+size_t encodeTimeSeries(bool nowKnown, uint32_t now, uint32_t sensorTableId,
+                        const uint32_t* timestamps, const float* values,
+                        size_t cycleCount, size_t sensorCount,
+                        uint8_t* out, size_t outSize) {
+    if (out == nullptr || outSize < TS_CODEC_HEADER_SIZE || cycleCount > 255 || sensorCount > 255) return 0;
+    if (cycleCount > 0 && (timestamps == nullptr || (values == nullptr && sensorCount > 0))) return 0;
+
+    out[0] = TS_CODEC_VERSION;
+    out[1] = nowKnown ? 1 : 0;
+    putLe32(out + 2, sensorTableId);
+    putLe32(out + 6, nowKnown ? now : 0);
+    out[10] = (uint8_t)sensorCount;
+    out[11] = (uint8_t)cycleCount;
+
+    BitWriter w = { out + TS_CODEC_HEADER_SIZE, outSize - TS_CODEC_HEADER_SIZE, 0, false };
+
+    // Timestamps: delta-of-delta against the previous interval (mod 2^32, so
+    // any sequence round-trips exactly)
+    uint32_t prevDelta = 0;
+    for (size_t c = 0; c < cycleCount; ++c) {
+        if (c == 0) {
+            writeBits(w, timestamps[0], 32);
+        } else if (c == 1) {
+            prevDelta = timestamps[1] - timestamps[0];
+            writeBits(w, prevDelta, 32);
+        } else {
+            uint32_t delta = timestamps[c] - timestamps[c - 1];
+            encodeDeltaOfDelta(w, (int32_t)(delta - prevDelta));
+            prevDelta = delta;
+        }
+    }
+
+    // Values: one XOR chain per sensor
+    for (size_t s = 0; cycleCount > 0 && s < sensorCount && !w.overflow; ++s) {
+        uint32_t prev = floatBits(values[s]);
+        writeBits(w, prev, 32);
+        unsigned prevLeading = 33; // no window yet
+        unsigned prevTrailing = 0;
+        for (size_t c = 1; c < cycleCount; ++c) {
+            uint32_t bits = floatBits(values[c * sensorCount + s]);
+            uint32_t x = bits ^ prev;
+            prev = bits;
+            if (x == 0) {
+                writeBits(w, 0, 1);
+                continue;
+            }
+            unsigned leading = leadingZeros(x); // x != 0, so at most 31: fits 5 bits
+            unsigned trailing = trailingZeros(x);
+            if (prevLeading <= 32 && leading >= prevLeading && trailing >= prevTrailing) {
+                // Meaningful bits fit in the previous window
+                writeBits(w, 0b10, 2);
+                writeBits(w, x >> prevTrailing, 32 - prevLeading - prevTrailing);
+            } else {
+                unsigned length = 32 - leading - trailing;
+                writeBits(w, 0b11, 2);
+                writeBits(w, leading, 5);
+                writeBits(w, length - 1, 5);
+                writeBits(w, x >> trailing, length);
+                prevLeading = leading;
+                prevTrailing = trailing;
+            }
+        }
+    }
+
+    if (w.overflow) return 0;
+    // Zero the padding bits of the last byte
+    if (w.bitPos & 7) writeBits(w, 0, 8 - (w.bitPos & 7));
+    return TS_CODEC_HEADER_SIZE + (w.bitPos >> 3);
+}
+
+bool decodeTimeSeries(const uint8_t* in, size_t len, TimeSeriesHeader& header,
+                      uint32_t* timestamps, float* values,
+                      size_t maxCycles, size_t maxSensors) {
+    if (in == nullptr || len < TS_CODEC_HEADER_SIZE || in[0] != TS_CODEC_VERSION) return false;
+
+    header.version = in[0];
+    header.nowKnown = (in[1] & 1) != 0;
+    header.sensorTableId = getLe32(in + 2);
+    header.now = getLe32(in + 6);
+    header.sensorCount = in[10];
+    header.cycleCount = in[11];
+    const size_t cycles = header.cycleCount;
+    const size_t sensors = header.sensorCount;
+    if (cycles > maxCycles || sensors > maxSensors) return false;
+    if (cycles > 0 && (timestamps == nullptr || (values == nullptr && sensors > 0))) return false;
+
+    BitReader r = { in + TS_CODEC_HEADER_SIZE, len - TS_CODEC_HEADER_SIZE, 0, false };
+
+    uint32_t prevDelta = 0;
+    for (size_t c = 0; c < cycles; ++c) {
+        if (c == 0) {
+            timestamps[0] = readBits(r, 32);
+        } else if (c == 1) {
+            prevDelta = readBits(r, 32);
+            timestamps[1] = timestamps[0] + prevDelta;
+        } else {
+            prevDelta += (uint32_t)decodeDeltaOfDelta(r);
+            timestamps[c] = timestamps[c - 1] + prevDelta;
+        }
+    }
+
+    for (size_t s = 0; cycles > 0 && s < sensors && !r.underflow; ++s) {
+        uint32_t prev = readBits(r, 32);
+        values[s] = bitsFloat(prev);
+        unsigned leading = 0;
+        unsigned trailing = 0;
+        bool window = false;
+        for (size_t c = 1; c < cycles && !r.underflow; ++c) {
+            if (readBits(r, 1) != 0) {
+                if (readBits(r, 1) == 0) {
+                    if (!window) return false; // reuse before any window was set
+                } else {
+                    leading = readBits(r, 5);
+                    unsigned length = readBits(r, 5) + 1;
+                    if (leading + length > 32) return false;
+                    trailing = 32 - leading - length;
+                    window = true;
+                }
+                uint32_t meaningful = readBits(r, 32 - leading - trailing);
+                prev ^= meaningful << trailing;
+            }
+            values[c * sensors + s] = bitsFloat(prev);
+        }
+    }
+
+    return !r.underflow;
+}
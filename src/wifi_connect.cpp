@@ -0,0 +1,100 @@
+#include "wifi_connect.h"
+#include "storage.h"
+#include "config.h"
+#include "crc32.h"
+#include "network_manager.h"
+#include <WiFi.h>
+#include <string.h>
+
+// Cached link in RTC memory — survives deep sleep, reloaded from NVS on cold boot
+RTC_DATA_ATTR static WifiLink rtcLink;
+RTC_DATA_ATTR static bool rtcLinkLoaded = false;
+RTC_DATA_ATTR static bool rtcLinkValid = false;
+RTC_DATA_ATTR static uint16_t rtcFastConnects = 0; // since the last DHCP lease
+
+// This wake's connection was made from the cache
+static bool connectedFromCache = false;
+
+static uint32_t ssidCrc(const String& ssid) {
+    return crc32((const uint8_t*)ssid.c_str(), ssid.length());
+}
+
+static bool cachedLinkFor(Storage& storage, const String& ssid) {
+    if (!rtcLinkLoaded) {
+        rtcLinkValid = storage.getWifiLink(rtcLink);
+        rtcLinkLoaded = true;
+    }
+    return rtcLinkValid && rtcLink.ssidCrc == ssidCrc(ssid) &&
+           rtcLink.channel > 0 && rtcLink.ip != 0;
+}
+
+static bool fastConnect(const String& ssid, const String& pass) {
+    WiFi.config(IPAddress(rtcLink.ip), IPAddress(rtcLink.gateway), IPAddress(rtcLink.subnet),
+                IPAddress(rtcLink.dns1), IPAddress(rtcLink.dns2));
+    networkManager().connecting();
+    WiFi.begin(ssid.c_str(), pass.c_str(), rtcLink.channel, rtcLink.bssid);
+    // A disconnect event (access point gone or moved) ends the wait right away
+    if (networkManager().waitOnline(WIFI_FAST_CONNECT_TIMEOUT_MS, true)) return true;
+
+    // Back to a scan + DHCP for the fallback connect
+    WiFi.disconnect();
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    return false;
+}
+
+// Remember the association and lease of a full connect
+static void saveLink(Storage& storage, const String& ssid) {
+    WifiLink link;
+    memset(&link, 0, sizeof(link)); // reserved too: NVS skips unchanged blobs by memcmp
+    link.ssidCrc = ssidCrc(ssid);
+    const uint8_t* bssid = WiFi.BSSID();
+    if (bssid) memcpy(link.bssid, bssid, sizeof(link.bssid));
+    link.channel = (uint8_t)WiFi.channel();
+    link.ip = (uint32_t)WiFi.localIP();
+    link.gateway = (uint32_t)WiFi.gatewayIP();
+    link.subnet = (uint32_t)WiFi.subnetMask();
+    link.dns1 = (uint32_t)WiFi.dnsIP(0);
+    link.dns2 = (uint32_t)WiFi.dnsIP(1);
+
+    rtcLink = link;
+    rtcLinkValid = bssid != nullptr && link.channel > 0 && link.ip != 0;
+    rtcLinkLoaded = true;
+    rtcFastConnects = 0;
+    if (rtcLinkValid) storage.setWifiLink(link);
+}
+
+bool wifiConnect(Storage& storage, const String& ssid, const String& pass) {
+    WiFi.persistent(false); // the SDK would otherwise rewrite its own flash copy on every begin()
+    WiFi.mode(WIFI_STA);
+    connectedFromCache = false;
+
+    unsigned long start = millis();
+    if (cachedLinkFor(storage, ssid) && rtcFastConnects < WIFI_LEASE_REFRESH_EVERY) {
+        if (fastConnect(ssid, pass)) {
+            rtcFastConnects++;
+            connectedFromCache = true;
+            Serial.printf("[WIFI] Fast connect (channel %u, cached IP) in %lu ms\n",
+                          (unsigned)rtcLink.channel, millis() - start);
+            return true;
+        }
+        Serial.println("[WIFI] Fast connect failed, scanning");
+    }
+
+    networkManager().connecting();
+    WiFi.begin(ssid.c_str(), pass.c_str());
+    // The driver retries on its own during the scan connect; wait for the IP
+    if (!networkManager().waitOnline(WIFI_CONNECT_TIMEOUT_MS)) return false;
+
+    Serial.printf("[WIFI] Connected with scan + DHCP in %lu ms\n", millis() - start);
+    saveLink(storage, ssid);
+    return true;
+}
+
+void wifiLinkFailed(Storage& storage) {
+    if (!connectedFromCache) return;
+    Serial.println("[WIFI] Cached link did not work, using scan + DHCP next time");
+    rtcLinkValid = false;
+    rtcLinkLoaded = true;
+    connectedFromCache = false;
+    storage.clearWifiLink();
+}
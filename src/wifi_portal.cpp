@@ -1,5 +1,7 @@
 #include "wifi_portal.h"
+#include "network_manager.h"
 #include <WiFi.h>
+#include "config.h"
 
 WifiPortal::WifiPortal(Storage &storage, const char* apSsid, const char* apPass, 
                        const char* deviceUuid, const char* deviceSecret, const SensorConfig* sensorConfigs, size_t sensorCount,
@@ -167,6 +169,29 @@ String WifiPortal::generateHtmlPage() {
   
   html += R"rawliteral(">
       
+      <label for="upload_every_cycles">Upload every N readings (1 = every reading):</label>
+      <input type="number" name="upload_every_cycles" id="upload_every_cycles" min="1" max=")rawliteral";
+  
+  // Pre-populate upload batching, bounded by the RTC batch capacity
+  html += String((unsigned)READING_BATCH_MAX_CYCLES);
+  html += R"rawliteral(" value=")rawliteral";
+  html += String(storage.getUploadEveryCycles());
+  
+  html += R"rawliteral(">
+      
+      <label for="payload_encoding">Upload format:</label>
+      <select name="payload_encoding" id="payload_encoding">
+        <option value="json")rawliteral";
+  if (storage.getPayloadEncoding() == PayloadEncoding::Json) html += " selected";
+  html += R"rawliteral(>JSON</option>
+        <option value="ts")rawliteral";
+  if (storage.getPayloadEncoding() == PayloadEncoding::TimeSeries) html += " selected";
+  html += R"rawliteral(>Compressed time series (batches)</option>
+        <option value="cbor")rawliteral";
+  if (storage.getPayloadEncoding() == PayloadEncoding::Cbor) html += " selected";
+  html += R"rawliteral(>CBOR</option>
+      </select>
+      
       <label>
         <input type="checkbox" name="mqtt_enabled" id="mqtt_enabled" value="on")rawliteral";
   
@@ -179,6 +204,34 @@ String WifiPortal::generateHtmlPage() {
         Enable MQTT protocol (uncheck to use HTTP only)
       </label>
       
+      <label>
+        <input type="checkbox" name="always_on" id="always_on" value="on")rawliteral";
+  
+  // Pre-populate always-on checkbox
+  if (storage.getAlwaysOn()) {
+    html += " checked";
+  }
+  
+  html += R"rawliteral(>
+        Always on (mains powered: keep MQTT connected and sample continuously)
+      </label>
+      
+      <p class="info">Sensors to read and upload:</p>)rawliteral";
+  
+  // One checkbox per SENSOR_CONFIGS entry (DeviceConfig::sensorMask)
+  uint32_t sensorMask = storage.getSensorMask();
+  for (size_t i = 0; sensorConfigs && i < sensorCount; ++i) {
+    html += "\n      <label><input type=\"checkbox\" name=\"sensor_";
+    html += String((unsigned)i);
+    html += "\" value=\"on\"";
+    if (sensorMask & (1u << i)) html += " checked";
+    html += "> ";
+    html += sensorConfigs[i].displayName;
+    html += "</label>";
+  }
+  
+  html += R"rawliteral(
+      
       <br><br>
       <input type="submit" value="Save & Connect">
     </form>
@@ -197,6 +250,9 @@ void WifiPortal::onSave() {
   String baseUrlArg = webServer.arg("base_url");
   String readIntervalArg = webServer.arg("read_interval_minutes");
   bool mqttEnabledArg = webServer.hasArg("mqtt_enabled");
+  String uploadEveryArg = webServer.arg("upload_every_cycles");
+  String payloadEncodingArg = webServer.arg("payload_encoding");
+  bool alwaysOnArg = webServer.hasArg("always_on");
   
   if (ssidArg.length() > 0) {
     // Save WiFi credentials
@@ -214,9 +270,37 @@ void WifiPortal::onSave() {
     }
     
     newConfig.mqttEnabled = mqttEnabledArg;
+
+    if (uploadEveryArg.length() > 0) {
+      long cycles = uploadEveryArg.toInt();
+      if (cycles < 1) cycles = 1;
+      if (cycles > (long)READING_BATCH_MAX_CYCLES) cycles = READING_BATCH_MAX_CYCLES;
+      newConfig.uploadEveryCycles = (uint8_t)cycles;
+    } else {
+      newConfig.uploadEveryCycles = storage.getUploadEveryCycles();
+    }
+
+    if (payloadEncodingArg == "ts") {
+      newConfig.payloadEncoding = PayloadEncoding::TimeSeries;
+    } else if (payloadEncodingArg == "cbor") {
+      newConfig.payloadEncoding = PayloadEncoding::Cbor;
+    } else if (payloadEncodingArg == "json") {
+      newConfig.payloadEncoding = PayloadEncoding::Json;
+    } else {
+      newConfig.payloadEncoding = storage.getPayloadEncoding();
+    }
+
+    newConfig.alwaysOn = alwaysOnArg;
+
+    newConfig.sensorMask = 0;
+    for (size_t i = 0; i < sensorCount; ++i) {
+      if (webServer.hasArg("sensor_" + String((unsigned)i))) newConfig.sensorMask |= 1u << i;
+    }
+    if (newConfig.sensorMask == 0) newConfig.sensorMask = SENSOR_MASK_ALL; // nothing ticked: keep reading all
     
     // Save all config in one atomic operation
     storage.saveConfig(newConfig);
+    storage.flush();
     
     webServer.send(200, "text/html", "<h3>Saved. Rebooting...</h3>");
     delay(5000);
@@ -275,7 +359,7 @@ void WifiPortal::handle() {
   dnsServer.processNextRequest();
   webServer.handleClient();
   // If the device becomes connected while portal is running, stop the portal
-  if (WiFi.status() == WL_CONNECTED) {
+  if (networkManager().online()) {
     Serial.println("WiFi connected while portal running — stopping portal");
     stop();
   }
@@ -0,0 +1,92 @@
+// DataSender transport fallback on the host shims (broker and HTTP server
+// answered in-process).
+
+#include <unity.h>
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <string>
+#include "data_sender.h"
+#include "json_payload.h"
+#include "mqtt_client.h"
+#include "network_manager.h"
+#include "reading_batch.h"
+#include "transport_policy.h"
+
+struct Broker : HostMqttBroker {
+    std::string topic;
+    std::string payload;
+    bool onConnect(const char*, const char*, const char*, bool) override { return true; }
+    bool onPublish(const char* t, const uint8_t* p, size_t len, bool) override {
+        topic = t;
+        payload.assign((const char*)p, len);
+        return true;
+    }
+};
+
+static Broker broker;
+static int httpRequests = 0;
+
+static int refuseUpload(const HostHttpRequest& req, String& response) {
+    (void)req;
+    ++httpRequests;
+    response = "{\"message\":\"unavailable\"}";
+    return 503;
+}
+
+void setUp(void) {
+    hostPreferencesReset();
+    hostSetMqttBroker(&broker);
+    hostSetHttpHandler(refuseUpload);
+    networkManager().begin();
+    WiFi.begin("ssid", "pass");
+}
+
+void tearDown(void) {}
+
+void test_mqtt_streams_json_batch_after_http_failed(void) {
+    // HTTP measured faster, so it is tried first
+    transportRecord(Transport::Mqtt, true, 5000);
+    transportRecord(Transport::Http, true, 10);
+    Transport order[TRANSPORT_COUNT];
+    TEST_ASSERT_EQUAL_size_t(2, transportPlan(order));
+    TEST_ASSERT_TRUE(order[0] == Transport::Http);
+
+    Storage storage;
+    storage.setToken("token");
+    storage.setMqttCredentials("broker", "user", "pass");
+    HttpSession http("http://backend.local");
+    DataSender sender(storage, http);
+    MqttClient mqtt(storage, "device");
+    sender.setMqttClient(&mqtt);
+
+    // A full batch, larger than an MQTT in-flight slot
+    static uint32_t timestamps[READING_BATCH_MAX_CYCLES];
+    static float values[READING_BATCH_MAX_CYCLES * SENSOR_CONFIG_COUNT];
+    for (size_t c = 0; c < READING_BATCH_MAX_CYCLES; ++c) {
+        timestamps[c] = 1700000000u + (uint32_t)c * 60u;
+        for (size_t s = 0; s < SENSOR_CONFIG_COUNT; ++s) {
+            values[c * SENSOR_CONFIG_COUNT + s] = 1234.56f + (float)(c * 10 + s);
+        }
+    }
+    const char* uuids[SENSOR_CONFIG_COUNT];
+    for (size_t i = 0; i < SENSOR_CONFIG_COUNT; ++i) uuids[i] = SENSOR_CONFIGS[i].uuid;
+    static char expected[DATA_PAYLOAD_MAX_SIZE];
+    const size_t expectedLen = serializeBatchJson(true, 1700001000u, uuids, SENSOR_CONFIG_COUNT, timestamps,
+                                                  values, READING_BATCH_MAX_CYCLES, expected, sizeof(expected));
+    TEST_ASSERT_TRUE(expectedLen > MQTT_INFLIGHT_MAX_PAYLOAD);
+
+    TEST_ASSERT_TRUE(sender.sendCycles(timestamps, values, READING_BATCH_MAX_CYCLES, true, 1700001000u));
+    TEST_ASSERT_EQUAL_INT(1, httpRequests);
+    TEST_ASSERT_EQUAL_size_t(expectedLen, broker.payload.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected, broker.payload.data(), expectedLen);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_mqtt_streams_json_batch_after_http_failed);
+    return UNITY_END();
+}
@@ -0,0 +1,118 @@
+// Host benchmark of the sensor payload encoder serializeReadingsJson() for
+// 1, 10 and 41 sensors. Reports heap allocations, bytes requested and encode
+// time per payload; run with `pio test -e native -f test_json_payload_bench -v`.
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include "data_sender.h"
+#include "json_payload.h"
+
+// ---- allocation counting (glibc: forward to the libc allocator) ----
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void __libc_free(void* p);
+}
+
+static bool counting = false;
+static size_t allocCount = 0;
+static size_t allocBytes = 0;
+
+extern "C" void* malloc(size_t size) {
+    if (counting) { ++allocCount; allocBytes += size; }
+    return __libc_malloc(size);
+}
+extern "C" void* calloc(size_t n, size_t size) {
+    if (counting) { ++allocCount; allocBytes += n * size; }
+    return __libc_calloc(n, size);
+}
+extern "C" void* realloc(void* p, size_t size) {
+    if (counting) { ++allocCount; allocBytes += size; }
+    return __libc_realloc(p, size);
+}
+extern "C" void free(void* p) { __libc_free(p); }
+#define ALLOC_COUNTING 1
+#else
+static bool counting = false;
+static size_t allocCount = 0;
+static size_t allocBytes = 0;
+#define ALLOC_COUNTING 0
+#endif
+
+static constexpr size_t MAX_SENSORS = 41;
+static constexpr int ITERATIONS = 20000;
+
+static char uuids[MAX_SENSORS][37];
+static SensorReading readings[MAX_SENSORS];
+static char fixedBuf[MAX_SENSORS * 80 + JSON_PAYLOAD_ENVELOPE];
+
+struct BenchResult {
+    size_t bytes;        // payload length
+    size_t allocs;       // heap allocations per payload
+    size_t allocBytes;   // bytes requested per payload
+    double ns;           // encode time per payload
+};
+
+template <typename Encode>
+static BenchResult bench(Encode encode) {
+    BenchResult res = {};
+    allocCount = allocBytes = 0;
+    counting = true;
+    res.bytes = encode();
+    counting = false;
+    res.allocs = allocCount;
+    res.allocBytes = allocBytes;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) encode();
+    auto end = std::chrono::steady_clock::now();
+    res.ns = std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+    return res;
+}
+
+static void report(const char* name, size_t sensors, const BenchResult& r) {
+    char line[128];
+    snprintf(line, sizeof(line), "%-5s %2u sensors: %5u B, %2u allocs, %5u B allocated, %8.0f ns",
+             name, (unsigned)sensors, (unsigned)r.bytes, (unsigned)r.allocs, (unsigned)r.allocBytes, r.ns);
+    TEST_MESSAGE(line);
+}
+
+static void benchSensors(size_t count) {
+    BenchResult fixed = bench([count]() {
+        return serializeReadingsJson(readings, count, fixedBuf, sizeof(fixedBuf));
+    });
+    report("fixed", count, fixed);
+
+    // Complete payload, and no heap use
+    TEST_ASSERT_GREATER_THAN(0, fixed.bytes);
+    TEST_ASSERT_EQUAL_size_t(strlen(fixedBuf), fixed.bytes);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(fixedBuf, "{\"sensors\":[", 12));
+    TEST_ASSERT_EQUAL_STRING("]}", fixedBuf + fixed.bytes - 2);
+    if (ALLOC_COUNTING) TEST_ASSERT_EQUAL_size_t(0, fixed.allocs);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_bench_1_sensor(void) { benchSensors(1); }
+void test_bench_10_sensors(void) { benchSensors(10); }
+void test_bench_41_sensors(void) { benchSensors(41); }
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    for (size_t i = 0; i < MAX_SENSORS; ++i) {
+        snprintf(uuids[i], sizeof(uuids[i]), "9c1f6a52-3d4e-4b7a-8e21-5f0c7d%06u", (unsigned)i);
+        readings[i] = {uuids[i], 18.0f + (float)i * 0.37f - (i % 3 == 0 ? 40.0f : 0.0f)};
+    }
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_1_sensor);
+    RUN_TEST(test_bench_10_sensors);
+    RUN_TEST(test_bench_41_sensors);
+    return UNITY_END();
+}
@@ -0,0 +1,259 @@
+// Smoke tests of the native environment: firmware modules running on the
+// host shims (Preferences in RAM, no board).
+
+#include <unity.h>
+#include <Arduino.h>
+#include <Preferences.h>
+#include "data_sender.h"
+#include "lora_payload.h"
+#include "sensor_scheduler.h"
+#include "signal_filter.h"
+#include "storage.h"
+
+static DeviceConfig defaults() {
+    DeviceConfig cfg;
+    cfg.baseUrl = "http://backend.local";
+    cfg.readIntervalMs = 30000;
+    cfg.mqttEnabled = true;
+    cfg.uploadEveryCycles = 1;
+    cfg.payloadEncoding = PayloadEncoding::Json;
+    cfg.alwaysOn = false;
+    cfg.sensorMask = SENSOR_MASK_ALL;
+    return cfg;
+}
+
+void setUp(void) {
+    hostPreferencesReset();
+}
+
+void tearDown(void) {}
+
+void test_lora_payload_layout(void) {
+    SensorReading readings[] = {{"a1b2c3", 21.5f}, {"xy", -3.25f}};
+    uint8_t buf[12];
+    TEST_ASSERT_EQUAL_size_t(12, serializeReadings(readings, 2, buf, sizeof(buf)));
+
+    const uint8_t expected[] = {'a', '1', 'b', '2', 0x66, 0x08,  // 2150
+                                'x', 'y', 0, 0, 0xBB, 0xFE};     // -325
+    TEST_ASSERT_EQUAL_MEMORY(expected, buf, sizeof(expected));
+}
+
+void test_lora_payload_rejects_small_buffer(void) {
+    SensorReading readings[] = {{"a1b2", 1.0f}};
+    uint8_t buf[5];
+    TEST_ASSERT_EQUAL_size_t(0, serializeReadings(readings, 1, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_size_t(0, serializeReadings(readings, 0, buf, sizeof(buf)));
+}
+
+void test_storage_defaults_without_record(void) {
+    Storage storage;
+    storage.loadDefaults(defaults());
+    TEST_ASSERT_EQUAL_UINT32(30000, storage.getReadIntervalMs());
+    TEST_ASSERT_TRUE(storage.getMqttEnabled());
+    TEST_ASSERT_FALSE(storage.hasToken());
+    TEST_ASSERT_FALSE(storage.hasMqttCredentials());
+    TEST_ASSERT_FALSE(storage.dirty());
+}
+
+void test_storage_round_trip(void) {
+    {
+        Storage storage;
+        storage.loadDefaults(defaults());
+        storage.setWifiCreds("greenhouse", "secret");
+        storage.setToken("token-1");
+        TEST_ASSERT_TRUE(storage.setMqttCredentials("broker.local", "device", "pw"));
+        storage.setReadIntervalMs(60000);
+        TEST_ASSERT_TRUE(storage.dirty());
+        storage.flush();
+        TEST_ASSERT_FALSE(storage.dirty());
+    }
+
+    Storage storage;
+    storage.loadDefaults(defaults());
+    String ssid, pass;
+    TEST_ASSERT_TRUE(storage.getWifiCreds(ssid, pass));
+    TEST_ASSERT_EQUAL_STRING("greenhouse", ssid.c_str());
+    TEST_ASSERT_EQUAL_STRING("secret", pass.c_str());
+    TEST_ASSERT_EQUAL_STRING("token-1", storage.getToken().c_str());
+    MqttCredentials creds;
+    TEST_ASSERT_TRUE(storage.getMqttCredentials(creds));
+    TEST_ASSERT_EQUAL_STRING("broker.local", creds.server);
+    TEST_ASSERT_EQUAL_UINT32(60000, storage.getReadIntervalMs());
+    TEST_ASSERT_EQUAL_UINT8(1, storage.getUploadEveryCycles()); // never set: still the default
+
+    // One namespace, both slots read, nothing written
+    TEST_ASSERT_EQUAL_UINT16(1, storage.stats().opens);
+    TEST_ASSERT_LESS_OR_EQUAL(3, storage.stats().reads);
+    TEST_ASSERT_EQUAL_UINT16(0, storage.stats().writes);
+}
+
+void test_storage_unflushed_change_is_not_stored(void) {
+    {
+        Storage storage;
+        storage.setToken("lost");
+    }
+    Storage storage;
+    TEST_ASSERT_FALSE(storage.hasToken());
+}
+
+void test_storage_falls_back_to_previous_record(void) {
+    {
+        Storage storage;
+        storage.setToken("first");
+        storage.flush();  // slot A
+        storage.setToken("second");
+        storage.flush();  // slot B
+    }
+    // A brown-out that cut the newest write short
+    Preferences prefs;
+    prefs.begin("device", false);
+    uint8_t torn[64] = {0};
+    prefs.putBytes("rec_b", torn, sizeof(torn));
+    prefs.end();
+
+    Storage storage;
+    TEST_ASSERT_EQUAL_STRING("first", storage.getToken().c_str());
+}
+
+void test_storage_migrates_key_layout(void) {
+    Preferences prefs;
+    prefs.begin("auth", false);
+    prefs.putString("token", "old-token");
+    prefs.end();
+    prefs.begin("config", false);
+    prefs.putULong("interval_ms", 90000);
+    prefs.end();
+
+    {
+        Storage storage;
+        storage.loadDefaults(defaults());
+        TEST_ASSERT_EQUAL_STRING("old-token", storage.getToken().c_str());
+        TEST_ASSERT_EQUAL_UINT32(90000, storage.getReadIntervalMs());
+        TEST_ASSERT_TRUE(storage.getMqttEnabled()); // not in the old keys: default
+    }
+
+    prefs.begin("auth", true);
+    TEST_ASSERT_FALSE(prefs.isKey("token"));
+    prefs.end();
+
+    Storage storage;
+    TEST_ASSERT_EQUAL_STRING("old-token", storage.getToken().c_str());
+}
+
+void test_storage_clear_all(void) {
+    {
+        Storage storage;
+        storage.setToken("token");
+        storage.flush();
+        storage.clearAll();
+        TEST_ASSERT_FALSE(storage.hasToken());
+    }
+    Storage storage;
+    TEST_ASSERT_FALSE(storage.hasToken());
+}
+
+void test_storage_clear_all_before_migration(void) {
+    // Factory reset on the first boot after an update, before the old keys were read
+    Preferences prefs;
+    prefs.begin("auth", false);
+    prefs.putString("token", "old-token");
+    prefs.end();
+    {
+        Storage storage;
+        storage.clearAll();
+    }
+    Storage storage;
+    TEST_ASSERT_FALSE(storage.hasToken());
+}
+
+void test_storage_wifi_link_reserved_byte_ignored(void) {
+    Storage storage;
+    WifiLink link = {};
+    link.channel = 6;
+    link.ip = 0x0A00000A;
+    storage.setWifiLink(link);
+    storage.flush();
+    const uint32_t writes = storage.stats().writes;
+
+    link.reserved = 0x5A; // not part of the link
+    storage.setWifiLink(link);
+    storage.flush();
+    TEST_ASSERT_EQUAL_UINT32(writes, storage.stats().writes);
+}
+
+// Single-channel part that tolerates one read per second, counting its reads
+class SlowSensor : public SensorBase {
+public:
+    int reads = 0;
+    unsigned long minReadIntervalMs() const override { return 1000; }
+    bool read(float& out) override {
+        out = 20.0f + reads++;
+        return true;
+    }
+};
+
+void test_scheduler_honours_min_read_interval(void) {
+    SlowSensor sensor;
+    sensor.bindChannel(0, "slow");
+    SensorDevice* devices[] = {&sensor};
+    SensorSample samples[1];
+
+    float values[4];
+    for (int cycle = 0; cycle < 4; ++cycle) {
+        AcquisitionReport report = acquireSensors(devices, 1, samples, 1);
+        TEST_ASSERT_EQUAL_size_t(1, report.okCount);
+        values[cycle] = samples[0].value;
+        hostAdvanceMillis(500);
+    }
+    // Read at 0 and 1000 ms; the cycles in between repeat the last value
+    TEST_ASSERT_EQUAL_INT(2, sensor.reads);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, values[0]);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, values[1]);
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, values[2]);
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, values[3]);
+}
+
+void test_filter_alpha_follows_elapsed_time(void) {
+    // Two samples 500 ms apart smooth like one sample 1000 ms after the first
+    SignalFilterState fast = {};
+    SignalFilterState slow = {};
+    float out = 0.0f;
+    TEST_ASSERT_TRUE(filterSample(fast, 0.0f, 200.0f, 2, 0.5f, 1000, 10000, out));
+    TEST_ASSERT_TRUE(filterSample(fast, 100.0f, 200.0f, 2, 0.5f, 1000, 10500, out));
+    TEST_ASSERT_TRUE(filterSample(fast, 100.0f, 200.0f, 2, 0.5f, 1000, 11000, out));
+    const float fastValue = out;
+    TEST_ASSERT_TRUE(filterSample(slow, 0.0f, 200.0f, 2, 0.5f, 1000, 10000, out));
+    TEST_ASSERT_TRUE(filterSample(slow, 100.0f, 200.0f, 2, 0.5f, 1000, 11000, out));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, out);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, out, fastValue);
+}
+
+void test_filter_rejects_outlier_until_confirmed(void) {
+    SignalFilterState state = {};
+    float out = 0.0f;
+    TEST_ASSERT_TRUE(filterSample(state, 40.0f, 15.0f, 2, 1.0f, 1000, 1000, out));
+    TEST_ASSERT_FALSE(filterSample(state, 90.0f, 15.0f, 2, 1.0f, 1000, 2000, out));
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, out);
+    TEST_ASSERT_TRUE(filterSample(state, 90.0f, 15.0f, 2, 1.0f, 1000, 3000, out));
+    TEST_ASSERT_EQUAL_FLOAT(90.0f, out);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_lora_payload_layout);
+    RUN_TEST(test_lora_payload_rejects_small_buffer);
+    RUN_TEST(test_storage_defaults_without_record);
+    RUN_TEST(test_storage_round_trip);
+    RUN_TEST(test_storage_unflushed_change_is_not_stored);
+    RUN_TEST(test_storage_falls_back_to_previous_record);
+    RUN_TEST(test_storage_migrates_key_layout);
+    RUN_TEST(test_storage_clear_all);
+    RUN_TEST(test_storage_clear_all_before_migration);
+    RUN_TEST(test_storage_wifi_link_reserved_byte_ignored);
+    RUN_TEST(test_scheduler_honours_min_read_interval);
+    RUN_TEST(test_filter_alpha_follows_elapsed_time);
+    RUN_TEST(test_filter_rejects_outlier_until_confirmed);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+// Round trips of the compressed time-series batch format (ts_codec.h):
+// encodeTimeSeries() on the device side, decodeTimeSeries() on the server side.
+
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include "ts_codec.h"
+
+static constexpr size_t MAX_CYCLES = 255;
+static constexpr size_t MAX_SENSORS = 255;
+
+static uint32_t timestamps[MAX_CYCLES];
+static float values[MAX_CYCLES * MAX_SENSORS];
+static uint8_t encoded[tsEncodedMaxSize(MAX_CYCLES, MAX_SENSORS)];
+static uint32_t decodedTs[MAX_CYCLES];
+static float decodedValues[MAX_CYCLES * MAX_SENSORS];
+
+// Encode, decode and compare bit-exact (NaN included); returns the encoded size
+static size_t roundTrip(bool nowKnown, uint32_t now, size_t cycles, size_t sensors) {
+    const uint32_t tableId = 0xA5C3E1F0u;
+    size_t len = encodeTimeSeries(nowKnown, now, tableId, timestamps, values, cycles, sensors,
+                                  encoded, sizeof(encoded));
+    TEST_ASSERT_GREATER_OR_EQUAL(TS_CODEC_HEADER_SIZE, len);
+    TEST_ASSERT_LESS_OR_EQUAL(tsEncodedMaxSize(cycles, sensors), len);
+
+    TimeSeriesHeader header;
+    memset(decodedTs, 0xEE, sizeof(decodedTs));
+    memset(decodedValues, 0xEE, sizeof(decodedValues));
+    TEST_ASSERT_TRUE(decodeTimeSeries(encoded, len, header, decodedTs, decodedValues, MAX_CYCLES, MAX_SENSORS));
+    TEST_ASSERT_EQUAL_UINT8(TS_CODEC_VERSION, header.version);
+    TEST_ASSERT_EQUAL(nowKnown, header.nowKnown);
+    TEST_ASSERT_EQUAL_UINT32(nowKnown ? now : 0, header.now);
+    TEST_ASSERT_EQUAL_HEX32(tableId, header.sensorTableId);
+    TEST_ASSERT_EQUAL_size_t(cycles, header.cycleCount);
+    TEST_ASSERT_EQUAL_size_t(sensors, header.sensorCount);
+    if (cycles > 0) {
+        TEST_ASSERT_EQUAL_MEMORY(timestamps, decodedTs, cycles * sizeof(uint32_t));
+        TEST_ASSERT_EQUAL_MEMORY(values, decodedValues, cycles * sensors * sizeof(float));
+    }
+    return len;
+}
+
+void setUp(void) {
+    memset(timestamps, 0, sizeof(timestamps));
+    memset(values, 0, sizeof(values));
+}
+
+void tearDown(void) {}
+
+void test_empty_batch(void) {
+    TEST_ASSERT_EQUAL_size_t(TS_CODEC_HEADER_SIZE, roundTrip(false, 0, 0, 3));
+    TEST_ASSERT_EQUAL_size_t(TS_CODEC_HEADER_SIZE, roundTrip(true, 1234, 0, 0));
+}
+
+void test_single_cycle(void) {
+    timestamps[0] = 1700000000u;
+    values[0] = 21.37f;
+    values[1] = -4.5f;
+    values[2] = 0.0f;
+    // 32-bit timestamp + one 32-bit value per sensor
+    TEST_ASSERT_EQUAL_size_t(TS_CODEC_HEADER_SIZE + 16, roundTrip(true, 1700000030u, 1, 3));
+}
+
+void test_regular_series_compresses(void) {
+    const size_t cycles = 60, sensors = 4;
+    for (size_t c = 0; c < cycles; ++c) {
+        timestamps[c] = 5000 + (uint32_t)c * 300;  // fixed interval: 1 bit each
+        values[c * sensors + 0] = 22.5f;           // constant: 1 bit each
+        values[c * sensors + 1] = 55.0f + (float)(c % 3);
+        values[c * sensors + 2] = roundf((10.0f + c * 0.01f) * 100.0f) / 100.0f;
+        values[c * sensors + 3] = 1013.25f;
+    }
+    size_t len = roundTrip(true, 5000 + cycles * 300, cycles, sensors);
+    // Raw: 4 bytes per timestamp and per value
+    TEST_ASSERT_LESS_THAN(cycles * (1 + sensors) * 4 / 3, len);
+}
+
+void test_missing_channels_round_trip_as_nan(void) {
+    const size_t cycles = 5, sensors = 3;
+    const float nan = NAN;
+    for (size_t c = 0; c < cycles; ++c) {
+        timestamps[c] = 100 + (uint32_t)c * 60;
+        values[c * sensors + 0] = 20.0f + c;
+        values[c * sensors + 1] = (c % 2) ? nan : 40.0f; // intermittent failures
+        values[c * sensors + 2] = nan;                   // sensor never read
+    }
+    roundTrip(false, 0, cycles, sensors);
+    TEST_ASSERT_TRUE(isnan(decodedValues[1 * sensors + 1]));
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, decodedValues[2 * sensors + 1]);
+    for (size_t c = 0; c < cycles; ++c) TEST_ASSERT_TRUE(isnan(decodedValues[c * sensors + 2]));
+}
+
+void test_timestamp_counter_wrap(void) {
+    // The device clock wraps 2^32 in the middle of the batch, and the
+    // interval jumps in both directions (largest delta-of-delta escapes)
+    const uint32_t start = 0xFFFFFFA0u;
+    const uint32_t steps[] = {60, 60, 61, 59, 200, 5000, 60, 0xFFFF0000u, 60, 60};
+    const size_t cycles = sizeof(steps) / sizeof(steps[0]) + 1;
+    timestamps[0] = start;
+    for (size_t c = 1; c < cycles; ++c) timestamps[c] = timestamps[c - 1] + steps[c - 1];
+    for (size_t c = 0; c < cycles; ++c) values[c] = (float)c;
+    TEST_ASSERT_TRUE(timestamps[2] < timestamps[0]); // wrapped
+    roundTrip(true, timestamps[cycles - 1], cycles, 1);
+}
+
+void test_maximum_batch(void) {
+    uint32_t seed = 12345;
+    for (size_t c = 0; c < MAX_CYCLES; ++c) {
+        seed = seed * 1103515245u + 12345u;
+        timestamps[c] = 1000 + (uint32_t)c * 600 + (seed >> 28); // jitter
+        for (size_t s = 0; s < MAX_SENSORS; ++s) {
+            seed = seed * 1103515245u + 12345u;
+            uint32_t bits = seed; // arbitrary bit patterns: worst case for the XOR chain
+            memcpy(&values[c * MAX_SENSORS + s], &bits, sizeof(bits));
+        }
+    }
+    roundTrip(true, 0xFFFFFFFFu, MAX_CYCLES, MAX_SENSORS);
+
+    // One cycle or one sensor more is refused, not truncated
+    TEST_ASSERT_EQUAL_size_t(0, encodeTimeSeries(true, 0, 0, timestamps, values, MAX_CYCLES + 1, 1,
+                                                 encoded, sizeof(encoded)));
+    TEST_ASSERT_EQUAL_size_t(0, encodeTimeSeries(true, 0, 0, timestamps, values, 1, MAX_SENSORS + 1,
+                                                 encoded, sizeof(encoded)));
+}
+
+void test_small_buffer_and_truncated_input_fail(void) {
+    const size_t cycles = 10, sensors = 2;
+    for (size_t c = 0; c < cycles; ++c) {
+        timestamps[c] = (uint32_t)c * 17;
+        values[c * sensors] = c * 1.5f;
+        values[c * sensors + 1] = -c * 2.25f;
+    }
+    size_t len = roundTrip(false, 0, cycles, sensors);
+    TEST_ASSERT_EQUAL_size_t(0, encodeTimeSeries(false, 0, 0, timestamps, values, cycles, sensors,
+                                                 encoded, len - 1));
+
+    encodeTimeSeries(false, 0, 0, timestamps, values, cycles, sensors, encoded, sizeof(encoded));
+    TimeSeriesHeader header;
+    TEST_ASSERT_FALSE(decodeTimeSeries(encoded, len - 2, header, decodedTs, decodedValues, MAX_CYCLES, MAX_SENSORS));
+    TEST_ASSERT_FALSE(decodeTimeSeries(encoded, len, header, decodedTs, decodedValues, cycles - 1, sensors));
+}
+
+void test_sensor_table_id(void) {
+    const char* a[] = {"uuid-1", "uuid-2"};
+    const char* b[] = {"uuid-2", "uuid-1"};
+    const char* joined[] = {"uuid-1\nuuid-2"};
+    TEST_ASSERT_NOT_EQUAL(tsSensorTableId(a, 2), tsSensorTableId(b, 2));
+    TEST_ASSERT_EQUAL_HEX32(tsSensorTableId(joined, 1), tsSensorTableId(a, 2));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_batch);
+    RUN_TEST(test_single_cycle);
+    RUN_TEST(test_regular_series_compresses);
+    RUN_TEST(test_missing_channels_round_trip_as_nan);
+    RUN_TEST(test_timestamp_counter_wrap);
+    RUN_TEST(test_maximum_batch);
+    RUN_TEST(test_small_buffer_and_truncated_input_fail);
+    RUN_TEST(test_sensor_table_id);
+    return UNITY_END();
+}